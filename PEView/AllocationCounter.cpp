@@ -0,0 +1,33 @@
+#include "AllocationCounter.h"
+
+#ifdef PEVIEW_COUNT_ALLOCATIONS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> allocations{ 0 };
+
+size_t AllocationCount()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+#endif
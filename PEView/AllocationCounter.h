@@ -0,0 +1,8 @@
+#pragma once
+#include <cstddef>
+
+// the Bench configuration defines PEVIEW_COUNT_ALLOCATIONS and replaces global operator new
+// to count heap allocations for -bench, every other build keeps the default allocator
+#ifdef PEVIEW_COUNT_ALLOCATIONS
+size_t AllocationCount();
+#endif
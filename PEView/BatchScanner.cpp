@@ -0,0 +1,450 @@
+#include "BatchScanner.h"
+#include "PEFile.h"
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+
+void WorkQueue::push(BatchTask&& task)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	m_tasks.push_back(std::move(task));
+}
+
+bool WorkQueue::pop(BatchTask& task)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	if (m_tasks.empty())
+		return false;
+	task = std::move(m_tasks.front());
+	m_tasks.pop_front();
+	return true;
+}
+
+bool WorkQueue::steal(BatchTask& task)
+{
+	std::lock_guard<std::mutex> guard(m_lock);
+	if (m_tasks.empty())
+		return false;
+	task = std::move(m_tasks.back());
+	m_tasks.pop_back();
+	return true;
+}
+
+static unsigned int threadCount(unsigned int requested)
+{
+	if (requested)
+		return requested;
+	unsigned int n = std::thread::hardware_concurrency();
+	return n ? n : 1;
+}
+
+BatchScanner::BatchScanner(const BatchOptions& options)
+	: m_options(options), m_queues(threadCount(options.threads))
+{
+	if (!m_options.cacheDir.empty())
+		m_cache.reset(new ParseCache(m_options.cacheDir, m_options.cacheLimit, m_options.cacheContent));
+}
+
+int BatchScanner::Run()
+{
+	if (!m_options.rules.empty() && !m_signatures.load(m_options.rules))
+	{
+		fprintf(stderr, "%s\n", m_signatures.error().c_str());
+		return 1;
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < m_queues.size(); ++i)
+		workers.emplace_back(&BatchScanner::worker, this, i);
+
+	walk();
+	m_walking = false;
+	m_wake.notify_all();
+
+	for (auto& t : workers)
+		t.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	if (seconds <= 0)
+		seconds = 1e-9;
+	double mb = m_bytes / (1024.0 * 1024.0);
+
+	fflush(stdout);
+	fprintf(stderr, "%llu files (%llu failed), %.1f MB in %.2f s : %.0f files/s, %.1f MB/s, threads : %u\n",
+		(unsigned long long)m_files.load(), (unsigned long long)m_failed.load(), mb, seconds,
+		m_files / seconds, mb / seconds, (unsigned int)m_queues.size());
+	if (m_cache)
+		fprintf(stderr, "cache : %llu hits, %llu misses\n",
+			(unsigned long long)m_cache->Hits(), (unsigned long long)m_cache->Misses());
+	if (!m_options.rules.empty())
+		fprintf(stderr, "signatures : %zu rules, %llu files matched\n", m_signatures.size(), (unsigned long long)m_matched.load());
+	if (!m_options.symbolIndex.empty())
+	{
+		if (m_symbols.write(m_options.symbolIndex))
+			fprintf(stderr, "symbols : %zu files with a PDB in %s\n", m_symbols.size(), m_options.symbolIndex.c_str());
+		else
+			fprintf(stderr, "%s : cannot write the symbol index\n", m_options.symbolIndex.c_str());
+	}
+
+	return m_failed ? 1 : 0;
+}
+
+void BatchScanner::walk()
+{
+	for (const auto& root : m_options.roots)
+		walkRoot(root);
+
+	// a corpus too large to pass as arguments, the workers start on the first lines right away
+	if (m_options.list.empty())
+		return;
+
+	std::ifstream file;
+	if (m_options.list != "-")
+	{
+		file.open(m_options.list);
+		if (!file.is_open())
+		{
+			fprintf(stderr, "%s : cannot open the list\n", m_options.list.c_str());
+			return;
+		}
+	}
+	std::istream& in = m_options.list == "-" ? std::cin : file;
+
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (!line.empty())
+			walkRoot(line);
+	}
+}
+
+void BatchScanner::walkRoot(const std::string& root)
+{
+	namespace fs = std::filesystem;
+
+	std::error_code ec;
+	if (fs::is_regular_file(root, ec))
+	{
+		enqueue({ root, (ULONGLONG)fs::file_size(root, ec) });
+		return;
+	}
+
+	fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec), end;
+	if (ec)
+	{
+		fprintf(stderr, "%s : %s\n", root.c_str(), ec.message().c_str());
+		return;
+	}
+
+	for (; it != end; it.increment(ec))
+	{
+		if (ec)
+			break;
+		if (!it->is_regular_file(ec))
+			continue;
+
+		BatchTask task;
+		try {
+			task.path = it->path().string();
+		}
+		catch (...) {
+			continue;	// not representable in the ANSI code page
+		}
+		task.size = it->file_size(ec);
+
+		enqueue(std::move(task));
+	}
+}
+
+void BatchScanner::enqueue(BatchTask&& task)
+{
+	m_pending++;
+	m_queues[m_next++ % m_queues.size()].push(std::move(task));
+	m_wake.notify_one();
+}
+
+bool BatchScanner::nextTask(unsigned int id, BatchTask& task)
+{
+	if (m_queues[id].pop(task))
+		return true;
+
+	for (size_t i = 1; i < m_queues.size(); ++i)
+	{
+		if (m_queues[(id + i) % m_queues.size()].steal(task))
+			return true;
+	}
+	return false;
+}
+
+void BatchScanner::worker(unsigned int id)
+{
+	std::string record;
+	OutputSink json(nullptr, 1 << 16);
+	BatchTask task;
+	while (true)
+	{
+		if (nextTask(id, task))
+		{
+			if (m_options.json)
+			{
+				json.clear();
+				scanJson(task, json);
+				emit(json.view());
+			}
+			else
+			{
+				record.clear();
+				scanFile(task, record);
+				emit(record);
+			}
+			m_pending--;
+			continue;
+		}
+
+		if (!m_walking && m_pending == 0)
+			break;
+
+		// nothing to steal yet, wait for the walker instead of spinning
+		std::unique_lock<std::mutex> lock(m_wakeLock);
+		m_wake.wait_for(lock, std::chrono::milliseconds(1));
+	}
+}
+
+// MD5, SHA-1 and SHA-256 as three more columns
+static void appendDigests(std::string& record, const DigestSet& digests)
+{
+	char text[Sha256::digestSize * 2 + 1];
+	FileHasher::format(text, digests.md5, sizeof(digests.md5));
+	record += '\t';
+	record += text;
+	FileHasher::format(text, digests.sha1, sizeof(digests.sha1));
+	record += '\t';
+	record += text;
+	FileHasher::format(text, digests.sha256, sizeof(digests.sha256));
+	record += '\t';
+	record += text;
+}
+
+void BatchScanner::scanFile(const BatchTask& task, std::string& record)
+{
+	PEFile pe(task.path, false, m_cache.get());
+
+	m_files++;
+	m_bytes += task.size;
+
+	char text[128];
+	record += task.path;
+	if (!pe.loaded)
+	{
+		m_failed++;
+		record += "\tFAIL\t";
+		record += pe.GetError();
+		record += '\n';
+		return;
+	}
+
+	indexSymbols(pe, task);
+
+	snprintf(text, sizeof(text), "\tOK\t%04X\t%s\t%llu\t%zu",
+		pe.GetMachine(), pe.IsX86() ? "PE32" : "PE32+", (unsigned long long)task.size, pe.GetSectionHeaders().size());
+	record += text;
+
+	if (m_options.headersOnly)
+		record += "\t-\t-\t-\t-\t-";
+	else
+	{
+		snprintf(text, sizeof(text), "\t%zu\t%zu\t%zu\t%zu\t%zu",
+			pe.GetImportDescriptors().size(), pe.GetImportCount(), pe.GetExportTable().size(),
+			pe.GetDelayImportDescriptors().size(), pe.GetDelayImportCount());
+		record += text;
+	}
+
+	// the workers already keep every core busy, one file is hashed on one thread
+	if (m_options.hash)
+	{
+		if (pe.Hash(false))
+			appendDigests(record, pe.GetFileDigest());
+		else
+			record += "\t-\t-\t-";
+	}
+	if (m_options.authenticode)
+	{
+		if (pe.HashAuthenticode(false))
+			appendDigests(record, pe.GetAuthenticodeDigest());
+		else
+			record += "\t-\t-\t-";
+	}
+	// the TSV record only counts them, the strings themselves go to the JSON output
+	if (m_options.strings)
+	{
+		if (pe.ScanStrings(m_options.strings, false))
+		{
+			size_t wide = std::count_if(pe.GetStrings().begin(), pe.GetStrings().end(), [](const StringHit& hit) { return hit.wide; });
+			snprintf(text, sizeof(text), "\t%zu\t%zu", pe.GetStrings().size() - wide, wide);
+			record += text;
+		}
+		else
+			record += "\t-\t-";
+	}
+	// match count and the rules that matched, each once
+	if (!m_options.rules.empty())
+	{
+		if (pe.MatchSignatures(m_signatures))
+		{
+			const auto& matches = pe.GetSignatureMatches();
+			snprintf(text, sizeof(text), "\t%zu\t", matches.size());
+			record += text;
+
+			std::vector<DWORD> rules;
+			for (const SignatureMatch& match : matches)
+			{
+				if (std::find(rules.begin(), rules.end(), match.rule) == rules.end())
+					rules.push_back(match.rule);
+			}
+			for (size_t i = 0; i < rules.size(); ++i)
+			{
+				if (i)
+					record += ',';
+				record += m_signatures.rule(rules[i]).name;
+			}
+			if (rules.empty())
+				record += '-';
+			else
+				m_matched++;
+		}
+		else
+			record += "\t-\t-";
+	}
+	// key, checksum, the linker's toolset and build, then product.build.count of every entry
+	if (m_options.rich)
+	{
+		const RichHeader& rich = pe.GetRichHeader();
+		if (rich.present())
+		{
+			size_t linker = rich.linker();
+			if (linker != RichHeader::npos)
+			{
+				const RichEntry& entry = rich.entries()[linker];
+				snprintf(text, sizeof(text), "\t%08X\t%s\t%s\t%u\t", rich.key(), rich.valid() ? "valid" : "invalid",
+					RichHeader::Toolset(entry.product, entry.build), entry.build);
+			}
+			else
+				snprintf(text, sizeof(text), "\t%08X\t%s\t-\t-\t", rich.key(), rich.valid() ? "valid" : "invalid");
+			record += text;
+
+			for (size_t i = 0; i < rich.entries().size(); ++i)
+			{
+				const RichEntry& entry = rich.entries()[i];
+				snprintf(text, sizeof(text), "%s%04X.%u.%u", i ? "," : "", entry.product, entry.build, entry.count);
+				record += text;
+			}
+			if (rich.entries().empty())
+				record += '-';
+		}
+		else
+			record += "\t-\t-\t-\t-\t-";
+	}
+	// computed from the tables already parsed, '-' when there is nothing to hash
+	if (m_options.fingerprint)
+	{
+		const FingerprintSet& fingerprint = pe.GetFingerprint();
+		auto append = [&](bool present, const BYTE* digest) {
+			record += '\t';
+			if (!present)
+			{
+				record += '-';
+				return;
+			}
+			FileHasher::format(text, digest, Md5::digestSize);
+			record += text;
+		};
+		append(fingerprint.hasImports, fingerprint.imphash);
+		append(fingerprint.hasRich, fingerprint.rich);
+		append(fingerprint.hasExports, fingerprint.exports);
+	}
+	// where the payload of an installer or a self-extractor starts and what it is
+	if (m_options.overlay)
+	{
+		if (pe.ScanOverlay())
+		{
+			const OverlayInfo& overlay = pe.GetOverlay();
+			const OverlayScanner& scan = pe.GetOverlayScan();
+			OverlayScanner::Format format = scan.first();
+			if (overlay.size)
+				snprintf(text, sizeof(text), "\t%llu\t%llu\t%.4f\t", (unsigned long long)overlay.offset, (unsigned long long)overlay.size, scan.entropy());
+			else
+				snprintf(text, sizeof(text), "\t%llu\t0\t-\t", (unsigned long long)overlay.offset);
+			record += text;
+			if (format != OverlayScanner::formatCount)
+			{
+				snprintf(text, sizeof(text), "%s@%llu", OverlayScanner::FormatName(format), (unsigned long long)scan.find(format));
+				record += text;
+			}
+			else
+				record += '-';
+		}
+		else
+			record += "\t-\t-\t-\t-";
+	}
+	record += '\n';
+}
+
+void BatchScanner::scanJson(const BatchTask& task, OutputSink& out)
+{
+	PEFile pe(task.path, false, m_cache.get());
+
+	m_files++;
+	m_bytes += task.size;
+
+	JsonWriter json(out);
+	if (pe.loaded)
+	{
+		indexSymbols(pe, task);
+		if (m_options.hash)
+			pe.Hash(false);
+		if (m_options.authenticode)
+			pe.HashAuthenticode(false);
+		if (m_options.strings)
+			pe.ScanStrings(m_options.strings, false);
+		if (!m_options.rules.empty() && pe.MatchSignatures(m_signatures) && !pe.GetSignatureMatches().empty())
+			m_matched++;
+		if (m_options.rich)
+			pe.GetRichHeader();
+		if (m_options.fingerprint)
+			pe.GetFingerprint();
+		if (m_options.overlay)
+			pe.ScanOverlay();
+		pe.WriteJson(json, m_options.headersOnly);
+	}
+	else
+	{
+		m_failed++;
+		json.beginObject();
+		json.field("path", task.path);
+		json.field("error", pe.GetError());
+		json.endObject();
+	}
+	json.endLine();
+}
+
+void BatchScanner::indexSymbols(PEFile& pe, const BatchTask& task)
+{
+	// only the debug directory and its CodeView record are read, even with -headers
+	CodeViewInfo info;
+	if (!m_options.symbolIndex.empty() && pe.GetCodeView(info))
+		m_symbols.add(info, task.path);
+}
+
+void BatchScanner::emit(std::string_view record)
+{
+	std::lock_guard<std::mutex> guard(m_outputLock);
+	fwrite(record.data(), 1, record.size(), stdout);
+}
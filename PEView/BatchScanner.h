@@ -0,0 +1,98 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <Windows.h>
+#include "OutputSink.h"
+#include "ParseCache.h"
+#include "SymbolIndex.h"
+#include "SignatureSet.h"
+
+class PEFile;
+
+struct BatchOptions {
+	std::vector<std::string> roots;
+	std::string list;				// empty : no list file, "-" : stdin, one file or directory per line
+	unsigned int threads = 0;		// 0 : hardware_concurrency
+	bool headersOnly = false;		// skip the data directories
+	bool json = false;				// one NDJSON object per file instead of the TSV record
+	bool hash = false;				// MD5 / SHA-1 / SHA-256 of every file
+	bool authenticode = false;		// the same three over the Authenticode ranges
+	size_t strings = 0;				// minimum string length, 0 : no string extraction
+	std::string symbolIndex;		// empty : no PDB GUID+age -> file index
+	std::string rules;				// empty : no signature scan
+	bool fingerprint = false;		// imphash, Rich header hash and export name hash
+	bool rich = false;				// Rich header key, checksum and toolset
+	bool overlay = false;			// overlay offset, size, entropy and archive format
+
+	std::string cacheDir;			// empty : no parse cache
+	ULONGLONG cacheLimit = 256ull << 20;
+	bool cacheContent = false;		// key entries by content hash instead of file identity
+};
+
+struct BatchTask {
+	std::string path;
+	ULONGLONG size;
+};
+
+/*
+| per-worker deque.                                 |
+| the owner pops from the front, thieves take from  |
+| the back so a worker stuck on a 500MB file does   |
+| not hold back the small files queued behind it.   |
+*/
+class WorkQueue
+{
+public:
+	void push(BatchTask&& task);
+	bool pop(BatchTask& task);
+	bool steal(BatchTask& task);
+
+private:
+	std::mutex m_lock;
+	std::deque<BatchTask> m_tasks;
+};
+
+class BatchScanner
+{
+public:
+	BatchScanner(const BatchOptions& options);
+
+public:
+	int Run();
+
+private:
+	void walk();
+	void walkRoot(const std::string& root);
+	void enqueue(BatchTask&& task);
+	void worker(unsigned int id);
+	bool nextTask(unsigned int id, BatchTask& task);
+	void scanFile(const BatchTask& task, std::string& record);
+	void scanJson(const BatchTask& task, OutputSink& out);
+	void emit(std::string_view record);
+	void indexSymbols(PEFile& pe, const BatchTask& task);
+
+private:
+	BatchOptions m_options;
+	std::unique_ptr<ParseCache> m_cache;
+	SymbolIndex m_symbols;
+	SignatureSet m_signatures;		// compiled once, read by every worker
+	std::vector<WorkQueue> m_queues;
+	size_t m_next = 0;
+
+	std::atomic<bool> m_walking{ true };
+	std::atomic<ULONGLONG> m_pending{ 0 };
+	std::atomic<ULONGLONG> m_files{ 0 };
+	std::atomic<ULONGLONG> m_failed{ 0 };
+	std::atomic<ULONGLONG> m_bytes{ 0 };
+	std::atomic<ULONGLONG> m_matched{ 0 };
+
+	std::mutex m_wakeLock;
+	std::condition_variable m_wake;
+	std::mutex m_outputLock;
+};
@@ -0,0 +1,51 @@
+#include "CertificateTable.h"
+#include <cstring>
+
+bool CertificateTable::parse(const BYTE* data, size_t size, ULONGLONG offset)
+{
+	clear();
+
+	size_t pos = 0;
+	while (pos + headerSize <= size)
+	{
+		Certificate entry;
+		memcpy(&entry.length, data + pos, sizeof(DWORD));
+		memcpy(&entry.revision, data + pos + 4, sizeof(WORD));
+		memcpy(&entry.type, data + pos + 6, sizeof(WORD));
+		if (entry.length < headerSize || entry.length > size - pos)
+			break;
+
+		entry.offset = offset + pos;
+		m_entries.push_back(entry);
+		pos += ((size_t)entry.length + 7) & ~(size_t)7;
+	}
+	return !m_entries.empty();
+}
+
+const char* CertificateTable::TypeName(WORD type)
+{
+	switch (type)
+	{
+	case 1:
+		return "X509";
+	case 2:
+		return "PKCS_SIGNED_DATA";
+	case 3:
+		return "RESERVED_1";
+	case 4:
+		return "TS_STACK_SIGNED";
+	}
+	return "UNKNOWN";
+}
+
+const char* CertificateTable::RevisionName(WORD revision)
+{
+	switch (revision)
+	{
+	case 0x0100:
+		return "REVISION_1_0";
+	case 0x0200:
+		return "REVISION_2_0";
+	}
+	return "UNKNOWN";
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <Windows.h>
+
+/*
+| offset	8byte	|	file offset of the WIN_CERTIFICATE header
+| length	4byte	|	dwLength, header included
+| revision	2byte	|
+| type		2byte	|	WIN_CERT_TYPE_*, 2 is a PKCS#7 SignedData
+*/
+struct Certificate {
+	ULONGLONG offset;
+	DWORD length;
+	WORD revision;
+	WORD type;
+};
+
+/*
+| WIN_CERTIFICATE entries of the security directory.        |
+| the directory holds a file offset, not an RVA, and is not |
+| mapped by the loader; the entries follow each other       |
+| aligned to 8 bytes. only the headers are kept, the        |
+| signatures are read from the file when they are needed.   |
+*/
+class CertificateTable
+{
+public:
+	static constexpr size_t headerSize = 8;
+
+public:
+	void clear() { m_entries.clear(); }
+	// data holds the directory, which starts at offset in the file
+	bool parse(const BYTE* data, size_t size, ULONGLONG offset);
+
+	const std::vector<Certificate>& entries() const { return m_entries; }
+
+	static const char* TypeName(WORD type);
+	static const char* RevisionName(WORD revision);
+
+private:
+	std::vector<Certificate> m_entries;
+};
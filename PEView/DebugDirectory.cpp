@@ -0,0 +1,126 @@
+#include "DebugDirectory.h"
+#include <cstring>
+#include <cstdio>
+
+bool DebugDirectory::parse(const BYTE* data, size_t size)
+{
+	clear();
+
+	size_t count = size / sizeof(IMAGE_DEBUG_DIRECTORY);
+	m_entries.resize(count);
+	if (count)
+		memcpy(m_entries.data(), data, count * sizeof(IMAGE_DEBUG_DIRECTORY));
+	return !m_entries.empty();
+}
+
+size_t DebugDirectory::find(DWORD type) const
+{
+	for (size_t i = 0; i < m_entries.size(); ++i)
+	{
+		if (m_entries[i].Type == type)
+			return i;
+	}
+	return npos;
+}
+
+bool DebugDirectory::ReadCodeView(const BYTE* data, size_t size, CodeViewInfo& info)
+{
+	info = CodeViewInfo();
+	if (size < sizeof(DWORD))
+		return false;
+	memcpy(&info.format, data, sizeof(DWORD));
+
+	// RSDS : signature, GUID, age, path  /  NB10 : signature, offset, timestamp, age, path
+	size_t path;
+	if (info.format == formatRSDS && size >= 24)
+	{
+		memcpy(&info.guid, data + 4, sizeof(GUID));
+		memcpy(&info.age, data + 20, sizeof(DWORD));
+		path = 24;
+	}
+	else if (info.format == formatNB10 && size >= 16)
+	{
+		memcpy(&info.guid.Data1, data + 8, sizeof(DWORD));
+		memcpy(&info.age, data + 12, sizeof(DWORD));
+		path = 16;
+	}
+	else
+		return false;
+
+	// the path is NUL terminated when the record is intact
+	size_t length = strnlen((const char*)data + path, size - path);
+	info.path.assign((const char*)data + path, length);
+	return true;
+}
+
+bool DebugDirectory::ReadPogo(const BYTE* data, size_t size, DWORD& signature, std::vector<PogoEntry>& entries)
+{
+	entries.clear();
+	if (size < sizeof(DWORD))
+		return false;
+	memcpy(&signature, data, sizeof(DWORD));
+
+	// rva, size and a NUL terminated name padded to 4 bytes, until the record ends
+	size_t pos = sizeof(DWORD);
+	while (pos + 8 < size)
+	{
+		PogoEntry entry;
+		memcpy(&entry.rva, data + pos, sizeof(DWORD));
+		memcpy(&entry.size, data + pos + 4, sizeof(DWORD));
+		size_t length = strnlen((const char*)data + pos + 8, size - pos - 8);
+		entry.name.assign((const char*)data + pos + 8, length);
+		entries.push_back(std::move(entry));
+		pos += (8 + length + 1 + 3) & ~(size_t)3;
+	}
+	return true;
+}
+
+bool DebugDirectory::ReadVcFeatures(const BYTE* data, size_t size, VcFeatures& features)
+{
+	features = {};
+	if (size < sizeof(VcFeatures))
+		return false;
+	memcpy(&features, data, sizeof(VcFeatures));
+	return true;
+}
+
+bool DebugDirectory::ReadRepro(const BYTE* data, size_t size, const BYTE*& hash, size_t& length)
+{
+	DWORD stored;
+	if (size < sizeof(DWORD))
+		return false;
+	memcpy(&stored, data, sizeof(DWORD));
+
+	hash = data + sizeof(DWORD);
+	length = stored < size - sizeof(DWORD) ? stored : size - sizeof(DWORD);
+	return true;
+}
+
+int DebugDirectory::FormatKey(char* out, const CodeViewInfo& info)
+{
+	// PDB 2.0 files are looked up by signature, PDB 7.0 files by GUID
+	if (info.format == formatNB10)
+		return snprintf(out, keySize, "%08X%X", info.guid.Data1, info.age);
+
+	const GUID& g = info.guid;
+	return snprintf(out, keySize, "%08X%04X%04X%02X%02X%02X%02X%02X%02X%02X%02X%X",
+		g.Data1, g.Data2, g.Data3, g.Data4[0], g.Data4[1], g.Data4[2], g.Data4[3],
+		g.Data4[4], g.Data4[5], g.Data4[6], g.Data4[7], info.age);
+}
+
+void DebugDirectory::FormatGuid(char* out, const GUID& g)
+{
+	snprintf(out, 39, "{%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X}",
+		g.Data1, g.Data2, g.Data3, g.Data4[0], g.Data4[1], g.Data4[2], g.Data4[3],
+		g.Data4[4], g.Data4[5], g.Data4[6], g.Data4[7]);
+}
+
+const char* DebugDirectory::TypeName(DWORD type)
+{
+	static const char* const names[] = {
+		"UNKNOWN", "COFF", "CODEVIEW", "FPO", "MISC", "EXCEPTION", "FIXUP", "OMAP_TO_SRC", "OMAP_FROM_SRC",
+		"BORLAND", "RESERVED10", "CLSID", "VC_FEATURE", "POGO", "ILTCG", "MPX", "REPRO", "EMBEDDED_PDB",
+		"SPGO", "PDBCHECKSUM", "EX_DLLCHARACTERISTICS"
+	};
+	return type < sizeof(names) / sizeof(names[0]) ? names[type] : "UNKNOWN";
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <Windows.h>
+
+/*
+| CodeView record of a debug directory entry.              |
+| RSDS (PDB 7.0) carries a GUID, NB10 (PDB 2.0) only a     |
+| 4 byte signature, kept in guid.Data1 with the rest 0.   |
+*/
+struct CodeViewInfo {
+	DWORD format;			// DebugDirectory::formatRSDS or formatNB10
+	GUID guid;
+	DWORD age;
+	std::string path;
+};
+
+// one section contribution of a POGO record
+struct PogoEntry {
+	DWORD rva;
+	DWORD size;
+	std::string name;
+};
+
+// object counts of an IMAGE_DEBUG_TYPE_VC_FEATURE record
+struct VcFeatures {
+	DWORD preVC11;
+	DWORD cpp;
+	DWORD gs;
+	DWORD sdl;
+	DWORD guardN;
+};
+
+/*
+| IMAGE_DEBUG_DIRECTORY entries as read from the file.    |
+| the records they point to are decoded by the static     |
+| readers, the caller reads the bytes at PointerToRawData |
+| only for the records it needs.                          |
+*/
+class DebugDirectory
+{
+public:
+	static constexpr size_t npos = (size_t)-1;
+	static constexpr size_t keySize = 41;		// 32 GUID digits, at most 8 age digits and a NUL
+	static constexpr DWORD formatRSDS = 0x53445352;		// "RSDS"
+	static constexpr DWORD formatNB10 = 0x3031424E;		// "NB10"
+
+public:
+	void clear() { m_entries.clear(); }
+	bool parse(const BYTE* data, size_t size);
+
+	const std::vector<IMAGE_DEBUG_DIRECTORY>& entries() const { return m_entries; }
+	size_t find(DWORD type) const;		// first entry of type, npos if none
+
+	static bool ReadCodeView(const BYTE* data, size_t size, CodeViewInfo& info);
+	// signature is "LTCG", "PGU" or "PGI" read from the high byte down
+	static bool ReadPogo(const BYTE* data, size_t size, DWORD& signature, std::vector<PogoEntry>& entries);
+	static bool ReadVcFeatures(const BYTE* data, size_t size, VcFeatures& features);
+	// the deterministic build hash, without the leading length
+	static bool ReadRepro(const BYTE* data, size_t size, const BYTE*& hash, size_t& length);
+
+	// symbol server key : GUID (or NB10 signature) as upper case hex and the age, returns the length
+	static int FormatKey(char* out, const CodeViewInfo& info);
+	// {XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}
+	static void FormatGuid(char* out, const GUID& guid);
+	static const char* TypeName(DWORD type);
+
+private:
+	std::vector<IMAGE_DEBUG_DIRECTORY> m_entries;
+};
@@ -0,0 +1,295 @@
+#include "Digest.h"
+#include <cstring>
+
+static inline DWORD rotl(DWORD value, int bits)
+{
+	return (value << bits) | (value >> (32 - bits));
+}
+
+static inline DWORD rotr(DWORD value, int bits)
+{
+	return (value >> bits) | (value << (32 - bits));
+}
+
+static inline DWORD loadLE(const BYTE* p)
+{
+	return (DWORD)p[0] | ((DWORD)p[1] << 8) | ((DWORD)p[2] << 16) | ((DWORD)p[3] << 24);
+}
+
+static inline DWORD loadBE(const BYTE* p)
+{
+	return ((DWORD)p[0] << 24) | ((DWORD)p[1] << 16) | ((DWORD)p[2] << 8) | (DWORD)p[3];
+}
+
+static inline void storeBE(BYTE* p, DWORD value)
+{
+	p[0] = (BYTE)(value >> 24);
+	p[1] = (BYTE)(value >> 16);
+	p[2] = (BYTE)(value >> 8);
+	p[3] = (BYTE)value;
+}
+
+// the block buffering and padding are the same for all three
+template <typename Compress>
+static void absorb(BYTE* buffer, ULONGLONG& length, const BYTE* data, size_t size, Compress compress)
+{
+	size_t used = (size_t)(length & 63);
+	length += size;
+
+	if (used)
+	{
+		size_t n = 64 - used < size ? 64 - used : size;
+		memcpy(buffer + used, data, n);
+		data += n;
+		size -= n;
+		if (used + n < 64)
+			return;
+		compress(buffer);
+	}
+
+	for (; size >= 64; data += 64, size -= 64)
+		compress(data);
+	memcpy(buffer, data, size);
+}
+
+template <typename Compress>
+static void pad(BYTE* buffer, ULONGLONG length, bool bigEndian, Compress compress)
+{
+	size_t used = (size_t)(length & 63);
+	buffer[used++] = 0x80;
+	if (used > 56)
+	{
+		memset(buffer + used, 0, 64 - used);
+		compress(buffer);
+		used = 0;
+	}
+	memset(buffer + used, 0, 56 - used);
+
+	ULONGLONG bits = length * 8;
+	for (int i = 0; i < 8; ++i)
+		buffer[56 + i] = bigEndian ? (BYTE)(bits >> (56 - 8 * i)) : (BYTE)(bits >> (8 * i));
+	compress(buffer);
+}
+
+// MD5
+
+void Md5::reset()
+{
+	m_state[0] = 0x67452301;
+	m_state[1] = 0xEFCDAB89;
+	m_state[2] = 0x98BADCFE;
+	m_state[3] = 0x10325476;
+	m_length = 0;
+}
+
+void Md5::compress(const BYTE* block)
+{
+	static const DWORD k[64] = {
+		0xD76AA478, 0xE8C7B756, 0x242070DB, 0xC1BDCEEE, 0xF57C0FAF, 0x4787C62A, 0xA8304613, 0xFD469501,
+		0x698098D8, 0x8B44F7AF, 0xFFFF5BB1, 0x895CD7BE, 0x6B901122, 0xFD987193, 0xA679438E, 0x49B40821,
+		0xF61E2562, 0xC040B340, 0x265E5A51, 0xE9B6C7AA, 0xD62F105D, 0x02441453, 0xD8A1E681, 0xE7D3FBC8,
+		0x21E1CDE6, 0xC33707D6, 0xF4D50D87, 0x455A14ED, 0xA9E3E905, 0xFCEFA3F8, 0x676F02D9, 0x8D2A4C8A,
+		0xFFFA3942, 0x8771F681, 0x6D9D6122, 0xFDE5380C, 0xA4BEEA44, 0x4BDECFA9, 0xF6BB4B60, 0xBEBFBC70,
+		0x289B7EC6, 0xEAA127FA, 0xD4EF3085, 0x04881D05, 0xD9D4D039, 0xE6DB99E5, 0x1FA27CF8, 0xC4AC5665,
+		0xF4292244, 0x432AFF97, 0xAB9423A7, 0xFC93A039, 0x655B59C3, 0x8F0CCC92, 0xFFEFF47D, 0x85845DD1,
+		0x6FA87E4F, 0xFE2CE6E0, 0xA3014314, 0x4E0811A1, 0xF7537E82, 0xBD3AF235, 0x2AD7D2BB, 0xEB86D391,
+	};
+	static const int shift[16] = { 7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21 };
+
+	DWORD w[16];
+	for (int i = 0; i < 16; ++i)
+		w[i] = loadLE(block + i * 4);
+
+	DWORD a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+	for (int i = 0; i < 64; ++i)
+	{
+		DWORD f;
+		int g;
+		switch (i >> 4)
+		{
+		case 0: f = (b & c) | (~b & d); g = i; break;
+		case 1: f = (d & b) | (~d & c); g = (5 * i + 1) & 15; break;
+		case 2: f = b ^ c ^ d; g = (3 * i + 5) & 15; break;
+		default: f = c ^ (b | ~d); g = (7 * i) & 15; break;
+		}
+
+		DWORD t = d;
+		d = c;
+		c = b;
+		b = b + rotl(a + f + k[i] + w[g], shift[(i >> 4) * 4 + (i & 3)]);
+		a = t;
+	}
+
+	m_state[0] += a;
+	m_state[1] += b;
+	m_state[2] += c;
+	m_state[3] += d;
+}
+
+void Md5::update(const BYTE* data, size_t size)
+{
+	absorb(m_buffer, m_length, data, size, [this](const BYTE* block) { compress(block); });
+}
+
+void Md5::final(BYTE* digest)
+{
+	pad(m_buffer, m_length, false, [this](const BYTE* block) { compress(block); });
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+			digest[i * 4 + j] = (BYTE)(m_state[i] >> (8 * j));
+	}
+}
+
+// SHA-1
+
+void Sha1::reset()
+{
+	m_state[0] = 0x67452301;
+	m_state[1] = 0xEFCDAB89;
+	m_state[2] = 0x98BADCFE;
+	m_state[3] = 0x10325476;
+	m_state[4] = 0xC3D2E1F0;
+	m_length = 0;
+}
+
+void Sha1::compress(const BYTE* block)
+{
+	DWORD w[80];
+	for (int i = 0; i < 16; ++i)
+		w[i] = loadBE(block + i * 4);
+	for (int i = 16; i < 80; ++i)
+		w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+	DWORD a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3], e = m_state[4];
+	for (int i = 0; i < 80; ++i)
+	{
+		DWORD f, k;
+		if (i < 20)
+		{
+			f = (b & c) | (~b & d);
+			k = 0x5A827999;
+		}
+		else if (i < 40)
+		{
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		}
+		else if (i < 60)
+		{
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		}
+		else
+		{
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+
+		DWORD t = rotl(a, 5) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = rotl(b, 30);
+		b = a;
+		a = t;
+	}
+
+	m_state[0] += a;
+	m_state[1] += b;
+	m_state[2] += c;
+	m_state[3] += d;
+	m_state[4] += e;
+}
+
+void Sha1::update(const BYTE* data, size_t size)
+{
+	absorb(m_buffer, m_length, data, size, [this](const BYTE* block) { compress(block); });
+}
+
+void Sha1::final(BYTE* digest)
+{
+	pad(m_buffer, m_length, true, [this](const BYTE* block) { compress(block); });
+	for (int i = 0; i < 5; ++i)
+		storeBE(digest + i * 4, m_state[i]);
+}
+
+// SHA-256
+
+void Sha256::reset()
+{
+	m_state[0] = 0x6A09E667;
+	m_state[1] = 0xBB67AE85;
+	m_state[2] = 0x3C6EF372;
+	m_state[3] = 0xA54FF53A;
+	m_state[4] = 0x510E527F;
+	m_state[5] = 0x9B05688C;
+	m_state[6] = 0x1F83D9AB;
+	m_state[7] = 0x5BE0CD19;
+	m_length = 0;
+}
+
+void Sha256::compress(const BYTE* block)
+{
+	static const DWORD k[64] = {
+		0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+		0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+		0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+		0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+		0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+		0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+		0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+		0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+	};
+
+	DWORD w[64];
+	for (int i = 0; i < 16; ++i)
+		w[i] = loadBE(block + i * 4);
+	for (int i = 16; i < 64; ++i)
+	{
+		DWORD s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		DWORD s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	DWORD a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+	DWORD e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+	for (int i = 0; i < 64; ++i)
+	{
+		DWORD s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+		DWORD ch = (e & f) ^ (~e & g);
+		DWORD t1 = h + s1 + ch + k[i] + w[i];
+		DWORD s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+		DWORD maj = (a & b) ^ (a & c) ^ (b & c);
+		DWORD t2 = s0 + maj;
+
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	m_state[0] += a;
+	m_state[1] += b;
+	m_state[2] += c;
+	m_state[3] += d;
+	m_state[4] += e;
+	m_state[5] += f;
+	m_state[6] += g;
+	m_state[7] += h;
+}
+
+void Sha256::update(const BYTE* data, size_t size)
+{
+	absorb(m_buffer, m_length, data, size, [this](const BYTE* block) { compress(block); });
+}
+
+void Sha256::final(BYTE* digest)
+{
+	pad(m_buffer, m_length, true, [this](const BYTE* block) { compress(block); });
+	for (int i = 0; i < 8; ++i)
+		storeBE(digest + i * 4, m_state[i]);
+}
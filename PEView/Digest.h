@@ -0,0 +1,66 @@
+#pragma once
+#include <Windows.h>
+
+/*
+| streaming message digests.                               |
+| update() takes any number of bytes, whole 64 byte blocks |
+| are compressed straight from the caller's buffer and     |
+| only the tail is copied. final() writes digestSize bytes |
+| and leaves the object to be reset().                     |
+*/
+class Md5
+{
+public:
+	static constexpr int digestSize = 16;
+
+	Md5() { reset(); }
+	void reset();
+	void update(const BYTE* data, size_t size);
+	void final(BYTE* digest);
+
+private:
+	void compress(const BYTE* block);
+
+private:
+	DWORD m_state[4];
+	ULONGLONG m_length;
+	BYTE m_buffer[64];
+};
+
+class Sha1
+{
+public:
+	static constexpr int digestSize = 20;
+
+	Sha1() { reset(); }
+	void reset();
+	void update(const BYTE* data, size_t size);
+	void final(BYTE* digest);
+
+private:
+	void compress(const BYTE* block);
+
+private:
+	DWORD m_state[5];
+	ULONGLONG m_length;
+	BYTE m_buffer[64];
+};
+
+class Sha256
+{
+public:
+	static constexpr int digestSize = 32;
+
+	Sha256() { reset(); }
+	void reset();
+	void update(const BYTE* data, size_t size);
+	void final(BYTE* digest);
+
+private:
+	void compress(const BYTE* block);
+
+private:
+	DWORD m_state[8];
+	ULONGLONG m_length;
+	BYTE m_buffer[64];
+};
@@ -0,0 +1,144 @@
+#include "Entropy.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+
+void Entropy::count(const BYTE* data, size_t size, ULONGLONG counts[256])
+{
+	// blocks keep the 32-bit sub-histograms from overflowing
+	const size_t block = 1u << 30;
+	for (size_t begin = 0; begin < size; begin += block)
+	{
+		const BYTE* p = data + begin;
+		size_t n = (std::min)(block, size - begin);
+
+		DWORD sub[4][256] = {};
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			ULONGLONG word;
+			memcpy(&word, p + i, 8);
+			sub[0][(BYTE)word]++;
+			sub[1][(BYTE)(word >> 8)]++;
+			sub[2][(BYTE)(word >> 16)]++;
+			sub[3][(BYTE)(word >> 24)]++;
+			sub[0][(BYTE)(word >> 32)]++;
+			sub[1][(BYTE)(word >> 40)]++;
+			sub[2][(BYTE)(word >> 48)]++;
+			sub[3][(BYTE)(word >> 56)]++;
+		}
+		for (; i < n; ++i)
+			sub[0][p[i]]++;
+
+		for (int b = 0; b < 256; ++b)
+			counts[b] += (ULONGLONG)sub[0][b] + sub[1][b] + sub[2][b] + sub[3][b];
+	}
+}
+
+void Entropy::Histogram(const BYTE* data, size_t size, ULONGLONG counts[256], bool threads)
+{
+	memset(counts, 0, 256 * sizeof(ULONGLONG));
+
+	unsigned int workers = threads && size >= threadThreshold ? std::thread::hardware_concurrency() : 1;
+	if (workers <= 1)
+	{
+		count(data, size, counts);
+		return;
+	}
+
+	std::vector<std::vector<ULONGLONG>> partial(workers, std::vector<ULONGLONG>(256));
+	std::vector<std::thread> pool;
+	size_t slice = size / workers;
+	for (unsigned int t = 0; t < workers; ++t)
+	{
+		size_t begin = t * slice;
+		size_t end = t + 1 == workers ? size : begin + slice;
+		pool.emplace_back([&, t, begin, end] { count(data + begin, end - begin, partial[t].data()); });
+	}
+	for (auto& thread : pool)
+		thread.join();
+
+	for (const auto& part : partial)
+	{
+		for (int b = 0; b < 256; ++b)
+			counts[b] += part[b];
+	}
+}
+
+double Entropy::FromHistogram(const ULONGLONG counts[256], ULONGLONG total)
+{
+	if (total == 0)
+		return 0.0;
+
+	double entropy = 0.0;
+	for (int b = 0; b < 256; ++b)
+	{
+		if (counts[b])
+		{
+			double p = (double)counts[b] / total;
+			entropy -= p * std::log2(p);
+		}
+	}
+	return entropy;
+}
+
+double Entropy::Of(const BYTE* data, size_t size, bool threads)
+{
+	ULONGLONG counts[256];
+	Histogram(data, size, counts, threads);
+	return FromHistogram(counts, size);
+}
+
+void Entropy::Windows(const BYTE* data, size_t size, size_t window, size_t step, std::vector<float>& out)
+{
+	out.clear();
+	if (size == 0 || window == 0 || step == 0)
+		return;
+	if (size <= window)
+	{
+		out.push_back((float)Of(data, size, false));
+		return;
+	}
+
+	// H = log2(w) - sum(c * log2(c)) / w, and a one byte move changes one c,
+	// so the sum is updated from a table instead of rescanning 256 bins per window
+	std::vector<double> term(window + 1);
+	term[0] = 0.0;
+	for (size_t c = 1; c <= window; ++c)
+		term[c] = c * std::log2((double)c);
+
+	DWORD counts[256] = {};
+	double sum = 0.0;
+	auto add = [&](BYTE b) {
+		sum += term[counts[b] + 1] - term[counts[b]];
+		counts[b]++;
+	};
+	auto remove = [&](BYTE b) {
+		sum += term[counts[b] - 1] - term[counts[b]];
+		counts[b]--;
+	};
+
+	const double logWindow = std::log2((double)window);
+	out.reserve((size - window) / step + 1);
+	for (size_t begin = 0; begin + window <= size; begin += step)
+	{
+		if (begin == 0 || step >= window)
+		{
+			// disjoint windows start over, the sum is exact again
+			memset(counts, 0, sizeof(counts));
+			sum = 0.0;
+			for (size_t i = 0; i < window; ++i)
+				add(data[begin + i]);
+		}
+		else
+		{
+			for (size_t i = begin - step; i < begin; ++i)
+			{
+				remove(data[i]);
+				add(data[i + window]);
+			}
+		}
+		out.push_back((float)(std::max)(0.0, logWindow - sum / window));
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+#include <Windows.h>
+
+/*
+| byte histograms and Shannon entropy in bits per byte.     |
+| the histogram is counted into four sub-histograms from   |
+| 64-bit loads, so neighbouring equal bytes (zero padding)  |
+| do not wait on each other's increment, and merged with    |
+| one vector add at the end. large ranges are split across  |
+| threads and the partial histograms summed.                |
+*/
+class Entropy
+{
+public:
+	static constexpr size_t threadThreshold = 16 << 20;		// smaller ranges stay on the caller's thread
+
+	static void Histogram(const BYTE* data, size_t size, ULONGLONG counts[256], bool threads = true);
+	static double FromHistogram(const ULONGLONG counts[256], ULONGLONG total);
+	static double Of(const BYTE* data, size_t size, bool threads = true);
+
+	// entropy of [k * step, k * step + window) for every window that fits, one value for a shorter range
+	static void Windows(const BYTE* data, size_t size, size_t window, size_t step, std::vector<float>& out);
+
+private:
+	static void count(const BYTE* data, size_t size, ULONGLONG counts[256]);
+};
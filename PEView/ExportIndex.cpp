@@ -0,0 +1,107 @@
+#include "ExportIndex.h"
+#include "PEFile.h"
+#include "StringArena.h"
+#include <algorithm>
+
+void ExportIndex::build(const IMAGE_EXPORT_DIRECTORY& ied, const std::vector<DWORD>& functions, const std::vector<ExportElement>& named)
+{
+	m_base = ied.Base;
+	m_functions = functions;
+	m_functionName.assign(m_functions.size(), npos);
+
+	// the names are views into the image or the PEFile arena, nothing is copied
+	m_nameEntries.clear();
+	m_nameEntries.reserve(named.size());
+
+	for (const auto& ee : named)
+	{
+		Name entry;
+		entry.text = ee.name;
+		entry.function = ee.ordinal;
+
+		if (entry.function < m_functionName.size() && m_functionName[entry.function] == npos)
+			m_functionName[entry.function] = (DWORD)m_nameEntries.size();
+		m_nameEntries.push_back(entry);
+	}
+
+	// keep the load factor at or below 1/2
+	size_t capacity = 16;
+	while (capacity < m_nameEntries.size() * 2)
+		capacity <<= 1;
+	m_slots.assign(capacity, Slot{ 0, 0 });
+
+	for (DWORD i = 0; i < m_nameEntries.size(); ++i)
+	{
+		const Name& entry = m_nameEntries[i];
+		DWORD h = StringArena::hash(entry.text.data(), entry.text.size());
+		size_t slot = h & (capacity - 1);
+		while (m_slots[slot].name)
+			slot = (slot + 1) & (capacity - 1);
+		m_slots[slot] = { h, i + 1 };
+	}
+
+	m_byAddress.clear();
+	m_byAddress.reserve(m_functions.size());
+	for (DWORD i = 0; i < m_functions.size(); ++i)
+	{
+		if (m_functions[i])
+			m_byAddress.push_back(i);
+	}
+	std::sort(m_byAddress.begin(), m_byAddress.end(), [this](DWORD a, DWORD b) { return m_functions[a] < m_functions[b]; });
+
+	m_built = true;
+}
+
+void ExportIndex::makeSymbol(DWORD function, ExportSymbol& symbol) const
+{
+	symbol.ordinal = m_base + function;
+	symbol.rva = m_functions[function];
+
+	DWORD name = m_functionName[function];
+	symbol.name = name == npos ? nullptr : m_nameEntries[name].text.data();
+}
+
+bool ExportIndex::findByName(const char* name, size_t length, ExportSymbol& symbol) const
+{
+	if (m_slots.empty())
+		return false;
+
+	DWORD h = StringArena::hash(name, length);
+	size_t mask = m_slots.size() - 1;
+	for (size_t slot = h & mask; m_slots[slot].name; slot = (slot + 1) & mask)
+	{
+		if (m_slots[slot].hash != h)
+			continue;
+
+		const Name& entry = m_nameEntries[m_slots[slot].name - 1];
+		if (entry.text.size() == length && memcmp(entry.text.data(), name, length) == 0)
+		{
+			if (entry.function >= m_functions.size())
+				return false;
+			makeSymbol(entry.function, symbol);
+			symbol.name = entry.text.data();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ExportIndex::findByOrdinal(DWORD ordinal, ExportSymbol& symbol) const
+{
+	DWORD function = ordinal - m_base;
+	if (ordinal < m_base || function >= m_functions.size() || !m_functions[function])
+		return false;
+
+	makeSymbol(function, symbol);
+	return true;
+}
+
+bool ExportIndex::findByAddress(DWORD rva, ExportSymbol& symbol) const
+{
+	auto it = std::upper_bound(m_byAddress.begin(), m_byAddress.end(), rva, [this](DWORD value, DWORD function) { return value < m_functions[function]; });
+	if (it == m_byAddress.begin())
+		return false;
+
+	makeSymbol(*(it - 1), symbol);
+	return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <Windows.h>
+
+struct ExportElement;
+
+struct ExportSymbol {
+	DWORD ordinal;		// biased by IMAGE_EXPORT_DIRECTORY::Base
+	DWORD rva;
+	const char* name;	// nullptr for exports by ordinal only
+};
+
+/*
+| lookup structures built once per file                    |
+| name    : open addressing hash over the name views       |
+| ordinal : dense table indexed by (ordinal - Base)        |
+| address : exports sorted by rva, binary search           |
+*/
+class ExportIndex
+{
+public:
+	void build(const IMAGE_EXPORT_DIRECTORY& ied, const std::vector<DWORD>& functions, const std::vector<ExportElement>& named);
+	bool built() const { return m_built; }
+
+	bool findByName(const char* name, size_t length, ExportSymbol& symbol) const;
+	bool findByOrdinal(DWORD ordinal, ExportSymbol& symbol) const;
+	bool findByAddress(DWORD rva, ExportSymbol& symbol) const;
+
+	size_t size() const { return m_byAddress.size(); }
+
+private:
+	void makeSymbol(DWORD function, ExportSymbol& symbol) const;
+
+private:
+	static constexpr DWORD npos = 0xFFFFFFFF;
+
+	struct Name {
+		std::string_view text;	// owned by the PEFile, NUL terminated
+		DWORD function;			// index into m_functions
+	};
+
+	struct Slot {
+		DWORD hash;
+		DWORD name;			// index into m_nameEntries + 1, 0 is empty
+	};
+
+	DWORD m_base = 0;
+	std::vector<DWORD> m_functions;		// AddressOfFunctions
+	std::vector<DWORD> m_functionName;	// first name of each function or npos
+	std::vector<Name> m_nameEntries;
+	std::vector<Slot> m_slots;			// power of two, linear probing
+	std::vector<DWORD> m_byAddress;		// function indices sorted by rva
+	bool m_built = false;
+};
@@ -0,0 +1,164 @@
+#include "FileHasher.h"
+#include <algorithm>
+#include <thread>
+
+/*
+| one algorithm's contexts: the whole file and every range. |
+*/
+template <typename Algorithm>
+struct HashContexts {
+	Algorithm file;
+	std::vector<Algorithm> ranges;
+
+	explicit HashContexts(size_t count) : ranges(count) {}
+
+	// chunk holds the bytes [pos, pos + size) of the file
+	void feed(ULONGLONG pos, const BYTE* chunk, size_t size, const std::vector<HashRange>& list)
+	{
+		file.update(chunk, size);
+		for (size_t i = 0; i < list.size(); ++i)
+		{
+			ULONGLONG lo = (std::max)(pos, list[i].offset);
+			ULONGLONG hi = (std::min)(pos + size, list[i].offset + list[i].size);
+			if (lo < hi)
+				ranges[i].update(chunk + (lo - pos), (size_t)(hi - lo));
+		}
+	}
+
+	template <size_t N>
+	void finish(DigestSet& fileSet, std::vector<DigestSet>& rangeSets, BYTE (DigestSet::*slot)[N])
+	{
+		file.final(fileSet.*slot);
+		for (size_t i = 0; i < ranges.size(); ++i)
+			ranges[i].final(rangeSets[i].*slot);
+	}
+};
+
+template <typename Algorithm, size_t N>
+void FileHasher::walk(const BYTE* data, ULONGLONG size, const std::vector<HashRange>& ranges, BYTE (DigestSet::*slot)[N])
+{
+	HashContexts<Algorithm> contexts(ranges.size());
+	for (ULONGLONG pos = 0; pos < size; pos += chunkSize)
+		contexts.feed(pos, data + pos, (size_t)(std::min)((ULONGLONG)chunkSize, size - pos), ranges);
+	contexts.finish(m_file, m_ranges, slot);
+}
+
+void FileHasher::run(const BYTE* data, ULONGLONG size, const std::vector<HashRange>& ranges, bool threads)
+{
+	m_ranges.assign(ranges.size(), DigestSet{});
+
+	if (!threads || size < threadThreshold)
+	{
+		walk<Md5>(data, size, ranges, &DigestSet::md5);
+		walk<Sha1>(data, size, ranges, &DigestSet::sha1);
+		walk<Sha256>(data, size, ranges, &DigestSet::sha256);
+		return;
+	}
+
+	// each thread writes its own slot of every DigestSet, nothing is shared
+	std::thread md5([&] { walk<Md5>(data, size, ranges, &DigestSet::md5); });
+	std::thread sha1([&] { walk<Sha1>(data, size, ranges, &DigestSet::sha1); });
+	walk<Sha256>(data, size, ranges, &DigestSet::sha256);
+	md5.join();
+	sha1.join();
+}
+
+bool FileHasher::run(std::ifstream& file, ULONGLONG size, const std::vector<HashRange>& ranges)
+{
+	m_ranges.assign(ranges.size(), DigestSet{});
+
+	HashContexts<Md5> md5(ranges.size());
+	HashContexts<Sha1> sha1(ranges.size());
+	HashContexts<Sha256> sha256(ranges.size());
+
+	// every chunk is read once and fed to all three while it is still in cache
+	std::vector<BYTE> buffer(chunkSize);
+	file.clear();
+	file.seekg(0, std::ios::beg);
+	for (ULONGLONG pos = 0; pos < size; pos += chunkSize)
+	{
+		size_t n = (size_t)(std::min)((ULONGLONG)chunkSize, size - pos);
+		if (!file.read(reinterpret_cast<char*>(buffer.data()), n))
+			return false;
+		md5.feed(pos, buffer.data(), n, ranges);
+		sha1.feed(pos, buffer.data(), n, ranges);
+		sha256.feed(pos, buffer.data(), n, ranges);
+	}
+
+	md5.finish(m_file, m_ranges, &DigestSet::md5);
+	sha1.finish(m_file, m_ranges, &DigestSet::sha1);
+	sha256.finish(m_file, m_ranges, &DigestSet::sha256);
+	return true;
+}
+
+template <typename Algorithm, size_t N>
+void FileHasher::walkJoined(const BYTE* data, const std::vector<HashRange>& ranges, DigestSet& out, BYTE (DigestSet::*slot)[N])
+{
+	Algorithm context;
+	for (const HashRange& range : ranges)
+	{
+		for (ULONGLONG pos = 0; pos < range.size; pos += chunkSize)
+			context.update(data + range.offset + pos, (size_t)(std::min)((ULONGLONG)chunkSize, range.size - pos));
+	}
+	context.final(out.*slot);
+}
+
+void FileHasher::HashJoined(const BYTE* data, const std::vector<HashRange>& ranges, bool threads, DigestSet& out)
+{
+	ULONGLONG total = 0;
+	for (const HashRange& range : ranges)
+		total += range.size;
+
+	if (!threads || total < threadThreshold)
+	{
+		walkJoined<Md5>(data, ranges, out, &DigestSet::md5);
+		walkJoined<Sha1>(data, ranges, out, &DigestSet::sha1);
+		walkJoined<Sha256>(data, ranges, out, &DigestSet::sha256);
+		return;
+	}
+
+	std::thread md5([&] { walkJoined<Md5>(data, ranges, out, &DigestSet::md5); });
+	std::thread sha1([&] { walkJoined<Sha1>(data, ranges, out, &DigestSet::sha1); });
+	walkJoined<Sha256>(data, ranges, out, &DigestSet::sha256);
+	md5.join();
+	sha1.join();
+}
+
+bool FileHasher::HashJoined(std::ifstream& file, const std::vector<HashRange>& ranges, DigestSet& out)
+{
+	Md5 md5;
+	Sha1 sha1;
+	Sha256 sha256;
+
+	std::vector<BYTE> buffer(chunkSize);
+	for (const HashRange& range : ranges)
+	{
+		file.clear();
+		file.seekg(range.offset, std::ios::beg);
+		for (ULONGLONG pos = 0; pos < range.size; pos += chunkSize)
+		{
+			size_t n = (size_t)(std::min)((ULONGLONG)chunkSize, range.size - pos);
+			if (!file.read(reinterpret_cast<char*>(buffer.data()), n))
+				return false;
+			md5.update(buffer.data(), n);
+			sha1.update(buffer.data(), n);
+			sha256.update(buffer.data(), n);
+		}
+	}
+
+	md5.final(out.md5);
+	sha1.final(out.sha1);
+	sha256.final(out.sha256);
+	return true;
+}
+
+void FileHasher::format(char* out, const BYTE* digest, size_t size)
+{
+	static const char digits[] = "0123456789abcdef";
+	for (size_t i = 0; i < size; ++i)
+	{
+		*out++ = digits[digest[i] >> 4];
+		*out++ = digits[digest[i] & 15];
+	}
+	*out = '\0';
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <fstream>
+#include <vector>
+#include <Windows.h>
+#include "Digest.h"
+
+struct HashRange {
+	ULONGLONG offset;
+	ULONGLONG size;
+};
+
+struct DigestSet {
+	BYTE md5[Md5::digestSize];
+	BYTE sha1[Sha1::digestSize];
+	BYTE sha256[Sha256::digestSize];
+};
+
+/*
+| hashes the whole file and any number of ranges of it      |
+| (sections, overlay) in one walk over the file.             |
+| the file is read in chunks that stay in cache, each chunk  |
+| goes to the whole file digest and to every range it        |
+| overlaps. the digests are serial by nature, so a mapped    |
+| file gets one thread per algorithm, all walking the same   |
+| chunks roughly in step.                                    |
+*/
+class FileHasher
+{
+public:
+	static constexpr size_t chunkSize = 256 * 1024;
+	static constexpr ULONGLONG threadThreshold = 4 * 1024 * 1024;		// smaller files stay on the caller's thread
+
+public:
+	void run(const BYTE* data, ULONGLONG size, const std::vector<HashRange>& ranges, bool threads);
+	bool run(std::ifstream& file, ULONGLONG size, const std::vector<HashRange>& ranges);
+
+	// one digest set over ranges back to back (sorted, not overlapping), without the whole file
+	static void HashJoined(const BYTE* data, const std::vector<HashRange>& ranges, bool threads, DigestSet& out);
+	static bool HashJoined(std::ifstream& file, const std::vector<HashRange>& ranges, DigestSet& out);
+
+	const DigestSet& file() const { return m_file; }
+	const std::vector<DigestSet>& ranges() const { return m_ranges; }
+
+	// lower case hex and a terminating NUL, out holds 2 * size + 1 chars
+	static void format(char* out, const BYTE* digest, size_t size);
+
+private:
+	template <typename Algorithm, size_t N>
+	static void walkJoined(const BYTE* data, const std::vector<HashRange>& ranges, DigestSet& out, BYTE (DigestSet::*slot)[N]);
+	template <typename Algorithm, size_t N>
+	void walk(const BYTE* data, ULONGLONG size, const std::vector<HashRange>& ranges, BYTE (DigestSet::*slot)[N]);
+
+private:
+	DigestSet m_file = {};
+	std::vector<DigestSet> m_ranges;
+};
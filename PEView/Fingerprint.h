@@ -0,0 +1,57 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <Windows.h>
+#include "Digest.h"
+#include "RichHeader.h"
+
+/*
+| imphash		16byte	|	imports as "module.function"	|
+| rich			16byte	|	the decoded Rich header			|
+| exports		16byte	|	export names, sorted			|
+| has*			1byte	|	false : nothing to hash			|
+*/
+struct FingerprintSet {
+	BYTE imphash[Md5::digestSize];
+	BYTE rich[Md5::digestSize];
+	BYTE exports[Md5::digestSize];
+	bool hasImports;
+	bool hasRich;
+	bool hasExports;
+};
+
+/*
+| clustering hashes, each the MD5 of lower case text.         |
+| imphash : "module.function" joined with ',', the module    |
+|           without a .dll, .ocx or .sys extension and an     |
+|           ordinal as "ordN" unless the module is one whose  |
+|           ordinals are fixed (the pefile convention)       |
+| rich    : the Rich header XOR decoded, from DanS up to      |
+|           the Rich marker (pefile's rich header hash)       |
+| exports : the export names sorted and joined with ','      |
+| names are lowered through a small stack buffer straight    |
+| into the digest, nothing is allocated per name.            |
+*/
+class Fingerprint
+{
+public:
+	// in import table order
+	void addImport(std::string_view module, std::string_view function);
+	void addImport(std::string_view module, WORD ordinal);
+	void hashRich(const RichHeader& rich);
+	// names are sorted in place
+	void hashExports(std::vector<std::string_view>& names);
+
+	const FingerprintSet& final();
+
+	// the name an ordinal import is hashed under, nullptr for "ordN"
+	static const char* OrdinalName(std::string_view module, WORD ordinal);
+
+private:
+	void addModule(std::string_view module);
+	static void updateLower(Md5& md5, std::string_view text);
+
+private:
+	Md5 m_imports;
+	FingerprintSet m_set = {};
+};
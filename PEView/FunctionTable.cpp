@@ -0,0 +1,123 @@
+#include "FunctionTable.h"
+#include <cstring>
+#include <algorithm>
+
+void FunctionTable::clear()
+{
+	m_begin.clear();
+	m_entries.clear();
+}
+
+bool FunctionTable::parse(const BYTE* data, size_t size)
+{
+	clear();
+
+	size_t count = size / sizeof(IMAGE_RUNTIME_FUNCTION_ENTRY);
+	m_entries.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		IMAGE_RUNTIME_FUNCTION_ENTRY entry;
+		memcpy(&entry, data + i * sizeof(entry), sizeof(entry));
+		if (entry.BeginAddress < entry.EndAddress)
+			m_entries.push_back(entry);
+	}
+
+	// the linker sorts the table, the loader relies on it, a broken file may not
+	auto before = [](const IMAGE_RUNTIME_FUNCTION_ENTRY& a, const IMAGE_RUNTIME_FUNCTION_ENTRY& b) { return a.BeginAddress < b.BeginAddress; };
+	if (!std::is_sorted(m_entries.begin(), m_entries.end(), before))
+		std::sort(m_entries.begin(), m_entries.end(), before);
+
+	m_begin.resize(m_entries.size());
+	for (size_t i = 0; i < m_entries.size(); ++i)
+		m_begin[i] = m_entries[i].BeginAddress;
+	return !m_entries.empty();
+}
+
+size_t FunctionTable::candidate(DWORD rva) const
+{
+	// last begin <= rva, or 0; the loop count depends only on the size
+	const DWORD* base = m_begin.data();
+	size_t n = m_begin.size();
+	while (n > 1)
+	{
+		size_t half = n / 2;
+		base = base[half] <= rva ? base + half : base;
+		n -= half;
+	}
+	return base - m_begin.data();
+}
+
+size_t FunctionTable::find(DWORD rva) const
+{
+	if (m_entries.empty())
+		return npos;
+	size_t i = candidate(rva);
+	return m_entries[i].BeginAddress <= rva && rva < m_entries[i].EndAddress ? i : npos;
+}
+
+void FunctionTable::find(const DWORD* rvas, size_t* indices, size_t count) const
+{
+	if (m_entries.empty())
+	{
+		std::fill(indices, indices + count, npos);
+		return;
+	}
+
+	size_t done = 0;
+	for (; done + lanes <= count; done += lanes)
+	{
+		// every lane takes the same number of steps, so the loads of one step are independent
+		const DWORD* base[lanes];
+		for (size_t l = 0; l < lanes; ++l)
+			base[l] = m_begin.data();
+
+		size_t n = m_begin.size();
+		while (n > 1)
+		{
+			size_t half = n / 2;
+			for (size_t l = 0; l < lanes; ++l)
+				base[l] = base[l][half] <= rvas[done + l] ? base[l] + half : base[l];
+			n -= half;
+		}
+
+		for (size_t l = 0; l < lanes; ++l)
+		{
+			size_t i = base[l] - m_begin.data();
+			DWORD rva = rvas[done + l];
+			indices[done + l] = m_entries[i].BeginAddress <= rva && rva < m_entries[i].EndAddress ? i : npos;
+		}
+	}
+
+	for (; done < count; ++done)
+		indices[done] = find(rvas[done]);
+}
+
+bool FunctionTable::ReadUnwindInfo(const BYTE* data, size_t size, UnwindInfo& info)
+{
+	info = {};
+	if (size < 4)
+		return false;
+
+	info.version = data[0] & 7;
+	info.flags = data[0] >> 3;
+	info.prologSize = data[1];
+	info.codeCount = data[2];
+	info.frameRegister = data[3] & 15;
+	info.frameOffset = data[3] >> 4;
+
+	// the unwind codes are 2 bytes each, padded to an even count
+	size_t tail = 4 + ((info.codeCount + 1) & ~1) * 2;
+	if (info.flags & 4)
+	{
+		if (size < tail + sizeof(IMAGE_RUNTIME_FUNCTION_ENTRY))
+			return false;
+		memcpy(&info.chainBegin, data + tail, sizeof(DWORD));
+	}
+	else if (info.flags & 3)
+	{
+		if (size < tail + sizeof(DWORD))
+			return false;
+		memcpy(&info.handler, data + tail, sizeof(DWORD));
+	}
+	return true;
+}
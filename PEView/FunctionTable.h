@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <Windows.h>
+
+/*
+| header of an x64 UNWIND_INFO.                            |
+| chained entries continue the unwind of a parent         |
+| function, chainBegin is that function's BeginAddress.   |
+*/
+struct UnwindInfo {
+	BYTE version;
+	BYTE flags;				// UNW_FLAG_EHANDLER 1, UHANDLER 2, CHAININFO 4
+	BYTE prologSize;
+	BYTE codeCount;
+	BYTE frameRegister;
+	BYTE frameOffset;
+	DWORD handler;			// exception handler RVA when flags has EHANDLER or UHANDLER
+	DWORD chainBegin;		// parent BeginAddress when flags has CHAININFO
+};
+
+/*
+| x64 exception directory as a sorted array.               |
+| the begin addresses live in their own array so a lookup  |
+| only touches 4 bytes per probe; the search halves a      |
+| fixed length with a conditional move instead of a       |
+| branch, and the batch lookup runs several searches in    |
+| lockstep so their cache misses overlap.                  |
+*/
+class FunctionTable
+{
+public:
+	static constexpr size_t npos = (size_t)-1;
+	static constexpr size_t lanes = 8;		// searches interleaved by the batch lookup
+
+public:
+	void clear();
+	bool parse(const BYTE* data, size_t size);
+
+	size_t size() const { return m_entries.size(); }
+	const IMAGE_RUNTIME_FUNCTION_ENTRY& entry(size_t index) const { return m_entries[index]; }
+
+	// index of the function containing rva, npos if none
+	size_t find(DWORD rva) const;
+	void find(const DWORD* rvas, size_t* indices, size_t count) const;
+
+	static bool ReadUnwindInfo(const BYTE* data, size_t size, UnwindInfo& info);
+
+private:
+	size_t candidate(DWORD rva) const;
+
+private:
+	std::vector<DWORD> m_begin;
+	std::vector<IMAGE_RUNTIME_FUNCTION_ENTRY> m_entries;
+};
@@ -0,0 +1,269 @@
+#include "HexDump.h"
+#include <cstring>
+#include <algorithm>
+#include <intrin.h>
+#include <immintrin.h>
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+// 0x21 ~ 0x7F are printed as is, everything else as '.'
+static inline char printable(BYTE c)
+{
+	return (c > 0x20 && c < 0x80) ? (char)c : '.';
+}
+
+// "XX " per byte, one more space after the 8th and the 16th byte
+static inline char* encodeHex(const BYTE* src, size_t count, char* out)
+{
+	for (size_t j = 0; j < count; ++j)
+	{
+		*out++ = hexDigits[src[j] >> 4];
+		*out++ = hexDigits[src[j] & 0x0F];
+		*out++ = ' ';
+		if (j == 7 || j == 15)
+			*out++ = ' ';
+	}
+	return out;
+}
+
+static inline char* encodeRaw(const BYTE* src, size_t count, char* out)
+{
+	for (size_t j = 0; j < count; ++j)
+		*out++ = printable(src[j]);
+	return out;
+}
+
+void HexDump::dump(OutputSink& out, DumpMode mode, const void* data, int size, int first_offset, int interval, int size_of_element)
+{
+	static const RowKernel kernel = selectKernel();
+
+	size_t total = (size > 0 && size_of_element > 0) ? (size_t)size * size_of_element : 0;
+	size_t chunk = rowsPerBuffer * 16;
+
+	for (size_t begin = 0; begin < total; begin += chunk)
+	{
+		size_t count = (std::min)(chunk, total - begin);
+		const BYTE* src = gather((const BYTE*)data, begin, count, first_offset, interval, size_of_element);
+
+		// the vector kernels store 16 bytes at a time and may run past the row end
+		char* buffer = out.reserve(rowsPerBuffer * maxRowLength + 64);
+
+		size_t rows = count / 16;
+		char* end = kernel(mode, src, rows, buffer);
+		if (count % 16)
+			end = encodeTail(mode, src + rows * 16, count % 16, end);
+		else if (begin + count == total)
+			--end;	// no line break after the last row
+
+		out.commit(end);
+	}
+
+	out.write("\n\n", 2);
+}
+
+const BYTE* HexDump::gather(const BYTE* data, size_t begin, size_t count, int first_offset, int interval, int size_of_element)
+{
+	if (interval == size_of_element)
+		return data + first_offset + begin;
+
+	// strided tables (INT, EAT, ...) are packed into a contiguous block first
+	m_gather.resize(count);
+	size_t element = begin / size_of_element;
+	size_t skip = begin % size_of_element;
+	size_t done = 0;
+	while (done < count)
+	{
+		size_t length = (std::min)((size_t)size_of_element - skip, count - done);
+		memcpy(&m_gather[done], data + first_offset + element * interval + skip, length);
+		done += length;
+		skip = 0;
+		++element;
+	}
+	return m_gather.data();
+}
+
+HexDump::RowKernel HexDump::selectKernel()
+{
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool ssse3 = (info[2] & (1 << 9)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	if (avx2)
+		return encodeRowsAVX2;
+	if (ssse3)
+		return encodeRowsSSSE3;
+	return encodeRowsScalar;
+}
+
+char* HexDump::encodeRowsScalar(DumpMode mode, const BYTE* src, size_t rows, char* out)
+{
+	for (size_t r = 0; r < rows; ++r, src += 16)
+	{
+		if (mode != DumpMode::Raw)
+			out = encodeHex(src, 16, out);
+		if (mode != DumpMode::Byte)
+			out = encodeRaw(src, 16, out);
+		*out++ = '\n';
+	}
+	return out;
+}
+
+char* HexDump::encodeTail(DumpMode mode, const BYTE* src, size_t count, char* out)
+{
+	if (mode != DumpMode::Raw)
+	{
+		char* begin = out;
+		out = encodeHex(src, count, out);
+
+		// the ASCII column always starts at column 50
+		if (mode == DumpMode::ByteAndRaw)
+		{
+			memset(out, ' ', 50 - (out - begin));
+			out = begin + 50;
+		}
+	}
+	if (mode != DumpMode::Byte)
+		out = encodeRaw(src, count, out);
+	return out;
+}
+
+/*
+| hex layout of 8 bytes held as 16 digits "HLHL..."     |
+| first store  : output columns  0 ~ 15                 |
+| second store : output columns 16 ~ 24, rest is spaces |
+| 0x80 selects zero, which is then or'ed with a space   |
+*/
+#define X 0x80
+#define SP ' '
+#define LAYOUT_LO 0, 1, X, 2, 3, X, 4, 5, X, 6, 7, X, 8, 9, X, 10
+#define LAYOUT_HI 11, X, 12, 13, X, 14, 15, X, X, X, X, X, X, X, X, X
+#define SPACE_LO 0, 0, SP, 0, 0, SP, 0, 0, SP, 0, 0, SP, 0, 0, SP, 0
+#define SPACE_HI 0, SP, 0, 0, SP, 0, 0, SP, SP, SP, SP, SP, SP, SP, SP, SP
+
+char* HexDump::encodeRowsSSSE3(DumpMode mode, const BYTE* src, size_t rows, char* out)
+{
+	const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	const __m128i control = _mm_set1_epi8(0x20);
+	const __m128i dot = _mm_set1_epi8('.');
+	const __m128i layoutLo = _mm_setr_epi8(LAYOUT_LO);
+	const __m128i layoutHi = _mm_setr_epi8(LAYOUT_HI);
+	const __m128i spaceLo = _mm_setr_epi8(SPACE_LO);
+	const __m128i spaceHi = _mm_setr_epi8(SPACE_HI);
+
+	for (size_t r = 0; r < rows; ++r, src += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)src);
+
+		if (mode != DumpMode::Raw)
+		{
+			__m128i hi = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+			__m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(v, nibble));
+			__m128i a = _mm_unpacklo_epi8(hi, lo);
+			__m128i b = _mm_unpackhi_epi8(hi, lo);
+
+			_mm_storeu_si128((__m128i*)(out + 0), _mm_or_si128(_mm_shuffle_epi8(a, layoutLo), spaceLo));
+			_mm_storeu_si128((__m128i*)(out + 16), _mm_or_si128(_mm_shuffle_epi8(a, layoutHi), spaceHi));
+			_mm_storeu_si128((__m128i*)(out + 25), _mm_or_si128(_mm_shuffle_epi8(b, layoutLo), spaceLo));
+			_mm_storeu_si128((__m128i*)(out + 41), _mm_or_si128(_mm_shuffle_epi8(b, layoutHi), spaceHi));
+			out += 50;
+		}
+
+		if (mode != DumpMode::Byte)
+		{
+			// signed compare : 0x80 ~ 0xFF are negative and fail like 0x00 ~ 0x20
+			__m128i mask = _mm_cmpgt_epi8(v, control);
+			_mm_storeu_si128((__m128i*)out, _mm_or_si128(_mm_and_si128(mask, v), _mm_andnot_si128(mask, dot)));
+			out += 16;
+		}
+
+		*out++ = '\n';
+	}
+	return out;
+}
+
+char* HexDump::encodeRowsAVX2(DumpMode mode, const BYTE* src, size_t rows, char* out)
+{
+	const __m256i digits = _mm256_setr_epi8(
+		'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+		'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F');
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	const __m256i control = _mm256_set1_epi8(0x20);
+	const __m256i dot = _mm256_set1_epi8('.');
+	const __m256i layoutLo = _mm256_setr_epi8(LAYOUT_LO, LAYOUT_LO);
+	const __m256i layoutHi = _mm256_setr_epi8(LAYOUT_HI, LAYOUT_HI);
+	const __m256i spaceLo = _mm256_setr_epi8(SPACE_LO, SPACE_LO);
+	const __m256i spaceHi = _mm256_setr_epi8(SPACE_HI, SPACE_HI);
+
+	// one row per 128-bit lane, every shuffle stays inside its lane
+	size_t r = 0;
+	for (; r + 2 <= rows; r += 2, src += 32)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)src);
+		__m256i hex[4];
+		__m256i raw;
+
+		if (mode != DumpMode::Raw)
+		{
+			__m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+			__m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, nibble));
+			__m256i a = _mm256_unpacklo_epi8(hi, lo);
+			__m256i b = _mm256_unpackhi_epi8(hi, lo);
+
+			hex[0] = _mm256_or_si256(_mm256_shuffle_epi8(a, layoutLo), spaceLo);
+			hex[1] = _mm256_or_si256(_mm256_shuffle_epi8(a, layoutHi), spaceHi);
+			hex[2] = _mm256_or_si256(_mm256_shuffle_epi8(b, layoutLo), spaceLo);
+			hex[3] = _mm256_or_si256(_mm256_shuffle_epi8(b, layoutHi), spaceHi);
+		}
+
+		if (mode != DumpMode::Byte)
+		{
+			__m256i mask = _mm256_cmpgt_epi8(v, control);
+			raw = _mm256_or_si256(_mm256_and_si256(mask, v), _mm256_andnot_si256(mask, dot));
+		}
+
+		// the lanes are written in order, each store may spill into the next row
+		for (int lane = 0; lane < 2; ++lane)
+		{
+			if (mode != DumpMode::Raw)
+			{
+				_mm_storeu_si128((__m128i*)(out + 0), lane ? _mm256_extracti128_si256(hex[0], 1) : _mm256_castsi256_si128(hex[0]));
+				_mm_storeu_si128((__m128i*)(out + 16), lane ? _mm256_extracti128_si256(hex[1], 1) : _mm256_castsi256_si128(hex[1]));
+				_mm_storeu_si128((__m128i*)(out + 25), lane ? _mm256_extracti128_si256(hex[2], 1) : _mm256_castsi256_si128(hex[2]));
+				_mm_storeu_si128((__m128i*)(out + 41), lane ? _mm256_extracti128_si256(hex[3], 1) : _mm256_castsi256_si128(hex[3]));
+				out += 50;
+			}
+
+			if (mode != DumpMode::Byte)
+			{
+				_mm_storeu_si128((__m128i*)out, lane ? _mm256_extracti128_si256(raw, 1) : _mm256_castsi256_si128(raw));
+				out += 16;
+			}
+
+			*out++ = '\n';
+		}
+	}
+
+	if (r < rows)
+		out = encodeRowsSSSE3(mode, src, rows - r, out);
+	return out;
+}
+
+#undef X
+#undef SP
+#undef LAYOUT_LO
+#undef LAYOUT_HI
+#undef SPACE_LO
+#undef SPACE_HI
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <Windows.h>
+#include "OutputSink.h"
+
+enum class DumpMode {
+	Byte,			// "XX XX XX XX XX XX XX XX  XX ..."
+	Raw,			// printable ASCII, '.' otherwise
+	ByteAndRaw		// hex columns followed by the ASCII column
+};
+
+/*
+| hex / ASCII dump used by the -B, -R and -RB options.    |
+| whole 16-byte rows are encoded by a vector kernel       |
+| (AVX2 or SSSE3, picked once with cpuid) straight into   |
+| the output sink buffer, one block of rows at a time.    |
+| the last partial row always goes through the scalar     |
+| encoder so the layout matches the original printers.    |
+*/
+class HexDump
+{
+public:
+	// element k of the dump starts at data + first_offset + k * interval
+	// and is size_of_element bytes long
+	void dump(OutputSink& out, DumpMode mode, const void* data, int size, int first_offset = 0, int interval = 1, int size_of_element = 1);
+
+public:
+	static constexpr size_t rowsPerBuffer = 1024;
+	static constexpr size_t maxRowLength = 50 + 16 + 1;
+
+	typedef char* (*RowKernel)(DumpMode mode, const BYTE* src, size_t rows, char* out);
+
+private:
+	const BYTE* gather(const BYTE* data, size_t begin, size_t count, int first_offset, int interval, int size_of_element);
+
+	static RowKernel selectKernel();
+	static char* encodeRowsScalar(DumpMode mode, const BYTE* src, size_t rows, char* out);
+	static char* encodeRowsSSSE3(DumpMode mode, const BYTE* src, size_t rows, char* out);
+	static char* encodeRowsAVX2(DumpMode mode, const BYTE* src, size_t rows, char* out);
+	static char* encodeTail(DumpMode mode, const BYTE* src, size_t count, char* out);
+
+private:
+	std::vector<BYTE> m_gather;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <Windows.h>
+
+/*
+| everything that differs between PE32 and PE32+.          |
+| the header, thunk and optional header code is templated  |
+| on one of these, so each bitness gets its own loops and  |
+| the only runtime choice is made once, at load time.      |
+*/
+struct PE32Traits
+{
+	typedef DWORD Thunk;
+	typedef IMAGE_NT_HEADERS32 NtHeaders;
+
+	static constexpr Thunk ordinalFlag = IMAGE_ORDINAL_FLAG32;
+	static constexpr int thunkDigits = 8;			// hex digits of a thunk or pointer sized field
+	static constexpr bool hasBaseOfData = true;
+
+	static constexpr const char* optionalHeaderName = "IMAGE_OPTIONAL_HEADER32";
+	static constexpr const char* magicName = "IMAGE_NT_OPTIONAL_HDR32_MAGIC";
+};
+
+struct PE64Traits
+{
+	typedef ULONGLONG Thunk;
+	typedef IMAGE_NT_HEADERS64 NtHeaders;
+
+	static constexpr Thunk ordinalFlag = IMAGE_ORDINAL_FLAG64;
+	static constexpr int thunkDigits = 16;
+	static constexpr bool hasBaseOfData = false;
+
+	static constexpr const char* optionalHeaderName = "IMAGE_OPTIONAL_HEADER64";
+	static constexpr const char* magicName = "IMAGE_NT_OPTIONAL_HDR64_MAGIC";
+};
@@ -0,0 +1,153 @@
+#include "JsonWriter.h"
+#include <cstdio>
+#include <cstring>
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+// 0 : copied as is, 'u' : \u00XX, anything else : two character escape
+struct EscapeTable {
+	char map[256];
+
+	EscapeTable()
+	{
+		for (int c = 0; c < 256; ++c)
+			map[c] = (c < 0x20 || c >= 0x7F) ? 'u' : 0;
+		map['"'] = '"';
+		map['\\'] = '\\';
+		map['\b'] = 'b';
+		map['\f'] = 'f';
+		map['\n'] = 'n';
+		map['\r'] = 'r';
+		map['\t'] = 't';
+	}
+};
+
+static const EscapeTable escapes;
+
+void JsonWriter::separator()
+{
+	if (m_comma)
+		m_out.put(',');
+	m_comma = true;
+}
+
+void JsonWriter::beginObject()
+{
+	separator();
+	m_out.put('{');
+	m_comma = false;
+}
+
+void JsonWriter::endObject()
+{
+	m_out.put('}');
+	m_comma = true;
+}
+
+void JsonWriter::beginArray()
+{
+	separator();
+	m_out.put('[');
+	m_comma = false;
+}
+
+void JsonWriter::endArray()
+{
+	m_out.put(']');
+	m_comma = true;
+}
+
+void JsonWriter::key(std::string_view name)
+{
+	separator();
+	string(name);
+	m_out.put(':');
+	m_comma = false;
+}
+
+void JsonWriter::value(std::string_view text)
+{
+	separator();
+	string(text);
+}
+
+void JsonWriter::value(ULONGLONG number)
+{
+	separator();
+
+	char digits[20];
+	int length = 0;
+	do {
+		digits[sizeof(digits) - ++length] = '0' + number % 10;
+		number /= 10;
+	} while (number);
+	m_out.write(digits + sizeof(digits) - length, length);
+}
+
+void JsonWriter::real(double number)
+{
+	separator();
+
+	char text[32];
+	int length = snprintf(text, sizeof(text), "%.4f", number);
+	m_out.write(text, length);
+}
+
+void JsonWriter::boolean(bool flag)
+{
+	separator();
+	if (flag)
+		m_out.write("true", 4);
+	else
+		m_out.write("false", 5);
+}
+
+void JsonWriter::null()
+{
+	separator();
+	m_out.write("null", 4);
+}
+
+void JsonWriter::endLine()
+{
+	m_out.put('\n');
+	m_comma = false;
+}
+
+void JsonWriter::string(std::string_view text)
+{
+	// worst case every byte becomes \u00XX
+	char* out = m_out.reserve(text.size() * 6 + 2);
+	*out++ = '"';
+
+	const BYTE* p = reinterpret_cast<const BYTE*>(text.data());
+	const BYTE* end = p + text.size();
+	while (p < end)
+	{
+		// copy the run of plain characters in one go
+		const BYTE* run = p;
+		while (p < end && !escapes.map[*p])
+			++p;
+		memcpy(out, run, p - run);
+		out += p - run;
+		if (p == end)
+			break;
+
+		char e = escapes.map[*p];
+		*out++ = '\\';
+		if (e == 'u')
+		{
+			*out++ = 'u';
+			*out++ = '0';
+			*out++ = '0';
+			*out++ = hexDigits[*p >> 4];
+			*out++ = hexDigits[*p & 0x0F];
+		}
+		else
+			*out++ = e;
+		++p;
+	}
+
+	*out++ = '"';
+	m_out.commit(out);
+}
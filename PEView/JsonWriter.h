@@ -0,0 +1,47 @@
+#pragma once
+#include <string_view>
+#include <Windows.h>
+#include "OutputSink.h"
+
+/*
+| streaming JSON writer on top of an OutputSink.          |
+| nothing is built in memory : every call appends text,   |
+| the only state is whether the next value needs a comma. |
+| strings are escaped straight into the sink, bytes that  |
+| are not printable ASCII are written as \u00XX so names  |
+| read from arbitrary files always give valid JSON.       |
+*/
+class JsonWriter
+{
+public:
+	JsonWriter(OutputSink& out) : m_out(out) {}
+
+public:
+	void beginObject();
+	void endObject();
+	void beginArray();
+	void endArray();
+
+	void key(std::string_view name);
+	void value(std::string_view text);
+	void value(const char* text) { value(std::string_view(text)); }
+	void value(ULONGLONG number);
+	void boolean(bool flag);
+	void real(double number);		// four decimals, entropy and the like
+	void null();
+
+	// key and value in one call
+	template <typename T>
+	void field(std::string_view name, const T& v) { key(name); value(v); }
+
+	// ends one NDJSON record
+	void endLine();
+
+private:
+	void separator();
+	void string(std::string_view text);
+
+private:
+	OutputSink& m_out;
+	bool m_comma = false;
+};
@@ -0,0 +1,82 @@
+#include "MappedFile.h"
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& filePath)
+{
+	close();
+
+	m_file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart <= 0)
+	{
+		close();
+		return false;
+	}
+	m_size = static_cast<ULONGLONG>(size.QuadPart);
+
+	// an empty or locked file cannot be mapped, the caller falls back to ifstream
+	m_mapping = CreateFileMapping(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping)
+	{
+		close();
+		return false;
+	}
+
+	m_base = static_cast<const BYTE*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!m_base)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_base)
+		UnmapViewOfFile(m_base);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+
+	m_base = nullptr;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+	m_size = 0;
+}
+
+bool MappedFile::contains(ULONGLONG offset, ULONGLONG size) const
+{
+	return m_base && offset <= m_size && size <= m_size - offset;
+}
+
+const BYTE* MappedFile::view(ULONGLONG offset, ULONGLONG size) const
+{
+	if (!contains(offset, size))
+		return nullptr;
+	return m_base + offset;
+}
+
+const char* MappedFile::cstr(ULONGLONG offset, size_t* length) const
+{
+	if (!m_base || offset >= m_size)
+		return nullptr;
+
+	const char* str = reinterpret_cast<const char*>(m_base + offset);
+	const void* end = memchr(str, '\0', static_cast<size_t>(m_size - offset));
+	if (!end)
+		return nullptr;
+
+	if (length)
+		*length = static_cast<const char*>(end) - str;
+	return str;
+}
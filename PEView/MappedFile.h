@@ -0,0 +1,75 @@
+#pragma once
+#include <string>
+#include <Windows.h>
+
+/*
+| read-only view over a whole file mapped with MapViewOfFile |
+| every accessor is bounds-checked against the file size and  |
+| returns nullptr instead of reading past the mapping.        |
+*/
+template <typename T>
+struct MappedSpan {
+	const T* ptr = nullptr;
+	size_t count = 0;
+
+	const T* begin() const { return ptr; }
+	const T* end() const { return ptr + count; }
+	const T& operator[](size_t i) const { return ptr[i]; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+};
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+	bool open(const std::string& filePath);
+	void close();
+
+	bool isOpen() const { return m_base != nullptr; }
+	const BYTE* data() const { return m_base; }
+	ULONGLONG size() const { return m_size; }
+
+	// bounds-checked access
+	bool contains(ULONGLONG offset, ULONGLONG size) const;
+	const BYTE* view(ULONGLONG offset, ULONGLONG size) const;
+	const char* cstr(ULONGLONG offset, size_t* length = nullptr) const;
+
+	template <typename T>
+	const T* as(ULONGLONG offset) const
+	{
+		return reinterpret_cast<const T*>(view(offset, sizeof(T)));
+	}
+
+	template <typename T>
+	MappedSpan<T> span(ULONGLONG offset, size_t count) const
+	{
+		MappedSpan<T> s;
+		if (count > 0 && count <= m_size / sizeof(T))
+			s.ptr = reinterpret_cast<const T*>(view(offset, sizeof(T) * count));
+		s.count = s.ptr ? count : 0;
+		return s;
+	}
+
+	template <typename T>
+	bool read(ULONGLONG offset, T& out) const
+	{
+		const T* p = as<T>(offset);
+		if (!p)
+			return false;
+		memcpy(&out, p, sizeof(T));
+		return true;
+	}
+
+private:
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+	const BYTE* m_base = nullptr;
+	ULONGLONG m_size = 0;
+};
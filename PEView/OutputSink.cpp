@@ -0,0 +1,166 @@
+#include "OutputSink.h"
+#include <algorithm>
+#include <cstring>
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+OutputSink::OutputSink(FILE* stream, size_t capacity)
+	: m_stream(stream), m_buffer(capacity)
+{
+}
+
+OutputSink::~OutputSink()
+{
+	flush();
+}
+
+char* OutputSink::reserve(size_t length)
+{
+	if (m_used + length > m_buffer.size())
+	{
+		flush();
+		if (m_used + length > m_buffer.size())
+			m_buffer.resize((std::max)(m_used + length, m_buffer.size() * 2));
+	}
+	return m_buffer.data() + m_used;
+}
+
+void OutputSink::flush()
+{
+	// a sink without a stream only grows, the owner takes the text with view()
+	if (!m_used || !m_stream)
+		return;
+	fwrite(m_buffer.data(), 1, m_used, m_stream);
+	fflush(m_stream);
+	m_written += m_used;
+	m_used = 0;
+}
+
+void OutputSink::put(char c)
+{
+	if (m_used == m_buffer.size())
+		reserve(1);
+	m_buffer[m_used++] = c;
+}
+
+void OutputSink::write(const char* data, size_t length)
+{
+	char* out = reserve(length);
+	memcpy(out, data, length);
+	m_used += length;
+}
+
+void OutputSink::str(std::string_view s)
+{
+	write(s.data(), s.size());
+}
+
+void OutputSink::line(std::string_view s)
+{
+	str(s);
+	put('\n');
+}
+
+void OutputSink::fill(char c, size_t count)
+{
+	char* out = reserve(count);
+	memset(out, c, count);
+	m_used += count;
+}
+
+void OutputSink::rule(size_t width)
+{
+	char* out = reserve(width + 1);
+	memset(out, '-', width);
+	out[width] = '\n';
+	m_used += width + 1;
+}
+
+void OutputSink::left(std::string_view s, int width)
+{
+	size_t length = s.size();
+	char* out = reserve(length > (size_t)width ? length : width);
+	memcpy(out, s.data(), length);
+	if (length < (size_t)width)
+	{
+		memset(out + length, ' ', width - length);
+		length = width;
+	}
+	m_used += length;
+}
+
+void OutputSink::right(std::string_view s, int width)
+{
+	size_t length = s.size();
+	size_t pad = length < (size_t)width ? width - length : 0;
+	char* out = reserve(pad + length);
+	memset(out, ' ', pad);
+	memcpy(out + pad, s.data(), length);
+	m_used += pad + length;
+}
+
+int OutputSink::formatHex(char* out, ULONGLONG value, int digits)
+{
+	int length = 1;
+	for (ULONGLONG v = value >> 4; v; v >>= 4)
+		++length;
+	if (length < digits)
+		length = digits;
+
+	out[length] = '\0';
+	for (int i = length - 1; i >= 0; --i, value >>= 4)
+		out[i] = hexDigits[value & 0x0F];
+	return length;
+}
+
+void OutputSink::hex(ULONGLONG value, int digits)
+{
+	// 16 digits for the value, one more for the NUL formatHex appends
+	char* out = reserve((digits > 16 ? digits : 16) + 1);
+	m_used += formatHex(out, value, digits);
+}
+
+void OutputSink::columns(std::string_view desc, int descWidth, std::string_view value, int valueWidth)
+{
+	write(" | ", 3);
+	left(desc, descWidth);
+	write(" | ", 3);
+	left(value, valueWidth);
+	put('\n');
+}
+
+void OutputSink::row(const RowFormat& format, ULONGLONG data, std::string_view desc, std::string_view value)
+{
+	spaces(format.indent);
+	hex(data, format.digits);
+	columns(desc, format.desc, value, format.value);
+}
+
+void OutputSink::row(const RowFormat& format, std::string_view data, std::string_view desc, std::string_view value)
+{
+	spaces(format.indent);
+	right(data, format.digits);
+	columns(desc, format.desc, value, format.value);
+}
+
+void OutputSink::row(const RowFormat& format, ULONGLONG data, std::string_view desc, ULONGLONG number, std::string_view name)
+{
+	spaces(format.indent);
+	hex(data, format.digits);
+	write(" | ", 3);
+	left(desc, format.desc);
+	write(" | ", 3);
+
+	char text[24];
+	int length = formatHex(text, number, 4);
+	text[length++] = ' ';
+	write(text, length);
+	left(name, format.value > length ? format.value - length : 0);
+	put('\n');
+}
+
+void OutputSink::header(int data, int desc, int value)
+{
+	left("Data", data);
+	columns("Description", desc, "Value", value);
+}
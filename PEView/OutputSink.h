@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdio>
+#include <string_view>
+#include <vector>
+#include <Windows.h>
+
+/*
+| one table row : "<indent><data> | <desc> | <value>\n"   |
+| data is printed as upper case hex with at least digits  |
+| digits, or right aligned in digits columns for strings. |
+| desc and value are left aligned and never truncated.    |
+*/
+struct RowFormat {
+	int indent;
+	int digits;
+	int desc;
+	int value;
+};
+
+/*
+| buffered writer for everything the table printers emit. |
+| output is collected in one reusable buffer and handed   |
+| to the stream with a single fwrite when it fills up or  |
+| when flush() is called, nothing flushes per line.       |
+| with a null stream the buffer grows instead and the     |
+| owner takes the text with view() and clear().           |
+*/
+class OutputSink
+{
+public:
+	OutputSink(FILE* stream = stdout, size_t capacity = 1 << 18);
+	~OutputSink();
+
+	OutputSink(const OutputSink&) = delete;
+	OutputSink& operator=(const OutputSink&) = delete;
+
+public:
+	void put(char c);
+	void write(const char* data, size_t length);
+	void str(std::string_view s);
+	void line(std::string_view s);
+	void newline() { put('\n'); }
+	void spaces(size_t count) { fill(' ', count); }
+	void fill(char c, size_t count);
+	void rule(size_t width);
+
+	void left(std::string_view s, int width);	// %-*s
+	void right(std::string_view s, int width);	// %*s
+	void hex(ULONGLONG value, int digits);	// %0*llX
+
+	void row(const RowFormat& format, ULONGLONG data, std::string_view desc, std::string_view value);
+	void row(const RowFormat& format, std::string_view data, std::string_view desc, std::string_view value);
+	// value column "%04X %s"
+	void row(const RowFormat& format, ULONGLONG data, std::string_view desc, ULONGLONG number, std::string_view name);
+	void header(int data, int desc, int value);
+
+	// direct access for bulk encoders, commit() takes the end of what was written
+	char* reserve(size_t length);
+	void commit(char* end) { m_used = end - m_buffer.data(); }
+
+	void flush();
+	size_t written() const { return m_written + m_used; }
+
+	std::string_view view() const { return std::string_view(m_buffer.data(), m_used); }
+	void clear() { m_used = 0; }
+
+	// writes at least digits upper case hex digits and a terminating NUL, returns the length
+	static int formatHex(char* out, ULONGLONG value, int digits);
+
+private:
+	void columns(std::string_view desc, int descWidth, std::string_view value, int valueWidth);
+
+private:
+	FILE* m_stream;
+	std::vector<char> m_buffer;
+	size_t m_used = 0;
+	size_t m_written = 0;
+};
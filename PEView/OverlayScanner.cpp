@@ -0,0 +1,120 @@
+#include "OverlayScanner.h"
+#include "Entropy.h"
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+
+struct Signature {
+	const char* name;
+	BYTE bytes[16];
+	size_t length;
+	size_t lead;		// bytes of the structure in front of the signature
+};
+
+static const Signature signatures[OverlayScanner::formatCount] = {
+	// local file header of the first entry
+	{ "ZIP", { 'P', 'K', 3, 4 }, 4, 0 },
+	{ "7z", { '7', 'z', 0xBC, 0xAF, 0x27, 0x1C }, 6, 0 },
+	// CFHEADER, reserved1 is zero
+	{ "CAB", { 'M', 'S', 'C', 'F', 0, 0, 0, 0 }, 8, 0 },
+	// firstheader : flags, then 0xDEADBEEF and "NullsoftInst"
+	{ "NSIS", { 0xEF, 0xBE, 0xAD, 0xDE, 'N', 'u', 'l', 'l', 's', 'o', 'f', 't', 'I', 'n', 's', 't' }, 16, 4 },
+};
+
+static const BYTE* search(const BYTE* data, size_t size, const Signature& signature)
+{
+	const BYTE* end = data + size;
+	for (const BYTE* p = data; (size_t)(end - p) >= signature.length; ++p)
+	{
+		p = (const BYTE*)memchr(p, signature.bytes[0], (end - p) - signature.length + 1);
+		if (!p)
+			return nullptr;
+		if (memcmp(p + 1, signature.bytes + 1, signature.length - 1) == 0)
+			return p;
+	}
+	return nullptr;
+}
+
+void OverlayScanner::reset()
+{
+	memset(m_counts, 0, sizeof(m_counts));
+	std::fill(std::begin(m_found), std::end(m_found), npos);
+	m_size = 0;
+	m_tailSize = 0;
+}
+
+void OverlayScanner::update(const BYTE* data, size_t size)
+{
+	if (size == 0)
+		return;
+
+	ULONGLONG counts[256];
+	Entropy::Histogram(data, size, counts, false);
+	for (int b = 0; b < 256; ++b)
+		m_counts[b] += counts[b];
+
+	auto record = [this](int format, ULONGLONG offset) {
+		size_t lead = signatures[format].lead;
+		m_found[format] = offset >= lead ? offset - lead : 0;
+	};
+
+	// signatures that start in the tail of the chunk before and end in this one
+	if (m_tailSize)
+	{
+		BYTE joined[2 * (maxSignature - 1)];
+		size_t head = (std::min)(size, maxSignature - 1);
+		memcpy(joined, m_tail, m_tailSize);
+		memcpy(joined + m_tailSize, data, head);
+		for (int f = 0; f < formatCount; ++f)
+		{
+			if (m_found[f] != npos)
+				continue;
+			const BYTE* p = search(joined, m_tailSize + head, signatures[f]);
+			if (p && (size_t)(p - joined) < m_tailSize)
+				record(f, m_size - m_tailSize + (p - joined));
+		}
+	}
+	for (int f = 0; f < formatCount; ++f)
+	{
+		if (m_found[f] != npos)
+			continue;
+		if (const BYTE* p = search(data, size, signatures[f]))
+			record(f, m_size + (p - data));
+	}
+
+	// keep the last maxSignature - 1 bytes of everything seen
+	if (size >= maxSignature - 1)
+	{
+		memcpy(m_tail, data + size - (maxSignature - 1), maxSignature - 1);
+		m_tailSize = maxSignature - 1;
+	}
+	else
+	{
+		size_t keep = (std::min)(m_tailSize, maxSignature - 1 - size);
+		memmove(m_tail, m_tail + m_tailSize - keep, keep);
+		memcpy(m_tail + keep, data, size);
+		m_tailSize = keep + size;
+	}
+	m_size += size;
+}
+
+double OverlayScanner::entropy() const
+{
+	return Entropy::FromHistogram(m_counts, m_size);
+}
+
+OverlayScanner::Format OverlayScanner::first() const
+{
+	Format format = formatCount;
+	for (int f = 0; f < formatCount; ++f)
+	{
+		if (m_found[f] != npos && (format == formatCount || m_found[f] < m_found[format]))
+			format = (Format)f;
+	}
+	return format;
+}
+
+const char* OverlayScanner::FormatName(Format format)
+{
+	return format < formatCount ? signatures[format].name : "";
+}
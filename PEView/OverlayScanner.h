@@ -0,0 +1,57 @@
+#pragma once
+#include <Windows.h>
+
+/*
+| offset		8byte	|	end of the raw data of the last section,	|
+|						|	past a certificate table that leads		|
+| size			8byte	|	0 : no overlay								|
+| certificate*	8byte	|	the certificate table if it lies past	|
+|						|	the sections, size 0 if not				|
+*/
+struct OverlayInfo {
+	ULONGLONG offset;
+	ULONGLONG size;
+	ULONGLONG certificateOffset;
+	ULONGLONG certificateSize;
+};
+
+/*
+| streaming analysis of the overlay : byte histogram and     |
+| the first offset of each archive signature. update() takes |
+| the overlay in order in chunks of any size and keeps only  |
+| the histogram and the last few bytes of the chunk before,  |
+| so signatures that straddle two chunks are still found.    |
+| each signature is searched with memchr on its first byte   |
+| and dropped once found.                                    |
+*/
+class OverlayScanner
+{
+public:
+	static constexpr size_t chunkSize = 256 * 1024;
+	static constexpr ULONGLONG npos = ~0ull;
+
+	enum Format { formatZip, formatSevenZip, formatCab, formatNsis, formatCount };
+
+public:
+	OverlayScanner() { reset(); }
+	void reset();
+	void update(const BYTE* data, size_t size);
+
+	ULONGLONG size() const { return m_size; }
+	double entropy() const;
+	// from the start of the overlay, npos if the signature does not occur
+	ULONGLONG find(Format format) const { return m_found[format]; }
+	// the format whose signature comes first, formatCount if none
+	Format first() const;
+
+	static const char* FormatName(Format format);
+
+private:
+	static constexpr size_t maxSignature = 16;
+
+	ULONGLONG m_counts[256];
+	ULONGLONG m_found[formatCount];
+	ULONGLONG m_size;
+	BYTE m_tail[maxSignature - 1];		// the last bytes of the data so far
+	size_t m_tailSize;
+};
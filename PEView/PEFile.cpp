@@ -1,202 +1,1036 @@
 #define _CRT_SECURE_NO_WARNINGS
 #include "PEFile.h"
+#include "AllocationCounter.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <ctime>
 #include <algorithm>
+#include <chrono>
 
-PEFile::PEFile(const std::string& filePath)
+template <typename Source>
+bool PEFile::load(Source& source)
 {
+	if (!readDosHeader(source)) {
+		return fail("DOS header дµ Ͽϴ.");
+	}
+	if (m_dosHeader.e_magic != IMAGE_DOS_SIGNATURE) {
+		return fail("ȿ  DOS header Դϴ.");
+	}
+	if (!readDosStub(source)) {
+		return fail("DOS Stub дµ Ͽϴ.");
+	}
+	if (!readNtHeaders(source)) {
+		return fail("NT Headers дµ Ͽϴ.");
+	}
+	if (std::visit([](const auto& model) { return model.ntHeaders.Signature; }, m_model) != IMAGE_NT_SIGNATURE) {
+		return fail("ȿ  NT header Դϴ.");
+	}
+	if (!readSectionHeaders(source)) {
+		return fail("Section Header дµ Ͽϴ.");
+	}
+	m_sectionIndex.build(m_sectionHeaders, std::visit([](const auto& model) { return model.ntHeaders.OptionalHeader.SizeOfHeaders; }, m_model));
+
+	return true;
+}
+
+// SH -e : sliding window over the section's raw data
+static const size_t entropyWindow = 0x1000;
+static const size_t entropyStep = 0x800;
+
+// ordinals are WORDs, no export table indexes more functions than that
+static const DWORD maxExportFunctions = 0x10000;
+
+// thunks per read when a lookup table is read through the ifstream fallback
+static const size_t thunkBlock = 64;
+
+static const char* const commandNames[] = {
+	"DOS", "STUB", "RICH", "NT", "SH", "IDT", "INT", "IAT", "DIDT", "DINT", "IED", "EAT", "ENT", "EOT", "EXP", "RES", "RELOC", "FUNC", "DEBUG", "CERT", "STRINGS", "SIG", "HASH", "OVERLAY", "JSON", "EXIT", "CLS", "HELP"
+};
+
+bool PEFile::fail(const char* message)
+{
+	m_error = message;
+	if (m_verbose)
+		std::cerr << message << std::endl;
+	return false;
+}
+
+PEFile::PEFile(const std::string& filePath, bool verbose, ParseCache* cache)
+	: m_verbose(verbose)
+{
+	m_filePath = filePath;
 	m_peName = filePath.substr(filePath.find_last_of('\\')+1);
 
-	std::ifstream file(filePath, std::ios::binary);
-	if (!file.is_open()) {
-		std::cerr << "   ϴ." << std::endl;
-		return;
+	// a cache hit replaces the header parse and the directories the entry holds, the file itself
+	// is only opened for the rest
+	CacheKey key;
+	bool keyed = cache && cache->Key(filePath, key);
+	if (keyed && cache->Open(key, m_cacheEntry))
+		m_cached = restore(m_cacheEntry);
+
+	if (!m_cached)
+	{
+		m_cacheEntry.close();
+		if (m_image.open(filePath))
+		{
+			if (!load(m_image))
+				return;
+		}
+		else
+		{
+			// fall back to stream reads when the file cannot be mapped
+			std::ifstream file(filePath, std::ios::binary);
+			if (!file.is_open()) {
+				fail("   ϴ.");
+				return;
+			}
+			if (!load(file))
+				return;
+			file.close();
+		}
+
 	}
-	if (!readDosHeader(file)) {
-		std::cerr << "DOS header дµ Ͽϴ." << std::endl;
-		return;
+
+	// the entry is written when the file is done with, holding only the directories read by then
+	if (keyed)
+	{
+		m_cache = cache;
+		m_cacheKey = key;
 	}
-	if (m_dosHeader.e_magic != IMAGE_DOS_SIGNATURE) {
-		std::cerr << "ȿ  DOS header Դϴ." << std::endl;
+
+	GetMachineString(fileHeader().Machine);
+	GetSubSystemString(std::visit([](const auto& model) { return model.ntHeaders.OptionalHeader.Subsystem; }, m_model));
+
+	// initialize command list
+	for (const char* name : commandNames)
+		commands[name] = 1;
+
+	loaded = true;
+}
+
+PEFile::~PEFile()
+{
+	// a header only job stores a header only entry, a later job that reads more replaces it
+	if (!m_cache || (m_cached && (cachedDirectories() & ~m_cacheFlags) == 0))
 		return;
+
+	std::vector<BYTE> blob;
+	serialize(m_cacheKey, blob);
+	// the names were copied into the blob, the old entry can be replaced now
+	m_cacheEntry.close();
+	m_cache->Store(m_cacheKey, blob);
+}
+
+DWORD PEFile::GetDirectoryCount() const
+{
+	DWORD count = std::visit([](const auto& model) { return model.ntHeaders.OptionalHeader.NumberOfRvaAndSizes; }, m_model);
+	return count < IMAGE_NUMBEROF_DIRECTORY_ENTRIES ? count : IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+}
+
+const IMAGE_DATA_DIRECTORY& PEFile::GetDataDirectory(int index) const
+{
+	return std::visit([index](const auto& model) -> const IMAGE_DATA_DIRECTORY& { return model.ntHeaders.OptionalHeader.DataDirectory[index]; }, m_model);
+}
+
+const std::vector<IIDX>& PEFile::GetImportDescriptors()
+{
+	readDirectory(IMAGE_DIRECTORY_ENTRY_IMPORT);
+	return m_IIDs;
+}
+
+size_t PEFile::GetImportCount()
+{
+	readDirectory(IMAGE_DIRECTORY_ENTRY_IMPORT);
+	return std::visit([](const auto& model) { return model.INT.size(); }, m_model) - m_IIDs.size();
+}
+
+const std::vector<DelayIIDX>& PEFile::GetDelayImportDescriptors()
+{
+	readDirectory(IMAGE_DIRECTORY_ENTRY_DELAY_IMPORT);
+	return m_delayIIDs;
+}
+
+size_t PEFile::GetDelayImportCount()
+{
+	readDirectory(IMAGE_DIRECTORY_ENTRY_DELAY_IMPORT);
+	return std::visit([](const auto& model) { return model.delayINT.size(); }, m_model) - m_delayIIDs.size();
+}
+
+const std::vector<ExportElement>& PEFile::GetExportTable()
+{
+	readDirectory(IMAGE_DIRECTORY_ENTRY_EXPORT);
+	return m_ExportTable;
+}
+
+const ExportIndex& PEFile::GetExportIndex()
+{
+	readDirectory(IMAGE_DIRECTORY_ENTRY_EXPORT);
+	if (!m_exportIndex.built() && exportDir)
+		m_exportIndex.build(m_IED, m_exportFunctions, m_ExportTable);
+	return m_exportIndex;
+}
+
+bool PEFile::FindExport(const std::string& name, ExportSymbol& symbol)
+{
+	return GetExportIndex().findByName(name.c_str(), name.size(), symbol);
+}
+
+bool PEFile::FindExportByOrdinal(DWORD ordinal, ExportSymbol& symbol)
+{
+	return GetExportIndex().findByOrdinal(ordinal, symbol);
+}
+
+bool PEFile::FindExportByAddress(DWORD rva, ExportSymbol& symbol)
+{
+	return GetExportIndex().findByAddress(rva, symbol);
+}
+
+bool PEFile::Hash(bool threads)
+{
+	if (m_hashed)
+		return true;
+
+	ULONGLONG size = fileSize();
+	std::ifstream file;
+	if (!m_image.isOpen())
+	{
+		file.open(m_filePath, std::ios::binary);
+		if (!file.is_open())
+			return false;
 	}
-	if (!readDosStub(file)) {
-		std::cerr << "DOS Stub дµ Ͽϴ." << std::endl;
-		return;
+
+	sectionRanges(m_hashRanges);
+	if (m_image.isOpen())
+		m_hasher.run(m_image.data(), size, m_hashRanges, threads);
+	else if (!m_hasher.run(file, size, m_hashRanges))
+		return false;
+
+	m_hashed = true;
+	return true;
+}
+
+void PEFile::sectionRanges(std::vector<HashRange>& ranges)
+{
+	// raw data clipped to the file, then the overlay as OVERLAY reports it
+	ULONGLONG size = fileSize();
+	ranges.clear();
+	for (const auto& header : m_sectionHeaders)
+	{
+		ULONGLONG first = (std::min)((ULONGLONG)header.PointerToRawData, size);
+		ULONGLONG last = (std::min)(first + header.SizeOfRawData, size);
+		ranges.push_back({ first, last - first });
 	}
-	if (!readNtHeaders(file)) {
-		std::cerr << "NT Headers дµ Ͽϴ." << std::endl;
-		return;
+
+	OverlayInfo overlay;
+	locateOverlay(overlay);
+	if (overlay.size)
+		ranges.push_back({ overlay.offset, overlay.size });
+}
+
+void PEFile::locateOverlay(OverlayInfo& overlay)
+{
+	// whatever follows the raw data of the last section
+	ULONGLONG size = fileSize();
+	ULONGLONG end = 0;
+	for (const auto& header : m_sectionHeaders)
+	{
+		ULONGLONG first = (std::min)((ULONGLONG)header.PointerToRawData, size);
+		end = (std::max)(end, (std::min)(first + header.SizeOfRawData, size));
 	}
-	if (m_ntHeaders.Signature != IMAGE_NT_SIGNATURE) {
-		std::cerr << "ȿ  NT header Դϴ." << std::endl;
+	overlay = { size, 0, 0, 0 };
+	if (m_sectionHeaders.empty() || end >= size)
 		return;
+	overlay.offset = end;
+	overlay.size = size - end;
+
+	// signing appends the certificate table, it is not part of what an installer carries
+	if (GetDirectoryCount() > IMAGE_DIRECTORY_ENTRY_SECURITY)
+	{
+		const IMAGE_DATA_DIRECTORY& directory = GetDataDirectory(IMAGE_DIRECTORY_ENTRY_SECURITY);
+		ULONGLONG first = (std::min)((ULONGLONG)directory.VirtualAddress, size);
+		ULONGLONG last = (std::min)(first + directory.Size, size);
+		if (directory.VirtualAddress && last > first && first >= overlay.offset)
+		{
+			overlay.certificateOffset = first;
+			overlay.certificateSize = last - first;
+			if (last == size)
+				overlay.size = first - overlay.offset;
+			else if (first == overlay.offset)
+			{
+				overlay.offset = last;
+				overlay.size = size - last;
+			}
+		}
 	}
-	if (m_ntHeaders.OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
-		readNtHeaderx86(file);
-		x86 = true;
-	}	
-	if (!readSectionHeaders(file)) {
-		std::cerr << "Section Header дµ Ͽϴ." << std::endl;
-		return;
+}
+
+const CertificateTable& PEFile::GetCertificates()
+{
+	readDirectory(IMAGE_DIRECTORY_ENTRY_SECURITY);
+	return m_certificates;
+}
+
+bool PEFile::readSecurityDirectory()
+{
+	// the one directory that holds a file offset, rva2raw would send it somewhere else
+	const IMAGE_DATA_DIRECTORY& directory = GetDataDirectory(IMAGE_DIRECTORY_ENTRY_SECURITY);
+	std::vector<BYTE> buffer;
+	ULONGLONG size = directory.Size;
+	const BYTE* data = readRaw(directory.VirtualAddress, size, buffer);
+	return data && m_certificates.parse(data, (size_t)size, directory.VirtualAddress);
+}
+
+bool PEFile::HashAuthenticode(bool threads)
+{
+	if (m_authenticodeHashed)
+		return true;
+
+	ULONGLONG size = fileSize();
+	std::ifstream file;
+	if (!m_image.isOpen())
+	{
+		file.open(m_filePath, std::ios::binary);
+		if (!file.is_open())
+			return false;
 	}
-	if (!readDirectory(file)) {
-		std::cerr << "Directory дµ Ͽϴ." << std::endl;
-		return;
+
+	// the checksum and the security entry change when a file is signed, the table is the signature
+	std::vector<HashRange> skips;
+	std::visit([&](const auto& model) {
+		typedef typename std::decay_t<decltype(model)>::traits::NtHeaders NtHeaders;
+		skips.push_back({ (ULONGLONG)m_dosHeader.e_lfanew + offsetof(NtHeaders, OptionalHeader.CheckSum), sizeof(DWORD) });
+		if (GetDirectoryCount() > IMAGE_DIRECTORY_ENTRY_SECURITY)
+			skips.push_back({ (ULONGLONG)m_dosHeader.e_lfanew + offsetof(NtHeaders, OptionalHeader.DataDirectory)
+				+ IMAGE_DIRECTORY_ENTRY_SECURITY * sizeof(IMAGE_DATA_DIRECTORY), sizeof(IMAGE_DATA_DIRECTORY) });
+	}, m_model);
+	if (GetDirectoryCount() > IMAGE_DIRECTORY_ENTRY_SECURITY)
+	{
+		const IMAGE_DATA_DIRECTORY& directory = GetDataDirectory(IMAGE_DIRECTORY_ENTRY_SECURITY);
+		if (directory.VirtualAddress && directory.Size)
+			skips.push_back({ directory.VirtualAddress, directory.Size });
 	}
+	std::sort(skips.begin(), skips.end(), [](const HashRange& a, const HashRange& b) { return a.offset < b.offset; });
 
-	GetMachineString(m_ntHeaders.FileHeader.Machine);
-	if (x86)
-		GetSubSystemString(m_ntHeaderx86.OptionalHeader.Subsystem);
-	else
-		GetSubSystemString(m_ntHeaders.OptionalHeader.Subsystem);
+	// everything between the skipped ranges, in file order
+	std::vector<HashRange> ranges;
+	ULONGLONG pos = 0;
+	for (const HashRange& skip : skips)
+	{
+		ULONGLONG begin = (std::min)(skip.offset, size);
+		if (begin > pos)
+			ranges.push_back({ pos, begin - pos });
+		pos = (std::max)(pos, (std::min)(skip.offset + skip.size, size));
+	}
+	if (pos < size)
+		ranges.push_back({ pos, size - pos });
 
-	// initialize command list
-	commands["DOS"] = 1;
-	commands["STUB"] = 1;
-	commands["NT"] = 1;
-	commands["SH"] = 1;
-	commands["IDT"] = 1;
-	commands["INT"] = 1;
-	commands["IAT"] = 1;
-	commands["IED"] = 1;
-	commands["EAT"] = 1;
-	commands["ENT"] = 1;
-	commands["EOT"] = 1;
-	commands["EXIT"] = 1;
-	commands["CLS"] = 1;
-	commands["HELP"] = 1;
-
-	file.close();
-	loaded = true;
+	if (m_image.isOpen())
+		FileHasher::HashJoined(m_image.data(), ranges, threads, m_authenticode);
+	else if (!FileHasher::HashJoined(file, ranges, m_authenticode))
+		return false;
+
+	m_authenticodeHashed = true;
+	return true;
 }
 
-void PEFile::Run()
+ResourceTree& PEFile::GetResourceTree()
 {
-	while (true)
+	readDirectory(IMAGE_DIRECTORY_ENTRY_RESOURCE);
+	return m_resources;
+}
+
+bool PEFile::readResourceDirectory(DWORD rva)
+{
+	// names and subdirectories are offsets from the directory start, data entries hold RVAs
+	DWORD offset;
+	if (!m_sectionIndex.translate(rva, offset))
+		return false;
+	// entry counts are bounded by what is left of the directory, which ends with its section
+	ULONGLONG size = (std::min)(GetDataDirectory(IMAGE_DIRECTORY_ENTRY_RESOURCE).Size, m_sectionIndex.extent(rva));
+	const BYTE* data = readRaw(offset, size, m_resourceBuffer);
+	return data && m_resources.open(data, (size_t)size);
+}
+
+const BYTE* PEFile::GetResourceData(DWORD node, ULONGLONG& size, std::vector<BYTE>& buffer)
+{
+	IMAGE_RESOURCE_DATA_ENTRY entry;
+	DWORD offset;
+	if (!m_resources.dataEntry(node, entry) || !m_sectionIndex.translate(entry.OffsetToData, offset))
+		return nullptr;
+	size = entry.Size;
+	return readRaw(offset, size, buffer);
+}
+
+bool PEFile::GetVersionInfo(VersionInfo& info)
+{
+	ResourceTree& tree = GetResourceTree();
+	if (!tree.isOpen())
+		return false;
+	DWORD type = tree.find(0, (DWORD)16);		// RT_VERSION
+	DWORD node = type == ResourceTree::npos ? type : tree.firstData(type);
+	if (node == ResourceTree::npos)
+		return false;
+
+	std::vector<BYTE> buffer;
+	ULONGLONG size;
+	const BYTE* data = GetResourceData(node, size, buffer);
+	return data && ResourceTree::ParseVersionInfo(data, (size_t)size, info);
+}
+
+bool PEFile::GetManifest(std::string& manifest)
+{
+	ResourceTree& tree = GetResourceTree();
+	if (!tree.isOpen())
+		return false;
+	DWORD type = tree.find(0, (DWORD)24);		// RT_MANIFEST
+	DWORD node = type == ResourceTree::npos ? type : tree.firstData(type);
+	if (node == ResourceTree::npos)
+		return false;
+
+	std::vector<BYTE> buffer;
+	ULONGLONG size;
+	const BYTE* data = GetResourceData(node, size, buffer);
+	if (!data)
+		return false;
+
+	// manifests are UTF-8, usually with a BOM
+	if (size >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF)
 	{
-		std::string cmd;
+		data += 3;
+		size -= 3;
+	}
+	manifest.assign((const char*)data, (size_t)size);
+	return true;
+}
 
-		std::cout << m_peName << ">";
-		std::getline(std::cin, cmd);
-		std::transform(cmd.begin(), cmd.end(), cmd.begin(), [](unsigned char c) { return std::toupper(c); });
+const RelocationTable& PEFile::GetRelocations()
+{
+	readDirectory(IMAGE_DIRECTORY_ENTRY_BASERELOC);
+	return m_relocations;
+}
 
-		std::vector<std::string> result;
-		std::istringstream iss(cmd);
-		std::string word;
-		while (iss >> word) {
-			result.push_back(word);
-		}
+bool PEFile::readRelocationDirectory(DWORD rva)
+{
+	DWORD offset;
+	if (!m_sectionIndex.translate(rva, offset))
+		return false;
+	std::vector<BYTE> buffer;
+	ULONGLONG size = GetDataDirectory(IMAGE_DIRECTORY_ENTRY_BASERELOC).Size;
+	const BYTE* data = readRaw(offset, size, buffer);
+	return data && m_relocations.parse(data, (size_t)size);
+}
 
-		if (result.size() < 1)
+bool PEFile::MapImage(std::vector<BYTE>& image)
+{
+	DWORD sizeOfImage = std::visit([](const auto& model) { return model.ntHeaders.OptionalHeader.SizeOfImage; }, m_model);
+	DWORD sizeOfHeaders = std::visit([](const auto& model) { return model.ntHeaders.OptionalHeader.SizeOfHeaders; }, m_model);
+	DWORD sectionAlignment = std::visit([](const auto& model) { return model.ntHeaders.OptionalHeader.SectionAlignment; }, m_model);
+
+	// SizeOfImage is not trusted past the end of the last section rounded to SectionAlignment,
+	// plus one 64 KB allocation granule that ReadyToRun images reserve behind their sections
+	ULONGLONG extent = sizeOfHeaders;
+	for (const auto& header : m_sectionHeaders)
+		extent = (std::max)(extent, (ULONGLONG)header.VirtualAddress + (std::max)(header.Misc.VirtualSize, header.SizeOfRawData));
+	if (sectionAlignment)
+		extent = (extent + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+	if (sizeOfImage > extent + 0x10000)
+		return false;
+	image.assign(sizeOfImage, 0);
+
+	std::vector<BYTE> buffer;
+	ULONGLONG size = (std::min)(sizeOfHeaders, sizeOfImage);
+	const BYTE* data = readRaw(0, size, buffer);
+	if (!data)
+		return false;
+	memcpy(image.data(), data, (size_t)size);
+
+	for (const auto& header : m_sectionHeaders)
+	{
+		if (header.VirtualAddress >= sizeOfImage)
+			continue;
+		ULONGLONG length = (std::min)(header.SizeOfRawData, sizeOfImage - header.VirtualAddress);
+		if (header.Misc.VirtualSize)
+			length = (std::min)(length, (ULONGLONG)header.Misc.VirtualSize);
+		// uninitialized data such as .bss stays zero filled
+		if (length == 0)
 			continue;
+		const BYTE* raw = readRaw(header.PointerToRawData, length, buffer);
+		if (!raw)
+			return false;
+		memcpy(image.data() + header.VirtualAddress, raw, (size_t)length);
+	}
+	return true;
+}
+
+size_t PEFile::ApplyRelocations(BYTE* image, size_t imageSize, ULONGLONG base)
+{
+	ULONGLONG imageBase = std::visit([](const auto& model) { return (ULONGLONG)model.ntHeaders.OptionalHeader.ImageBase; }, m_model);
+	return GetRelocations().apply(image, imageSize, base - imageBase);
+}
+
+const FunctionTable& PEFile::GetFunctionTable()
+{
+	readDirectory(IMAGE_DIRECTORY_ENTRY_EXCEPTION);
+	return m_functions;
+}
+
+bool PEFile::readExceptionDirectory(DWORD rva)
+{
+	// only x64 uses IMAGE_RUNTIME_FUNCTION_ENTRY with an end address, ARM64 packs its entries
+	if (fileHeader().Machine != IMAGE_FILE_MACHINE_AMD64)
+		return true;
+
+	DWORD offset;
+	if (!m_sectionIndex.translate(rva, offset))
+		return false;
+	std::vector<BYTE> buffer;
+	ULONGLONG size = GetDataDirectory(IMAGE_DIRECTORY_ENTRY_EXCEPTION).Size;
+	const BYTE* data = readRaw(offset, size, buffer);
+	return data && m_functions.parse(data, (size_t)size);
+}
+
+bool PEFile::GetUnwindInfo(size_t function, UnwindInfo& info)
+{
+	DWORD offset;
+	if (function >= GetFunctionTable().size() || !m_sectionIndex.translate(m_functions.entry(function).UnwindInfoAddress, offset))
+		return false;
+
+	// header, at most 255 codes padded to 256, and the handler or the chained entry
+	std::vector<BYTE> buffer;
+	ULONGLONG size = 4 + 256 * 2 + sizeof(IMAGE_RUNTIME_FUNCTION_ENTRY);
+	const BYTE* data = readRaw(offset, size, buffer);
+	return data && FunctionTable::ReadUnwindInfo(data, (size_t)size, info);
+}
+
+DWORD PEFile::GetFunctionStart(size_t function)
+{
+	DWORD begin = m_functions.entry(function).BeginAddress;
+	UnwindInfo info;
+	for (int depth = 0; depth < 32 && GetUnwindInfo(function, info) && (info.flags & 4); ++depth)
+	{
+		function = m_functions.find(info.chainBegin);
+		if (function == FunctionTable::npos)
+			break;
+		begin = m_functions.entry(function).BeginAddress;
+	}
+	return begin;
+}
+
+void PEFile::FindFunctions(const DWORD* rvas, size_t* indices, size_t count)
+{
+	GetFunctionTable().find(rvas, indices, count);
+}
+
+std::string PEFile::Symbolize(DWORD rva, size_t function)
+{
+	char text[32];
+	std::string symbol;
+	DWORD begin = rva;
+	if (function != FunctionTable::npos)
+	{
+		begin = GetFunctionStart(function);
+		ExportSymbol exported;
+		if (FindExportByAddress(begin, exported) && exported.rva == begin && exported.name)
+			symbol = exported.name;
+		else
+		{
+			snprintf(text, sizeof(text), "sub_%08X", begin);
+			symbol = text;
+		}
+	}
+	else
+	{
+		snprintf(text, sizeof(text), "%08X", rva);
+		return text;
+	}
+
+	if (rva != begin)
+	{
+		snprintf(text, sizeof(text), "+%X", rva - begin);
+		symbol += text;
+	}
+	return symbol;
+}
+
+const DebugDirectory& PEFile::GetDebugDirectory()
+{
+	readDirectory(IMAGE_DIRECTORY_ENTRY_DEBUG);
+	return m_debug;
+}
 
-		if (commands[result[0]] == 1)
+bool PEFile::readDebugDirectory(DWORD rva)
+{
+	DWORD offset;
+	if (!m_sectionIndex.translate(rva, offset))
+		return false;
+	std::vector<BYTE> buffer;
+	ULONGLONG size = GetDataDirectory(IMAGE_DIRECTORY_ENTRY_DEBUG).Size;
+	const BYTE* data = readRaw(offset, size, buffer);
+	return data && m_debug.parse(data, (size_t)size);
+}
+
+const BYTE* PEFile::GetDebugData(size_t entry, ULONGLONG& size, std::vector<BYTE>& buffer)
+{
+	if (entry >= GetDebugDirectory().entries().size())
+		return nullptr;
+
+	// PointerToRawData is a file offset, records that are not loaded only have that one
+	const IMAGE_DEBUG_DIRECTORY& debug = m_debug.entries()[entry];
+	DWORD offset = debug.PointerToRawData;
+	if (!offset && !m_sectionIndex.translate(debug.AddressOfRawData, offset))
+		return nullptr;
+	size = debug.SizeOfData;
+	return size ? readRaw(offset, size, buffer) : nullptr;
+}
+
+bool PEFile::GetCodeView(CodeViewInfo& info)
+{
+	std::vector<BYTE> buffer;
+	ULONGLONG size;
+	const BYTE* data = GetDebugData(GetDebugDirectory().find(IMAGE_DEBUG_TYPE_CODEVIEW), size, buffer);
+	return data && DebugDirectory::ReadCodeView(data, (size_t)size, info);
+}
+
+const std::vector<double>& PEFile::GetSectionEntropy()
+{
+	if (m_entropyRead)
+		return m_sectionEntropy;
+	m_entropyRead = true;
+
+	std::vector<BYTE> buffer;
+	m_sectionEntropy.clear();
+	for (const auto& header : m_sectionHeaders)
+	{
+		ULONGLONG size = header.SizeOfRawData;
+		const BYTE* data = readRaw(header.PointerToRawData, size, buffer);
+		m_sectionEntropy.push_back(data ? Entropy::Of(data, (size_t)size) : 0.0);
+	}
+	return m_sectionEntropy;
+}
+
+bool PEFile::ScanStrings(size_t minLength, bool threads)
+{
+	minLength = (std::max)(minLength, (size_t)1);
+	if (m_stringMinLength == minLength)
+		return true;
+
+	std::vector<HashRange> ranges;
+	sectionRanges(ranges);
+
+	m_stringHits.clear();
+	m_stringText.clear();
+	std::vector<BYTE> buffer;
+	std::vector<StringHit> hits;
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		ULONGLONG size = ranges[i].size;
+		const BYTE* data = readRaw(ranges[i].offset, size, buffer);
+		if (!data)
+			return false;
+
+		// offsets come back relative to the range, the text is copied while the range is at hand
+		StringScanner::Scan(data, (size_t)size, minLength, hits, threads);
+		for (StringHit& hit : hits)
 		{
-			if (result[0] == "DOS")
+			hit.text = m_stringText.size();
+			StringScanner::AppendText(data, hit, m_stringText);
+			if (i < m_sectionHeaders.size())
 			{
-				if (result.size() == 1)
-					printDosHeader();
-				else if (result.size() == 2)
-				{
-					if (result[1] == "-R")
-						printRaw(&m_dosHeader, sizeof(IMAGE_DOS_HEADER));
-					else if (result[1] == "-B")
-						printByte(&m_dosHeader, sizeof(IMAGE_DOS_HEADER));
-					else if (result[1] == "-RB")
-						printByteAndRaw(&m_dosHeader, sizeof(IMAGE_DOS_HEADER));
-					else if (result[1] == "-H")
-						printHelp(result[0]);
-					else
-						std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
-						std::endl << "  DOS -h Էϼ.\n" << std::endl;
-				}
-				else
-				{
-					std::cout << "ùٸ ɼ  ƴմϴ." <<
-						std::endl << "  DOS -h Էϼ.\n" << std::endl;
-				}
+				hit.section = (WORD)i;
+				hit.rva = m_sectionHeaders[i].VirtualAddress + (DWORD)hit.offset;
 			}
-			else if (result[0] == "STUB")
+			hit.offset += ranges[i].offset;
+			m_stringHits.push_back(hit);
+		}
+	}
+
+	m_stringMinLength = minLength;
+	return true;
+}
+
+bool PEFile::MatchSignatures(const SignatureSet& rules)
+{
+	m_signatureMatches.clear();
+	m_signatureSet = &rules;
+
+	std::vector<HashRange> ranges;
+	sectionRanges(ranges);
+
+	// entry rules only look at the start of the code, not the whole section it is in
+	DWORD entry = std::visit([](const auto& model) { return model.ntHeaders.OptionalHeader.AddressOfEntryPoint; }, m_model);
+	DWORD entryOffset = 0;
+	bool hasEntry = entry && m_sectionIndex.translate(entry, entryOffset);
+
+	std::vector<BYTE> buffer;
+	std::vector<SignatureHit> hits;
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		// a section without raw data has nothing to match
+		const HashRange& range = ranges[i];
+		if (range.size == 0)
+			continue;
+
+		bool overlay = i >= m_sectionHeaders.size();
+		std::string_view name;
+		if (!overlay)
+			name = std::string_view((const char*)m_sectionHeaders[i].Name, strnlen((const char*)m_sectionHeaders[i].Name, IMAGE_SIZEOF_SHORT_NAME));
+		auto covers = [&](const SignatureRule& rule) {
+			return rule.anywhere || (overlay ? rule.overlay : std::find(rule.sections.begin(), rule.sections.end(), name) != rule.sections.end());
+		};
+
+		bool entryHere = hasEntry && entryOffset >= range.offset && entryOffset - range.offset < range.size;
+		bool whole = false, entryRules = false;
+		for (size_t r = 0; r < rules.size() && !whole; ++r)
+		{
+			whole = covers(rules.rule(r));
+			entryRules |= rules.rule(r).entry;
+		}
+		if (!whole && !(entryRules && entryHere))
+			continue;
+
+		// with only entry rules to try, the region and room for the longest pattern are enough
+		ULONGLONG begin = range.offset;
+		ULONGLONG size = range.size;
+		if (!whole)
+		{
+			begin = entryOffset;
+			size = (std::min)((ULONGLONG)SignatureSet::entryRegion + rules.longest(), range.offset + range.size - entryOffset);
+		}
+		const BYTE* data = readRaw(begin, size, buffer);
+		if (!data)
+			return false;
+
+		rules.scan(data, (size_t)size, hits);
+		for (const SignatureHit& hit : hits)
+		{
+			const SignatureRule& rule = rules.rule(hit.rule);
+			ULONGLONG offset = begin + hit.offset;
+			bool inEntry = entryHere && offset >= entryOffset && offset - entryOffset < SignatureSet::entryRegion;
+			if (!covers(rule) && !(rule.entry && inEntry))
+				continue;
+
+			SignatureMatch match = { offset, 0, hit.rule, SignatureMatch::noSection };
+			if (!overlay)
 			{
-				if (result.size() == 1)
-					printByteAndRaw(&m_dosStubByte[0], m_dosStubByte.size());
-				else if (result.size() == 2)
-				{
-					if (result[1] == "-R")
-						printRaw(&m_dosStubByte[0], m_dosStubByte.size());
-					else if (result[1] == "-B")
-						printByte(&m_dosStubByte[0], m_dosStubByte.size());
-					else if (result[1] == "-RB")
-						printByteAndRaw(&m_dosStubByte[0], m_dosStubByte.size());
-					else if (result[1] == "-H")
-						printHelp(result[0]);
-					else
-						std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
-						std::endl << "  STUB -h Էϼ.\n" << std::endl;
-				}
-				else
-				{
-					std::cout << "ùٸ ɼ  ƴմϴ." <<
-						std::endl << "  STUB -h Էϼ.\n" << std::endl;
-				}
+				match.section = (WORD)i;
+				match.rva = m_sectionHeaders[i].VirtualAddress + (DWORD)(offset - range.offset);
 			}
-			else if (result[0] == "NT")
+			m_signatureMatches.push_back(match);
+		}
+	}
+	return true;
+}
+
+const RichHeader& PEFile::GetRichHeader()
+{
+	if (!m_richRead)
+	{
+		m_rich.parse(m_dosHeader, (const BYTE*)m_dosStubByte.data(), m_dosStubByte.size());
+		m_richRead = true;
+	}
+	return m_rich;
+}
+
+const FingerprintSet& PEFile::GetFingerprint()
+{
+	if (m_fingerprinted)
+		return m_fingerprint;
+
+	// the tables the parse cache keeps, a restored file is not read again
+	readDirectory(IMAGE_DIRECTORY_ENTRY_IMPORT);
+	readDirectory(IMAGE_DIRECTORY_ENTRY_EXPORT);
+
+	Fingerprint fingerprint;
+	std::visit([&](const auto& model) {
+		typedef typename std::decay_t<decltype(model)>::traits Traits;
+
+		// each module's names end with a zero entry
+		size_t module = 0;
+		for (const auto& element : model.INT)
+		{
+			if (module >= m_IIDs.size())
+				break;
+			if (element.addr == 0)
+				++module;
+			else if (element.addr & Traits::ordinalFlag)
+				fingerprint.addImport(m_IIDs[module].Name, (WORD)element.addr);
+			else if (!element.Name.empty())
+				fingerprint.addImport(m_IIDs[module].Name, element.Name);
+		}
+	}, m_model);
+
+	fingerprint.hashRich(GetRichHeader());
+
+	std::vector<std::string_view> names;
+	names.reserve(m_ExportTable.size());
+	for (const ExportElement& element : m_ExportTable)
+	{
+		if (!element.name.empty())
+			names.push_back(element.name);
+	}
+	fingerprint.hashExports(names);
+
+	m_fingerprint = fingerprint.final();
+	m_fingerprinted = true;
+	return m_fingerprint;
+}
+
+bool PEFile::ScanOverlay()
+{
+	if (m_overlayScanned)
+		return true;
+
+	locateOverlay(m_overlay);
+
+	// one chunk at a time, an installer's payload can be far larger than the image
+	m_overlayScan.reset();
+	if (m_image.isOpen())
+	{
+		const BYTE* data = m_image.data() + m_overlay.offset;
+		for (ULONGLONG pos = 0; pos < m_overlay.size; pos += OverlayScanner::chunkSize)
+			m_overlayScan.update(data + pos, (size_t)(std::min)((ULONGLONG)OverlayScanner::chunkSize, m_overlay.size - pos));
+	}
+	else if (m_overlay.size)
+	{
+		std::ifstream file(m_filePath, std::ios::binary);
+		if (!file.is_open() || !file.seekg(m_overlay.offset))
+			return false;
+		std::vector<BYTE> buffer(OverlayScanner::chunkSize);
+		for (ULONGLONG pos = 0; pos < m_overlay.size; )
+		{
+			size_t count = (size_t)(std::min)((ULONGLONG)buffer.size(), m_overlay.size - pos);
+			if (!file.read((char*)buffer.data(), count))
+				return false;
+			m_overlayScan.update(buffer.data(), count);
+			pos += count;
+		}
+	}
+
+	m_overlayScanned = true;
+	return true;
+}
+
+ULONGLONG PEFile::fileSize()
+{
+	// a file restored from the cache has not been opened yet
+	if (m_cached && !m_image.isOpen())
+		m_image.open(m_filePath);
+	if (m_image.isOpen())
+		return m_image.size();
+
+	if (m_fileSize == 0)
+	{
+		std::ifstream file(m_filePath, std::ios::binary | std::ios::ate);
+		if (file.is_open())
+			m_fileSize = (ULONGLONG)file.tellg();
+	}
+	return m_fileSize;
+}
+
+const BYTE* PEFile::readRaw(ULONGLONG offset, ULONGLONG& size, std::vector<BYTE>& buffer)
+{
+	ULONGLONG total = fileSize();
+	offset = (std::min)(offset, total);
+	size = (std::min)(size, total - offset);
+	if (m_image.isOpen())
+		return m_image.data() + offset;
+
+	// an empty vector may have no storage, an empty read still succeeds
+	static const BYTE empty = 0;
+	if (size == 0)
+		return &empty;
+
+	std::ifstream file(m_filePath, std::ios::binary);
+	buffer.resize((size_t)size);
+	if (!file.is_open() || !file.seekg(offset) || !file.read(reinterpret_cast<char*>(buffer.data()), size))
+		return nullptr;
+	return buffer.data();
+}
+
+void PEFile::Run()
+{
+	std::string line;
+	while (true)
+	{
+		// everything the last command printed goes out before the prompt
+		m_out.flush();
+		std::cout << m_peName << ">";
+		if (!std::getline(std::cin, line))
+			break;
+
+		if (!Execute(line))
+			break;
+	}
+	m_out.flush();
+}
+
+void PEFile::RunScript(const std::vector<std::string>& script)
+{
+	for (const auto& line : script)
+	{
+		bool more = Execute(line);
+
+		// messages go straight to std::cout, keep them in order with the tables
+		m_out.flush();
+		if (!more)
+			break;
+	}
+}
+
+std::vector<std::string> PEFile::SplitCommands(const std::string& text)
+{
+	// a command name starts a new command, every other word is an argument of the last one
+	std::vector<std::string> script;
+	std::istringstream iss(text);
+	std::string word;
+	while (iss >> word)
+	{
+		std::string upper = word;
+		std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return std::toupper(c); });
+
+		bool command = std::find_if(std::begin(commandNames), std::end(commandNames), [&upper](const char* name) { return upper == name; }) != std::end(commandNames);
+		if (command || script.empty())
+			script.push_back(word);
+		else
+			script.back() += " " + word;
+	}
+	return script;
+}
+
+bool PEFile::Execute(const std::string& line)
+{
+	std::string cmd = line;
+	std::transform(cmd.begin(), cmd.end(), cmd.begin(), [](unsigned char c) { return std::toupper(c); });
+
+	std::vector<std::string> result;
+	std::istringstream iss(cmd);
+	std::string word;
+	while (iss >> word) {
+		result.push_back(word);
+	}
+
+	if (result.size() < 1)
+		return true;
+
+	if (commands[result[0]] == 1)
+	{
+		// data directories are parsed on first use
+		if (result[0] == "IDT" || result[0] == "INT" || result[0] == "IAT")
+			readDirectory(IMAGE_DIRECTORY_ENTRY_IMPORT);
+		else if (result[0] == "DIDT" || result[0] == "DINT")
+			readDirectory(IMAGE_DIRECTORY_ENTRY_DELAY_IMPORT);
+		else if (result[0] == "IED" || result[0] == "EAT" || result[0] == "ENT" || result[0] == "EOT" || result[0] == "EXP")
+			readDirectory(IMAGE_DIRECTORY_ENTRY_EXPORT);
+
+		if (result[0] == "DOS")
+		{
+			if (result.size() == 1)
+				printDosHeader();
+			else if (result.size() == 2)
+			{
+				if (result[1] == "-R")
+					printRaw(&m_dosHeader, sizeof(IMAGE_DOS_HEADER));
+				else if (result[1] == "-B")
+					printByte(&m_dosHeader, sizeof(IMAGE_DOS_HEADER));
+				else if (result[1] == "-RB")
+					printByteAndRaw(&m_dosHeader, sizeof(IMAGE_DOS_HEADER));
+				else if (result[1] == "-H")
+					printHelp(result[0]);
+				else
+					std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+					std::endl << "  DOS -h Էϼ.\n" << std::endl;
+			}
+			else
+			{
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  DOS -h Էϼ.\n" << std::endl;
+			}
+		}
+		else if (result[0] == "STUB")
+		{
+			if (result.size() == 1)
+				printByteAndRaw(&m_dosStubByte[0], m_dosStubByte.size());
+			else if (result.size() == 2)
+			{
+				if (result[1] == "-R")
+					printRaw(&m_dosStubByte[0], m_dosStubByte.size());
+				else if (result[1] == "-B")
+					printByte(&m_dosStubByte[0], m_dosStubByte.size());
+				else if (result[1] == "-RB")
+					printByteAndRaw(&m_dosStubByte[0], m_dosStubByte.size());
+				else if (result[1] == "-H")
+					printHelp(result[0]);
+				else
+					std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+					std::endl << "  STUB -h Էϼ.\n" << std::endl;
+			}
+			else
+			{
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  STUB -h Էϼ.\n" << std::endl;
+			}
+		}
+		else if (result[0] == "RICH")
+		{
+			if (result.size() == 1)
 			{
-				if (result.size() == 1)
-					printNtHeaders();
-				else if (result.size() == 2)
+				GetRichHeader();
+				printRichHeader();
+			}
+			else if (result.size() == 2 && result[1] == "-H")
+				printHelp(result[0]);
+			else
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  RICH -h Էϼ.\n" << std::endl;
+		}
+		else if (result[0] == "NT")
+		{
+			if (result.size() == 1)
+				printNtHeaders();
+			else if (result.size() == 2)
+			{
+				if (result[1] == "-R")
+					std::visit([this](auto& model) { printRaw(&model.ntHeaders, sizeof(model.ntHeaders)); }, m_model);
+				else if (result[1] == "-B")
+					std::visit([this](auto& model) { printByte(&model.ntHeaders, sizeof(model.ntHeaders)); }, m_model);
+				else if (result[1] == "-RB")
+					std::visit([this](auto& model) { printByteAndRaw(&model.ntHeaders, sizeof(model.ntHeaders)); }, m_model);
+				else if (result[1] == "-H")
+					printHelp(result[0]);
+				else if (result[1] == "-FILE")
+					printFileHeader();
+				else if (result[1] == "-OPT")
+					printOptionalHeader();
+				else
+					std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+					std::endl << "  NT -h Էϼ.\n" << std::endl;
+			}
+			else if (result.size() == 3)
+			{
+				if (result[1] == "-FILE")
 				{
-					if (result[1] == "-R")
-						printRaw(x86 ? (void*)&m_ntHeaderx86 : (void*)&m_ntHeaders, x86 ? sizeof(IMAGE_NT_HEADERS32) : sizeof(IMAGE_NT_HEADERS64));
-					else if (result[1] == "-B")
-						printByte(x86 ? (void*)&m_ntHeaderx86 : (void*)&m_ntHeaders, x86 ? sizeof(IMAGE_NT_HEADERS32) : sizeof(IMAGE_NT_HEADERS64));
-					else if (result[1] == "-RB")
-						printByteAndRaw(x86 ? (void*)&m_ntHeaderx86 : (void*)&m_ntHeaders, x86 ? sizeof(IMAGE_NT_HEADERS32) : sizeof(IMAGE_NT_HEADERS64));
-					else if (result[1] == "-H")
-						printHelp(result[0]);
-					else if (result[1] == "-FILE")
-						printFileHeader();
-					else if (result[1] == "-OPT")
-						printOptionalHeader();
+					if (result[2] == "-R")
+						std::visit([this](auto& model) { printRaw(&model.ntHeaders.FileHeader, sizeof(IMAGE_FILE_HEADER)); }, m_model);
+					else if (result[2] == "-B")
+						std::visit([this](auto& model) { printByte(&model.ntHeaders.FileHeader, sizeof(IMAGE_FILE_HEADER)); }, m_model);
+					else if (result[2] == "-RB")
+						std::visit([this](auto& model) { printByteAndRaw(&model.ntHeaders.FileHeader, sizeof(IMAGE_FILE_HEADER)); }, m_model);
 					else
-						std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+						std::cout << "\'" << result[2] << "\' () ùٸ ɼ ƴմϴ." <<
 						std::endl << "  NT -h Էϼ.\n" << std::endl;
 				}
-				else if (result.size() == 3)
+				else if (result[1] == "-OPT")
 				{
-					if (result[1] == "-FILE")
-					{
-						if (result[2] == "-R")
-							printRaw(x86 ? (void*)&m_ntHeaderx86.FileHeader : (void*)&m_ntHeaders.FileHeader, sizeof(IMAGE_FILE_HEADER));
-						else if (result[2] == "-B")
-							printByte(x86 ? (void*)&m_ntHeaderx86.FileHeader : (void*)&m_ntHeaders.FileHeader, sizeof(IMAGE_FILE_HEADER));
-						else if (result[2] == "-RB")
-							printByteAndRaw(x86 ? (void*)&m_ntHeaderx86.FileHeader : (void*)&m_ntHeaders.FileHeader, sizeof(IMAGE_FILE_HEADER));
-						else
-							std::cout << "\'" << result[2] << "\' () ùٸ ɼ ƴմϴ." <<
-							std::endl << "  NT -h Էϼ.\n" << std::endl;
-					}
-					else if (result[1] == "-OPT")
-					{
-						if (result[2] == "-R")
-							printRaw(x86 ? (void*)&m_ntHeaderx86.OptionalHeader : (void*)&m_ntHeaders.OptionalHeader, x86 ? sizeof(IMAGE_OPTIONAL_HEADER32) : sizeof(IMAGE_OPTIONAL_HEADER64));
-						else if (result[2] == "-B")
-							printByte(x86 ? (void*)&m_ntHeaderx86.OptionalHeader : (void*)&m_ntHeaders.OptionalHeader, x86 ? sizeof(IMAGE_OPTIONAL_HEADER32) : sizeof(IMAGE_OPTIONAL_HEADER64));
-						else if (result[2] == "-RB")
-							printByteAndRaw(x86 ? (void*)&m_ntHeaderx86.OptionalHeader : (void*)&m_ntHeaders.OptionalHeader, x86 ? sizeof(IMAGE_OPTIONAL_HEADER32) : sizeof(IMAGE_OPTIONAL_HEADER64));
-						else
-							std::cout << "\'" << result[2] << "\' () ùٸ ɼ ƴմϴ." <<
-							std::endl << "  NT -h Էϼ.\n" << std::endl;
-					}
+					if (result[2] == "-R")
+						std::visit([this](auto& model) { printRaw(&model.ntHeaders.OptionalHeader, sizeof(model.ntHeaders.OptionalHeader)); }, m_model);
+					else if (result[2] == "-B")
+						std::visit([this](auto& model) { printByte(&model.ntHeaders.OptionalHeader, sizeof(model.ntHeaders.OptionalHeader)); }, m_model);
+					else if (result[2] == "-RB")
+						std::visit([this](auto& model) { printByteAndRaw(&model.ntHeaders.OptionalHeader, sizeof(model.ntHeaders.OptionalHeader)); }, m_model);
 					else
-					{
-						std::cout << "ùٸ ɼ  ƴմϴ." <<
-							std::endl << "  NT -h Էϼ.\n" << std::endl;
-					}
+						std::cout << "\'" << result[2] << "\' () ùٸ ɼ ƴմϴ." <<
+						std::endl << "  NT -h Էϼ.\n" << std::endl;
 				}
 				else
 				{
@@ -204,30 +1038,76 @@ void PEFile::Run()
 						std::endl << "  NT -h Էϼ.\n" << std::endl;
 				}
 			}
-			else if (result[0] == "SH")
+			else
+			{
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  NT -h Էϼ.\n" << std::endl;
+			}
+		}
+		else if (result[0] == "SH")
+		{
+			if (result.size() == 1)
+			{
+				const std::vector<double>& entropy = GetSectionEntropy();
+				for (int i = 0; i < m_sectionHeaders.size(); ++i)
+				{
+					char text[16];
+					snprintf(text, sizeof(text), "%.4f", entropy[i]);
+					std::cout << i << " : " << std::left << std::setw(IMAGE_SIZEOF_SHORT_NAME) << std::string((const char*)m_sectionHeaders[i].Name, strnlen((const char*)m_sectionHeaders[i].Name, IMAGE_SIZEOF_SHORT_NAME))
+						<< std::right << " " << text << std::endl;
+				}
+				std::cout << std::endl;
+			}
+			else if (result.size() >= 2)
 			{
-				if (result.size() == 1)
+				if (result[1] == "-H")
 				{
-					for (int i = 0; i < m_sectionHeaders.size(); ++i)
-						std::cout << i << " : " << m_sectionHeaders[i].Name << std::endl;
-					std::cout << std::endl;
+					if (result.size() == 2)
+						printHelp(result[0]);
+					else
+						std::cout << "ùٸ ɼ  ƴմϴ." <<
+						std::endl << "  SH -h Էϼ.\n" << std::endl;
 				}
-				else if (result.size() >= 2)
+				else
 				{
-					if (result[1] == "-H")
+					if (std::all_of(result[1].begin(), result[1].end(), std::isdigit))
 					{
-						if (result.size() == 2)
-							printHelp(result[0]);
+						int idx = std::stoi(result[1]);
+						if (idx >= 0 && idx < m_sectionHeaders.size())
+						{
+							if (result.size() == 3)
+							{
+								if (result[2] == "-R")
+									printRaw(&m_sectionHeaders[idx], sizeof(IMAGE_SECTION_HEADER));
+								else if (result[2] == "-B")
+									printByte(&m_sectionHeaders[idx], sizeof(IMAGE_SECTION_HEADER));
+								else if (result[2] == "-RB")
+									printByteAndRaw(&m_sectionHeaders[idx], sizeof(IMAGE_SECTION_HEADER));
+								else if (result[2] == "-E")
+									printEntropyWindows(idx);
+								else
+									std::cout << "\'" << result[2] << "\' () ùٸ ɼ ƴմϴ." <<
+									std::endl << "  SH -h Էϼ.\n" << std::endl;
+							}
+							else if (result.size() == 2)
+								printSectionHeader(m_sectionHeaders[idx], GetSectionEntropy()[idx]);
+							else
+								std::cout << "ùٸ ɼ  ƴմϴ." <<
+								std::endl << "  SH -h Էϼ.\n" << std::endl;
+						}
 						else
-							std::cout << "ùٸ ɼ  ƴմϴ." <<
-							std::endl << "  SH -h Էϼ.\n" << std::endl;
+							std::cout << "ùٸ  ε Էϼ." << std::endl << std::endl;
 					}
 					else
 					{
-						if (std::all_of(result[1].begin(), result[1].end(), std::isdigit))
+						int idx = 0;
+						bool success = false;
+						for (auto sec : m_sectionHeaders)
 						{
-							int idx = std::stoi(result[1]);
-							if (idx >= 0 && idx < m_sectionHeaders.size())
+							std::string name = (const char*)sec.Name;
+							std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::toupper(c); });
+
+							if (result[1] == name)
 							{
 								if (result.size() == 3)
 								{
@@ -237,1203 +1117,2828 @@ void PEFile::Run()
 										printByte(&m_sectionHeaders[idx], sizeof(IMAGE_SECTION_HEADER));
 									else if (result[2] == "-RB")
 										printByteAndRaw(&m_sectionHeaders[idx], sizeof(IMAGE_SECTION_HEADER));
+									else if (result[2] == "-E")
+										printEntropyWindows(idx);
 									else
 										std::cout << "\'" << result[2] << "\' () ùٸ ɼ ƴմϴ." <<
 										std::endl << "  SH -h Էϼ.\n" << std::endl;
 								}
 								else if (result.size() == 2)
-									printSectionHeader(m_sectionHeaders[idx]);
+									printSectionHeader(sec, GetSectionEntropy()[idx]);
 								else
 									std::cout << "ùٸ ɼ  ƴմϴ." <<
 									std::endl << "  SH -h Էϼ.\n" << std::endl;
+								success = true;
+								break;
 							}
-							else
-								std::cout << "ùٸ  ε Էϼ." << std::endl << std::endl;
-						}
-						else
-						{
-							int idx = 0;
-							bool success = false;
-							for (auto sec : m_sectionHeaders)
-							{
-								std::string name = (const char*)sec.Name;
-								std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::toupper(c); });
-
-								if (result[1] == name)
-								{
-									if (result.size() == 3)
-									{
-										if (result[2] == "-R")
-											printRaw(&m_sectionHeaders[idx], sizeof(IMAGE_SECTION_HEADER));
-										else if (result[2] == "-B")
-											printByte(&m_sectionHeaders[idx], sizeof(IMAGE_SECTION_HEADER));
-										else if (result[2] == "-RB")
-											printByteAndRaw(&m_sectionHeaders[idx], sizeof(IMAGE_SECTION_HEADER));
-										else
-											std::cout << "\'" << result[2] << "\' () ùٸ ɼ ƴմϴ." <<
-											std::endl << "  SH -h Էϼ.\n" << std::endl;
-									}
-									else if (result.size() == 2)
-										printSectionHeader(sec);
-									else
-										std::cout << "ùٸ ɼ  ƴմϴ." <<
-										std::endl << "  SH -h Էϼ.\n" << std::endl;
-									success = true;
-									break;
-								}
-								idx++;
-							}
-							if (!success)
-								std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
-								std::endl << "  SH -h Էϼ.\n" << std::endl;
+							idx++;
 						}
-					}						
-				}
+						if (!success)
+							std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+							std::endl << "  SH -h Էϼ.\n" << std::endl;
+					}
+				}						
 			}
-			else if (result[0] == "IDT") 
+		}
+		else if (result[0] == "IDT") 
+		{
+			if (result.size() == 1)
+				printImportDirectoyTable();
+			else if (result.size() == 2)
 			{
-				if (result.size() == 1)
-					printImportDirectoyTable();
-				else if (result.size() == 2)
+				if (result[1] == "-H")
+					printHelp(result[0]);
+				else if (result[1] == "-R")
 				{
-					if (result[1] == "-H")
-						printHelp(result[0]);
-					else if (result[1] == "-R")
-					{
-						for (auto iid : m_IIDs)
-						{
-							std::cout << iid.Name.c_str() << std::endl;
-							printRaw(&iid.iid, sizeof(IMAGE_IMPORT_DESCRIPTOR));
-						}
-					}
-					else if (result[1] == "-B")
-					{
-						for (auto iid : m_IIDs)
-						{
-							std::cout << iid.Name.c_str() << std::endl;
-							printByte(&iid.iid, sizeof(IMAGE_IMPORT_DESCRIPTOR));
-						}
-					}
-					else if (result[1] == "-RB")
+					for (auto iid : m_IIDs)
 					{
-						for (auto iid : m_IIDs)
-						{
-							std::cout << iid.Name.c_str() << std::endl;
-							printByteAndRaw(&iid.iid, sizeof(IMAGE_IMPORT_DESCRIPTOR));
-						}
+						m_out.line(iid.Name);
+						printRaw(&iid.iid, sizeof(IMAGE_IMPORT_DESCRIPTOR));
 					}
-					else
-						std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
-						std::endl << "  IDT -h Էϼ.\n" << std::endl;
-				}
-				else
-				{
-					std::cout << "ùٸ ɼ  ƴմϴ." <<
-						std::endl << "  INT -h Էϼ.\n" << std::endl;
 				}
-			}
-			else if (result[0] == "INT")
-			{
-				if (result.size() == 1)
-					printImportNameTable();
-				else if (result.size() == 2)
+				else if (result[1] == "-B")
 				{
-					if (result[1] == "-H")
-						printHelp(result[0]);
-					else if (result[1] == "-R")
-					{
-						if (x86)
-							printRaw(m_INTx86.data(), m_INTx86.size(), 0, sizeof(INT_Elementx86), sizeof(DWORD));
-						else
-							printRaw(m_INT.data(), m_INT.size(), 0, sizeof(INT_Element), sizeof(ULONGLONG));
-					}
-					else if (result[1] == "-B")
-					{
-						if (x86)
-							printByte(m_INTx86.data(), m_INTx86.size(), 0, sizeof(INT_Elementx86), sizeof(DWORD));
-						else
-							printByte(m_INT.data(), m_INT.size(), 0, sizeof(INT_Element), sizeof(ULONGLONG));
-					}
-					else if (result[1] == "-RB")
+					for (auto iid : m_IIDs)
 					{
-						if (x86)
-							printByteAndRaw(m_INTx86.data(), m_INTx86.size(), 0, sizeof(INT_Elementx86), sizeof(DWORD));
-						else
-							printByteAndRaw(m_INT.data(), m_INT.size(), 0, sizeof(INT_Element), sizeof(ULONGLONG));
+						m_out.line(iid.Name);
+						printByte(&iid.iid, sizeof(IMAGE_IMPORT_DESCRIPTOR));
 					}
-					else
-						std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
-						std::endl << "  INT -h Էϼ.\n" << std::endl;
-				}
-				else
-				{
-					std::cout << "ùٸ ɼ  ƴմϴ." <<
-						std::endl << "  INT -h Էϼ.\n" << std::endl;
-				}
-			}
-			else if (result[0] == "IAT")
-			{
-				if (!hasIAT)
-				{
-					std::cout << "IAT INT ü Ǿϴ.\n" << std::endl;
-					continue;
 				}
-				if (result.size() == 1)
-					printImportAddressTable();
-				else if (result.size() == 2)
+				else if (result[1] == "-RB")
 				{
-					if (result[1] == "-H")
-						printHelp(result[0]);
-					else if (result[1] == "-R")
-					{
-						if (x86)
-							printRaw(m_IATx86.data(), m_IATx86.size(), 0, sizeof(DWORD), sizeof(DWORD));
-						else
-							printRaw(m_IAT.data(), m_IAT.size(), 0, sizeof(ULONGLONG), sizeof(ULONGLONG));
-					}
-					else if (result[1] == "-B")
+					for (auto iid : m_IIDs)
 					{
-						if (x86)
-							printByte(m_IATx86.data(), m_IATx86.size(), 0, sizeof(DWORD), sizeof(DWORD));
-						else
-							printByte(m_IAT.data(), m_IAT.size(), 0, sizeof(ULONGLONG), sizeof(ULONGLONG));
-					}
-					else if (result[1] == "-RB")
-					{
-						if (x86)
-							printByteAndRaw(m_IATx86.data(), m_IATx86.size(), 0, sizeof(DWORD), sizeof(DWORD));
-						else
-							printByteAndRaw(m_IAT.data(), m_IAT.size(), 0, sizeof(ULONGLONG), sizeof(ULONGLONG));
+						m_out.line(iid.Name);
+						printByteAndRaw(&iid.iid, sizeof(IMAGE_IMPORT_DESCRIPTOR));
 					}
-					else
-						std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
-						std::endl << "  IAT -h Էϼ.\n" << std::endl;
 				}
 				else
-				{
-					std::cout << "ùٸ ɼ  ƴմϴ." <<
-						std::endl << "  IAT -h Էϼ.\n" << std::endl;
-				}
+					std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+					std::endl << "  IDT -h Էϼ.\n" << std::endl;
 			}
-			else if (result[0] == "IED")
+			else
 			{
-				if (!exportDir)
-				{
-					std::cout << "Export Directory  ʽϴ.\n" << std::endl;
-					continue;
-				}
-				if (result.size() == 1)
-					printExportDirectory();
-				else if (result.size() == 2)
-				{
-					if (result[1] == "-H")
-						printHelp(result[0]);
-					else if (result[1] == "-R")
-						printRaw(&m_IED, sizeof(IMAGE_EXPORT_DIRECTORY));
-					else if (result[1] == "-B")
-						printByte(&m_IED, sizeof(IMAGE_EXPORT_DIRECTORY));
-					else if (result[1] == "-RB")
-						printByteAndRaw(&m_IED, sizeof(IMAGE_EXPORT_DIRECTORY));
-					else
-						std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
-						std::endl << "  IED -h Էϼ.\n" << std::endl;
-				}
-				else
-				{
-					std::cout << "ùٸ ɼ  ƴմϴ." <<
-						std::endl << "  IED -h Էϼ.\n" << std::endl;
-				}
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  INT -h Էϼ.\n" << std::endl;
 			}
-			else if (result[0] == "EAT")
+		}
+		else if (result[0] == "INT")
+		{
+			if (result.size() == 1)
+				printImportNameTable();
+			else if (result.size() == 2)
 			{
-				if (!exportDir)
-				{
-					std::cout << "Export Directory  ʽϴ.\n" << std::endl;
-					continue;
-				}
-				if (result.size() == 1)
-					printExportAddressTable();
-				else if (result.size() == 2)
-				{
-					if (result[1] == "-H")
-						printHelp(result[0]);
-					else if (result[1] == "-R")
-						printRaw(m_ExportTable.data(), m_ExportTable.size(), 8, sizeof(ExportElement), sizeof(DWORD));
-					else if (result[1] == "-B")
-						printByte(m_ExportTable.data(), m_ExportTable.size(), 8, sizeof(ExportElement), sizeof(DWORD));
-					else if (result[1] == "-RB")
-						printByteAndRaw(m_ExportTable.data(), m_ExportTable.size(), 8, sizeof(ExportElement), sizeof(DWORD));
-					else
-						std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
-						std::endl << "  EAT -h Էϼ.\n" << std::endl;
-				}
+				if (result[1] == "-H")
+					printHelp(result[0]);
+				else if (result[1] == "-R")
+					std::visit([this](auto& model) { printRaw(model.INT.data(), model.INT.size(), 0, sizeof(model.INT[0]), sizeof(model.INT[0].addr)); }, m_model);
+				else if (result[1] == "-B")
+					std::visit([this](auto& model) { printByte(model.INT.data(), model.INT.size(), 0, sizeof(model.INT[0]), sizeof(model.INT[0].addr)); }, m_model);
+				else if (result[1] == "-RB")
+					std::visit([this](auto& model) { printByteAndRaw(model.INT.data(), model.INT.size(), 0, sizeof(model.INT[0]), sizeof(model.INT[0].addr)); }, m_model);
 				else
-				{
-					std::cout << "ùٸ ɼ  ƴմϴ." <<
-						std::endl << "  EAT -h Էϼ.\n" << std::endl;
-				}
+					std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+					std::endl << "  INT -h Էϼ.\n" << std::endl;
 			}
-			else if (result[0] == "ENT")
+			else
 			{
-				if (!exportDir)
-				{
-					std::cout << "Export Directory  ʽϴ.\n" << std::endl;
-					continue;
-				}
-				if (result.size() == 1)
-					printExportNameTable();
-				else if (result.size() == 2)
-				{
-					if (result[1] == "-H")
-						printHelp(result[0]);
-					else if (result[1] == "-R")
-						printRaw(m_ExportTable.data(), m_ExportTable.size(), 4, sizeof(ExportElement), sizeof(DWORD));
-					else if (result[1] == "-B")
-						printByte(m_ExportTable.data(), m_ExportTable.size(), 4, sizeof(ExportElement), sizeof(DWORD));
-					else if (result[1] == "-RB")
-						printByteAndRaw(m_ExportTable.data(), m_ExportTable.size(), 4, sizeof(ExportElement), sizeof(DWORD));
-					else
-						std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
-						std::endl << "  ENT -h Էϼ.\n" << std::endl;
-				}
-				else
-				{
-					std::cout << "ùٸ ɼ  ƴմϴ." <<
-						std::endl << "  ENT -h Էϼ.\n" << std::endl;
-				}
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  INT -h Էϼ.\n" << std::endl;
 			}
-			else if (result[0] == "EOT")
+		}
+		else if (result[0] == "IAT")
+		{
+			if (!hasIAT)
 			{
-				if (!exportDir)
-				{
-					std::cout << "Export Directory  ʽϴ.\n" << std::endl;
-					continue;
-				}
-				if (result.size() == 1)
-					printExportOrdinalTable();
-				else if (result.size() == 2)
-				{
-					if (result[1] == "-H")
-						printHelp(result[0]);
-					else if (result[1] == "-R")
-						printRaw(m_ExportTable.data(), m_ExportTable.size(), 0, sizeof(ExportElement), sizeof(WORD));
-					else if (result[1] == "-B")
-						printByte(m_ExportTable.data(), m_ExportTable.size(), 0, sizeof(ExportElement), sizeof(WORD));
-					else if (result[1] == "-RB")
-						printByteAndRaw(m_ExportTable.data(), m_ExportTable.size(), 0, sizeof(ExportElement), sizeof(WORD));
-					else
-						std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
-						std::endl << "  EOT -h Էϼ.\n" << std::endl;
-				}
+				std::cout << "IAT INT ü Ǿϴ.\n" << std::endl;
+				return true;
+			}
+			if (result.size() == 1)
+				printImportAddressTable();
+			else if (result.size() == 2)
+			{
+				if (result[1] == "-H")
+					printHelp(result[0]);
+				else if (result[1] == "-R")
+					std::visit([this](auto& model) { printRaw(model.IAT.data(), model.IAT.size(), 0, sizeof(model.IAT[0]), sizeof(model.IAT[0])); }, m_model);
+				else if (result[1] == "-B")
+					std::visit([this](auto& model) { printByte(model.IAT.data(), model.IAT.size(), 0, sizeof(model.IAT[0]), sizeof(model.IAT[0])); }, m_model);
+				else if (result[1] == "-RB")
+					std::visit([this](auto& model) { printByteAndRaw(model.IAT.data(), model.IAT.size(), 0, sizeof(model.IAT[0]), sizeof(model.IAT[0])); }, m_model);
 				else
-				{
+					std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+					std::endl << "  IAT -h Էϼ.\n" << std::endl;
+			}
+			else
+			{
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  IAT -h Էϼ.\n" << std::endl;
+			}
+		}
+		else if (result[0] == "IED")
+		{
+			if (!exportDir)
+			{
+				std::cout << "Export Directory  ʽϴ.\n" << std::endl;
+				return true;
+			}
+			if (result.size() == 1)
+				printExportDirectory();
+			else if (result.size() == 2)
+			{
+				if (result[1] == "-H")
+					printHelp(result[0]);
+				else if (result[1] == "-R")
+					printRaw(&m_IED, sizeof(IMAGE_EXPORT_DIRECTORY));
+				else if (result[1] == "-B")
+					printByte(&m_IED, sizeof(IMAGE_EXPORT_DIRECTORY));
+				else if (result[1] == "-RB")
+					printByteAndRaw(&m_IED, sizeof(IMAGE_EXPORT_DIRECTORY));
+				else
+					std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+					std::endl << "  IED -h Էϼ.\n" << std::endl;
+			}
+			else
+			{
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  IED -h Էϼ.\n" << std::endl;
+			}
+		}
+		else if (result[0] == "EAT")
+		{
+			if (!exportDir)
+			{
+				std::cout << "Export Directory  ʽϴ.\n" << std::endl;
+				return true;
+			}
+			if (result.size() == 1)
+				printExportAddressTable();
+			else if (result.size() == 2)
+			{
+				if (result[1] == "-H")
+					printHelp(result[0]);
+				else if (result[1] == "-R")
+					printRaw(m_ExportTable.data(), m_ExportTable.size(), 8, sizeof(ExportElement), sizeof(DWORD));
+				else if (result[1] == "-B")
+					printByte(m_ExportTable.data(), m_ExportTable.size(), 8, sizeof(ExportElement), sizeof(DWORD));
+				else if (result[1] == "-RB")
+					printByteAndRaw(m_ExportTable.data(), m_ExportTable.size(), 8, sizeof(ExportElement), sizeof(DWORD));
+				else
+					std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+					std::endl << "  EAT -h Էϼ.\n" << std::endl;
+			}
+			else
+			{
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  EAT -h Էϼ.\n" << std::endl;
+			}
+		}
+		else if (result[0] == "ENT")
+		{
+			if (!exportDir)
+			{
+				std::cout << "Export Directory  ʽϴ.\n" << std::endl;
+				return true;
+			}
+			if (result.size() == 1)
+				printExportNameTable();
+			else if (result.size() == 2)
+			{
+				if (result[1] == "-H")
+					printHelp(result[0]);
+				else if (result[1] == "-R")
+					printRaw(m_ExportTable.data(), m_ExportTable.size(), 4, sizeof(ExportElement), sizeof(DWORD));
+				else if (result[1] == "-B")
+					printByte(m_ExportTable.data(), m_ExportTable.size(), 4, sizeof(ExportElement), sizeof(DWORD));
+				else if (result[1] == "-RB")
+					printByteAndRaw(m_ExportTable.data(), m_ExportTable.size(), 4, sizeof(ExportElement), sizeof(DWORD));
+				else
+					std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+					std::endl << "  ENT -h Էϼ.\n" << std::endl;
+			}
+			else
+			{
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  ENT -h Էϼ.\n" << std::endl;
+			}
+		}
+		else if (result[0] == "EOT")
+		{
+			if (!exportDir)
+			{
+				std::cout << "Export Directory  ʽϴ.\n" << std::endl;
+				return true;
+			}
+			if (result.size() == 1)
+				printExportOrdinalTable();
+			else if (result.size() == 2)
+			{
+				if (result[1] == "-H")
+					printHelp(result[0]);
+				else if (result[1] == "-R")
+					printRaw(m_ExportTable.data(), m_ExportTable.size(), 0, sizeof(ExportElement), sizeof(WORD));
+				else if (result[1] == "-B")
+					printByte(m_ExportTable.data(), m_ExportTable.size(), 0, sizeof(ExportElement), sizeof(WORD));
+				else if (result[1] == "-RB")
+					printByteAndRaw(m_ExportTable.data(), m_ExportTable.size(), 0, sizeof(ExportElement), sizeof(WORD));
+				else
+					std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+					std::endl << "  EOT -h Էϼ.\n" << std::endl;
+			}
+			else
+			{
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  EOT -h Էϼ.\n" << std::endl;
+			}
+		}
+		else if (result[0] == "EXP")
+		{
+			if (!exportDir)
+			{
+				std::cout << "Export Directory  ʽϴ.\n" << std::endl;
+				return true;
+			}
+
+			// export names are case sensitive, take the argument before it was upper-cased
+			std::vector<std::string> args;
+			std::istringstream lineStream(line);
+			while (lineStream >> word)
+				args.push_back(word);
+
+			ExportSymbol symbol;
+			if (result.size() == 2 && result[1] == "-H")
+				printHelp(result[0]);
+			else if (result.size() == 2)
+			{
+				if (FindExport(args[1], symbol))
+					printExportSymbol(symbol, symbol.rva);
+				else
+					std::cout << "\'" << args[1] << "\' ̸ Export  ʽϴ.\n" << std::endl;
+			}
+			else if (result.size() == 3 && (result[1] == "-O" || result[1] == "-A"))
+			{
+				DWORD value = 0;
+				try {
+					value = std::stoul(result[2], nullptr, 16);
+				}
+				catch (...) {
+					std::cout << "\'" << result[2] << "\' () ùٸ 16  ƴմϴ.\n" << std::endl;
+					return true;
+				}
+
+				if (result[1] == "-O" && FindExportByOrdinal(value, symbol))
+					printExportSymbol(symbol, symbol.rva);
+				else if (result[1] == "-A" && FindExportByAddress(value, symbol))
+					printExportSymbol(symbol, value);
+				else
+					std::cout << "شϴ Export  ʽϴ.\n" << std::endl;
+			}
+			else
+			{
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "ڼ  EXP -h Էϼ.\n" << std::endl;
+			}
+		}
+		else if (result[0] == "DIDT" || result[0] == "DINT")
+		{
+			if (m_delayIIDs.empty())
+			{
+				std::cout << "Delay Import Directory  ʽϴ.\n" << std::endl;
+				return true;
+			}
+			bool table = result[0] == "DIDT";
+			if (result.size() == 1)
+			{
+				if (table)
+					printDelayImportDirectoryTable();
+				else
+					printDelayImportNameTable();
+			}
+			else if (result.size() == 2 && result[1] == "-H")
+				printHelp(result[0]);
+			else if (result.size() == 2 && table && (result[1] == "-R" || result[1] == "-B" || result[1] == "-RB"))
+			{
+				for (auto did : m_delayIIDs)
+				{
+					m_out.line(did.Name);
+					if (result[1] == "-R")
+						printRaw(&did.did, sizeof(IMAGE_DELAYLOAD_DESCRIPTOR));
+					else if (result[1] == "-B")
+						printByte(&did.did, sizeof(IMAGE_DELAYLOAD_DESCRIPTOR));
+					else
+						printByteAndRaw(&did.did, sizeof(IMAGE_DELAYLOAD_DESCRIPTOR));
+				}
+			}
+			else if (result.size() == 2 && !table && result[1] == "-R")
+				std::visit([this](auto& model) { printRaw(model.delayINT.data(), model.delayINT.size(), 0, sizeof(model.delayINT[0]), sizeof(model.delayINT[0].addr)); }, m_model);
+			else if (result.size() == 2 && !table && result[1] == "-B")
+				std::visit([this](auto& model) { printByte(model.delayINT.data(), model.delayINT.size(), 0, sizeof(model.delayINT[0]), sizeof(model.delayINT[0].addr)); }, m_model);
+			else if (result.size() == 2 && !table && result[1] == "-RB")
+				std::visit([this](auto& model) { printByteAndRaw(model.delayINT.data(), model.delayINT.size(), 0, sizeof(model.delayINT[0]), sizeof(model.delayINT[0].addr)); }, m_model);
+			else
+				std::cout << "\'" << result[1] << "\' () ùٸ ɼ ƴմϴ." <<
+					std::endl << "  " << result[0] << " -h Էϼ.\n" << std::endl;
+		}
+		else if (result[0] == "RES")
+		{
+			if (!GetResourceTree().isOpen())
+			{
+				std::cout << "Resource Directory  ʽϴ.\n" << std::endl;
+				return true;
+			}
+			if (result.size() == 1)
+				printResourceTypes();
+			else if (result.size() == 2)
+			{
+				if (result[1] == "-H")
+					printHelp(result[0]);
+				else if (result[1] == "-V")
+					printVersionInfo();
+				else if (result[1] == "-M")
+					printManifest();
+				else
+				{
+					// a known type name, a hex id or the name of a custom type
+					DWORD type = ResourceTree::npos;
+					for (DWORD id = 0; id < 32; ++id)
+					{
+						const char* name = ResourceTree::TypeName(id);
+						if (name && result[1] == name)
+							type = m_resources.find(0, id);
+					}
+					if (type == ResourceTree::npos && std::all_of(result[1].begin(), result[1].end(), ::isxdigit))
+					{
+						// an id past 32 bits cannot be a type, it is looked up as a name below
+						try {
+							unsigned long long id = std::stoull(result[1], nullptr, 16);
+							if (id <= 0xFFFFFFFF)
+								type = m_resources.find(0, (DWORD)id);
+						}
+						catch (...) {
+						}
+					}
+					if (type == ResourceTree::npos)
+						type = m_resources.find(0, std::string_view(result[1]));
+
+					if (type != ResourceTree::npos)
+						printResources(type);
+					else
+						std::cout << "\'" << result[1] << "\' Ÿ Resource  ʽϴ.\n" << std::endl;
+				}
+			}
+			else
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  RES -h Էϼ.\n" << std::endl;
+		}
+		else if (result[0] == "RELOC")
+		{
+			if (GetRelocations().blocks() == 0)
+			{
+				std::cout << "Base Relocation Directory  ʽϴ.\n" << std::endl;
+				return true;
+			}
+			if (result.size() == 1)
+				printRelocationSummary();
+			else if (result.size() == 2 && result[1] == "-H")
+				printHelp(result[0]);
+			else if (result.size() == 2 && result[1] == "-A")
+				printRelocations(0, m_relocations.entries().size());
+			else if (result.size() == 3)
+			{
+				DWORD begin = 0, end = 0;
+				try {
+					begin = std::stoul(result[1], nullptr, 16);
+					end = std::stoul(result[2], nullptr, 16);
+				}
+				catch (...) {
+					std::cout << "ùٸ 16  Էϼ.\n" << std::endl;
+					return true;
+				}
+
+				size_t first, last;
+				m_relocations.range(begin, end, first, last);
+				printRelocations(first, last);
+			}
+			else
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  RELOC -h Էϼ.\n" << std::endl;
+		}
+		else if (result[0] == "FUNC")
+		{
+			if (GetFunctionTable().size() == 0)
+			{
+				std::cout << "x64 Exception Directory  ʽϴ.\n" << std::endl;
+				return true;
+			}
+			if (result.size() == 1)
+			{
+				printFunctionSummary();
+				return true;
+			}
+			if (result.size() == 2 && result[1] == "-H")
+			{
+				printHelp(result[0]);
+				return true;
+			}
+
+			// the path of -f keeps its case
+			std::vector<std::string> args;
+			std::istringstream lineStream(line);
+			while (lineStream >> word)
+				args.push_back(word);
+
+			std::vector<DWORD> rvas;
+			if (result[1] == "-A")
+			{
+				for (size_t i = 0; i < m_functions.size(); ++i)
+					rvas.push_back(m_functions.entry(i).BeginAddress);
+			}
+			else if (result[1] == "-F" && args.size() == 3)
+			{
+				std::ifstream list(args[2]);
+				if (!list.is_open())
+				{
+					std::cout << "\'" << args[2] << "\'    ϴ.\n" << std::endl;
+					return true;
+				}
+				std::string value;
+				while (list >> value)
+				{
+					try {
+						rvas.push_back(std::stoul(value, nullptr, 16));
+					}
+					catch (...) {
+					}
+				}
+			}
+			else
+			{
+				for (size_t i = 1; i < result.size(); ++i)
+				{
+					try {
+						rvas.push_back(std::stoul(result[i], nullptr, 16));
+					}
+					catch (...) {
+						std::cout << "\'" << result[i] << "\' () ùٸ 16  ƴմϴ.\n" << std::endl;
+						return true;
+					}
+				}
+			}
+			printFunctions(rvas);
+		}
+		else if (result[0] == "DEBUG")
+		{
+			if (GetDebugDirectory().entries().empty())
+			{
+				std::cout << "Debug Directory  ʽϴ.\n" << std::endl;
+				return true;
+			}
+			if (result.size() == 1)
+				printDebugDirectory();
+			else if (result.size() == 2 && result[1] == "-H")
+				printHelp(result[0]);
+			else if (result.size() == 2 && result[1] == "-P")
+				printPogo();
+			else
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  DEBUG -h Էϼ.\n" << std::endl;
+		}
+		else if (result[0] == "CERT")
+		{
+			if (result.size() == 1)
+			{
+				if (HashAuthenticode())
+					printCertificates();
+				else
+					std::cout << " дµ Ͽϴ.\n" << std::endl;
+			}
+			else if (result.size() == 2 && result[1] == "-H")
+				printHelp(result[0]);
+			else
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  CERT -h Էϼ.\n" << std::endl;
+		}
+		else if (result[0] == "STRINGS")
+		{
+			size_t minLength = StringScanner::defaultMinLength;
+			bool asciiOnly = false, wideOnly = false;
+			for (size_t i = 1; i < result.size(); ++i)
+			{
+				if (result.size() == 2 && result[i] == "-H")
+				{
+					printHelp(result[0]);
+					return true;
+				}
+				else if (result[i] == "-A")
+					asciiOnly = true;
+				else if (result[i] == "-U")
+					wideOnly = true;
+				else if (result[i] == "-N" && i + 1 < result.size())
+				{
+					try {
+						minLength = std::stoul(result[++i]);
+					}
+					catch (...) {
+						std::cout << "ùٸ   Էϼ.\n" << std::endl;
+						return true;
+					}
+				}
+				else
+				{
 					std::cout << "ùٸ ɼ  ƴմϴ." <<
-						std::endl << "  EOT -h Էϼ.\n" << std::endl;
+						std::endl << "  STRINGS -h Էϼ.\n" << std::endl;
+					return true;
 				}
 			}
-			else if (result[0] == "HELP")
-				printHelp("help");
-			else if (result[0] == "EXIT")
-				break;
-			else if (result[0] == "CLS")
-				system("cls");
+
+			if (ScanStrings(minLength))
+				printStrings(!wideOnly || asciiOnly, !asciiOnly || wideOnly);
+			else
+				std::cout << " дµ Ͽϴ.\n" << std::endl;
 		}
-		else
+		else if (result[0] == "SIG")
+		{
+			if (result.size() == 2 && result[1] == "-H")
+			{
+				printHelp(result[0]);
+				return true;
+			}
+
+			// the rule file path keeps its case
+			std::vector<std::string> args;
+			std::istringstream lineStream(line);
+			while (lineStream >> word)
+				args.push_back(word);
+			if (args.size() != 2)
+			{
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  SIG -h Էϼ.\n" << std::endl;
+				return true;
+			}
+
+			SignatureSet rules;
+			if (!rules.load(args[1]))
+				std::cout << "Ģ  дµ Ͽϴ. (" << rules.error() << ")\n" << std::endl;
+			else if (!MatchSignatures(rules))
+				std::cout << " дµ Ͽϴ.\n" << std::endl;
+			else
+				printSignatures();
+
+			// the matches point into this set
+			m_signatureMatches.clear();
+			m_signatureSet = nullptr;
+		}
+		else if (result[0] == "HASH")
+		{
+			if (result.size() == 1)
+			{
+				if (Hash())
+					printHashes();
+				else
+					std::cout << " дµ Ͽϴ.\n" << std::endl;
+			}
+			else if (result.size() == 2 && result[1] == "-H")
+				printHelp(result[0]);
+			else if (result.size() == 2 && result[1] == "-F")
+			{
+				GetFingerprint();
+				printFingerprint();
+			}
+			else
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  HASH -h Էϼ.\n" << std::endl;
+		}
+		else if (result[0] == "OVERLAY")
+		{
+			size_t dumpSize = 0;
+			if (result.size() == 2 && result[1] == "-H")
+			{
+				printHelp(result[0]);
+				return true;
+			}
+			else if ((result.size() == 2 || result.size() == 3) && result[1] == "-X")
+			{
+				dumpSize = 0x100;
+				if (result.size() == 3)
+				{
+					try {
+						dumpSize = std::stoul(result[2]);
+					}
+					catch (...) {
+						std::cout << "ùٸ Ʈ  Էϼ.\n" << std::endl;
+						return true;
+					}
+				}
+			}
+			else if (result.size() != 1)
+			{
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  OVERLAY -h Էϼ.\n" << std::endl;
+				return true;
+			}
+
+			if (ScanOverlay())
+				printOverlay(dumpSize);
+			else
+				std::cout << " дµ Ͽϴ.\n" << std::endl;
+		}
+		else if (result[0] == "JSON")
+		{
+			if (result.size() == 1)
+			{
+				JsonWriter json(m_out);
+				WriteJson(json);
+				json.endLine();
+			}
+			else if (result.size() == 2 && result[1] == "-H")
+				printHelp(result[0]);
+			else if (result.size() == 2 && result[1] == "-HEADERS")
+			{
+				JsonWriter json(m_out);
+				WriteJson(json, true);
+				json.endLine();
+			}
+			else
+				std::cout << "ùٸ ɼ  ƴմϴ." <<
+					std::endl << "  JSON -h Էϼ.\n" << std::endl;
+		}
+		else if (result[0] == "HELP")
+			printHelp("help");
+		else if (result[0] == "EXIT")
+			return false;
+		else if (result[0] == "CLS")
+			system("cls");
+	}
+	else
+	{
+		std::cout << "\'" << cmd << "\'() ùٸ ɾ ƴմϴ.\n" << std::endl;
+	}
+
+	return true;
+}
+
+bool PEFile::Benchmark(int iterations)
+{
+#ifdef PEVIEW_COUNT_ALLOCATIONS
+	size_t allocations = AllocationCount();
+#endif
+	readDirectory(IMAGE_DIRECTORY_ENTRY_IMPORT);
+	readDirectory(IMAGE_DIRECTORY_ENTRY_EXPORT);
+#ifdef PEVIEW_COUNT_ALLOCATIONS
+	size_t parseAllocations = AllocationCount() - allocations;
+#endif
+
+	size_t importRows = std::visit([](const auto& model) { return model.INT.size(); }, m_model);
+	size_t rows = 0;
+	size_t before = m_out.written();
+#ifdef PEVIEW_COUNT_ALLOCATIONS
+	allocations = AllocationCount();
+#endif
+
+	// render the big tables to stdout, redirect it to NUL to measure the renderer alone
+	auto begin = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		printImportNameTable();
+		rows += importRows;
+		if (hasIAT)
+		{
+			printImportAddressTable();
+			rows += importRows;
+		}
+		if (exportDir)
 		{
-			std::cout << "\'" << cmd << "\'() ùٸ ɾ ƴմϴ.\n" << std::endl;
+			printExportAddressTable();
+			printExportNameTable();
+			printExportOrdinalTable();
+			rows += m_ExportTable.size() * 3;
 		}
+	}
+	m_out.flush();
+#ifdef PEVIEW_COUNT_ALLOCATIONS
+	size_t printAllocations = AllocationCount() - allocations;
+#endif
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	if (seconds <= 0)
+		seconds = 1e-9;
+	double mb = (m_out.written() - before) / (1024.0 * 1024.0);
+
+	fprintf(stderr, "%zu rows, %.1f MB in %.3f s : %.0f rows/s, %.1f MB/s\n",
+		rows, mb, seconds, rows / seconds, mb / seconds);
+
+#ifdef PEVIEW_COUNT_ALLOCATIONS
+	// tables grow geometrically and the arena by 64KB blocks, so a parse that allocates nothing
+	// per symbol stays within a few allocations per doubling of the symbol count
+	size_t symbols = importRows + m_ExportTable.size();
+	size_t doublings = 1;
+	for (size_t n = symbols; n; n >>= 1)
+		++doublings;
+	size_t parseLimit = 16 + 8 * doublings;
+	bool passed = parseAllocations <= parseLimit && printAllocations == 0;
+	fprintf(stderr, "heap allocations : parse %zu for %zu symbols (limit %zu), print %zu (limit 0) : %s\n",
+		parseAllocations, symbols, parseLimit, printAllocations, passed ? "OK" : "FAIL");
+	return passed;
+#else
+	fprintf(stderr, "heap allocations : not counted, build the Bench configuration\n");
+	return true;
+#endif
+}
+
+void PEFile::serialize(const CacheKey& key, std::vector<BYTE>& blob)
+{
+	// every block starts on an 8 byte boundary so the entry can be used in place
+	auto append = [&blob](const void* data, size_t size) {
+		const BYTE* p = static_cast<const BYTE*>(data);
+		blob.insert(blob.end(), p, p + size);
+		blob.resize((blob.size() + 7) & ~(size_t)7);
+	};
+
+	std::vector<char> pool;
+	auto intern = [&pool](std::string_view text, DWORD& name, DWORD& length) {
+		name = (DWORD)pool.size();
+		length = (DWORD)text.size();
+		pool.insert(pool.end(), text.begin(), text.end());
+		pool.push_back('\0');
+	};
+
+	CacheHeader header = {};
+	header.magic = ParseCache::magic;
+	header.version = ParseCache::version;
+	header.key = key;
+	header.flags = (IsX86() ? ParseCache::FlagX86 : 0) | (hasIAT ? ParseCache::FlagIAT : 0) | (exportDir ? ParseCache::FlagExport : 0) | cachedDirectories();
+	header.stubSize = (DWORD)m_dosStubByte.size();
+	header.sectionCount = (DWORD)m_sectionHeaders.size();
+	header.importCount = (DWORD)m_IIDs.size();
+
+	std::vector<CacheImport> imports(m_IIDs.size());
+	for (size_t i = 0; i < m_IIDs.size(); ++i)
+	{
+		imports[i].iid = m_IIDs[i].iid;
+		intern(m_IIDs[i].Name, imports[i].name, imports[i].nameLength);
+	}
+
+	std::vector<CacheThunk> thunks;
+	std::vector<ULONGLONG> iat;
+	std::visit([&](const auto& model) {
+		thunks.resize(model.INT.size());
+		for (size_t i = 0; i < model.INT.size(); ++i)
+		{
+			thunks[i] = {};
+			thunks[i].addr = model.INT[i].addr;
+			thunks[i].hint = model.INT[i].Hint;
+			intern(model.INT[i].Name, thunks[i].name, thunks[i].nameLength);
+		}
+		iat.assign(model.IAT.begin(), model.IAT.end());
+	}, m_model);
+	header.thunkCount = (DWORD)thunks.size();
+	header.iatCount = (DWORD)iat.size();
+
+	std::vector<CacheExport> exports(m_ExportTable.size());
+	for (size_t i = 0; i < m_ExportTable.size(); ++i)
+	{
+		exports[i] = {};
+		exports[i].rva = m_ExportTable[i].rva;
+		exports[i].funcAddr = m_ExportTable[i].funcAddr;
+		exports[i].ordinal = m_ExportTable[i].ordinal;
+		intern(m_ExportTable[i].name, exports[i].name, exports[i].nameLength);
+	}
+	header.exportCount = (DWORD)exports.size();
+	header.functionCount = (DWORD)m_exportFunctions.size();
+	intern(m_exportName, header.exportName, header.exportNameLength);
+	header.stringBytes = (DWORD)pool.size();
+
+	blob.clear();
+	append(&header, sizeof(header));
+	append(&m_dosHeader, sizeof(m_dosHeader));
+	append(m_dosStubByte.data(), m_dosStubByte.size());
+	std::visit([&](const auto& model) { append(&model.ntHeaders, sizeof(model.ntHeaders)); }, m_model);
+	append(m_sectionHeaders.data(), m_sectionHeaders.size() * sizeof(IMAGE_SECTION_HEADER));
+	append(imports.data(), imports.size() * sizeof(CacheImport));
+	append(thunks.data(), thunks.size() * sizeof(CacheThunk));
+	append(iat.data(), iat.size() * sizeof(ULONGLONG));
+	append(&m_IED, sizeof(m_IED));
+	append(exports.data(), exports.size() * sizeof(CacheExport));
+	append(m_exportFunctions.data(), m_exportFunctions.size() * sizeof(DWORD));
+	append(pool.data(), pool.size());
+}
+
+DWORD PEFile::cachedDirectories() const
+{
+	return (m_directoryRead[IMAGE_DIRECTORY_ENTRY_IMPORT] ? ParseCache::FlagImportsRead : 0)
+		| (m_directoryRead[IMAGE_DIRECTORY_ENTRY_EXPORT] ? ParseCache::FlagExportsRead : 0);
+}
+
+bool PEFile::restore(const MappedFile& entry)
+{
+	const CacheHeader* header = entry.as<CacheHeader>(0);
+	if (!header)
+		return false;
+
+	// walk the blocks in the order serialize() wrote them
+	ULONGLONG offset = 0;
+	bool valid = true;
+	auto take = [&](ULONGLONG size) {
+		const BYTE* p = entry.view(offset, size);
+		valid = valid && p;
+		offset = (offset + size + 7) & ~7ull;
+		return p;
+	};
+
+	bool x86 = (header->flags & ParseCache::FlagX86) != 0;
+	take(sizeof(CacheHeader));
+	const BYTE* dosHeader = take(sizeof(IMAGE_DOS_HEADER));
+	const BYTE* stub = take(header->stubSize);
+	const BYTE* ntHeaders = take(x86 ? sizeof(IMAGE_NT_HEADERS32) : sizeof(IMAGE_NT_HEADERS64));
+	auto sections = reinterpret_cast<const IMAGE_SECTION_HEADER*>(take((ULONGLONG)header->sectionCount * sizeof(IMAGE_SECTION_HEADER)));
+	auto imports = reinterpret_cast<const CacheImport*>(take((ULONGLONG)header->importCount * sizeof(CacheImport)));
+	auto thunks = reinterpret_cast<const CacheThunk*>(take((ULONGLONG)header->thunkCount * sizeof(CacheThunk)));
+	auto iat = reinterpret_cast<const ULONGLONG*>(take((ULONGLONG)header->iatCount * sizeof(ULONGLONG)));
+	auto ied = take(sizeof(IMAGE_EXPORT_DIRECTORY));
+	auto exports = reinterpret_cast<const CacheExport*>(take((ULONGLONG)header->exportCount * sizeof(CacheExport)));
+	auto functions = reinterpret_cast<const DWORD*>(take((ULONGLONG)header->functionCount * sizeof(DWORD)));
+	const char* pool = reinterpret_cast<const char*>(take(header->stringBytes));
+	if (!valid)
+		return false;
+
+	// names point into the pool, check them all before anything is filled in
+	auto inPool = [header](DWORD name, DWORD length) { return name < header->stringBytes && length < header->stringBytes - name; };
+	bool names = inPool(header->exportName, header->exportNameLength);
+	for (DWORD i = 0; i < header->importCount; ++i)
+		names = names && inPool(imports[i].name, imports[i].nameLength);
+	for (DWORD i = 0; i < header->thunkCount; ++i)
+		names = names && inPool(thunks[i].name, thunks[i].nameLength);
+	for (DWORD i = 0; i < header->exportCount; ++i)
+		names = names && inPool(exports[i].name, exports[i].nameLength);
+	if (!names)
+		return false;
+
+	memcpy(&m_dosHeader, dosHeader, sizeof(m_dosHeader));
+	m_dosStubByte.assign(reinterpret_cast<const char*>(stub), header->stubSize);
+	selectModel(x86 ? IMAGE_NT_OPTIONAL_HDR32_MAGIC : IMAGE_NT_OPTIONAL_HDR64_MAGIC);
+	m_sectionHeaders.assign(sections, sections + header->sectionCount);
+
+	m_IIDs.resize(header->importCount);
+	for (DWORD i = 0; i < header->importCount; ++i)
+	{
+		m_IIDs[i].iid = imports[i].iid;
+		m_IIDs[i].Name = std::string_view(pool + imports[i].name, imports[i].nameLength);
+	}
+
+	std::visit([&](auto& model) {
+		typedef typename std::decay_t<decltype(model)>::traits Traits;
+		memcpy(&model.ntHeaders, ntHeaders, sizeof(model.ntHeaders));
+
+		model.INT.resize(header->thunkCount);
+		for (DWORD i = 0; i < header->thunkCount; ++i)
+		{
+			model.INT[i].addr = (typename Traits::Thunk)thunks[i].addr;
+			model.INT[i].Hint = thunks[i].hint;
+			model.INT[i].Name = std::string_view(pool + thunks[i].name, thunks[i].nameLength);
+		}
+		model.IAT.assign(iat, iat + header->iatCount);
+	}, m_model);
+
+	memcpy(&m_IED, ied, sizeof(m_IED));
+	m_exportName = std::string_view(pool + header->exportName, header->exportNameLength);
+	m_ExportTable.resize(header->exportCount);
+	for (DWORD i = 0; i < header->exportCount; ++i)
+	{
+		m_ExportTable[i].ordinal = exports[i].ordinal;
+		m_ExportTable[i].rva = exports[i].rva;
+		m_ExportTable[i].funcAddr = exports[i].funcAddr;
+		m_ExportTable[i].name = std::string_view(pool + exports[i].name, exports[i].nameLength);
+	}
+	m_exportFunctions.assign(functions, functions + header->functionCount);
+
+	// directories the entry does not hold are read from the file on first access as usual
+	m_cacheFlags = header->flags & (ParseCache::FlagImportsRead | ParseCache::FlagExportsRead);
+	if (m_cacheFlags & ParseCache::FlagImportsRead)
+	{
+		hasIAT = (header->flags & ParseCache::FlagIAT) != 0;
+		m_directoryRead[IMAGE_DIRECTORY_ENTRY_IMPORT] = true;
+	}
+	if (m_cacheFlags & ParseCache::FlagExportsRead)
+	{
+		exportDir = (header->flags & ParseCache::FlagExport) != 0;
+		m_directoryRead[IMAGE_DIRECTORY_ENTRY_EXPORT] = true;
+	}
+
+	m_sectionIndex.build(m_sectionHeaders, std::visit([](const auto& model) { return model.ntHeaders.OptionalHeader.SizeOfHeaders; }, m_model));
+	return true;
+}
+
+bool PEFile::readDosHeader(std::ifstream& file)
+{
+	file.seekg(0, std::ios::beg);
+	file.read(reinterpret_cast<char*>(&m_dosHeader), sizeof(IMAGE_DOS_HEADER));
+	
+	return file.good();
+}
+
+bool PEFile::readDosStub(std::ifstream& file)
+{
+	int size = m_dosHeader.e_lfanew - sizeof(IMAGE_DOS_HEADER);
+	m_dosStubByte = std::string(size, '\0');
+
+	file.seekg(sizeof(IMAGE_DOS_HEADER), std::ios::beg);
+	file.read(&m_dosStubByte[0], size);
+
+	return file.good();
+}
+
+bool PEFile::readNtHeaders(std::ifstream& file)
+{
+	// the optional header magic decides the layout of the rest
+	WORD magic = 0;
+	file.seekg(m_dosHeader.e_lfanew + offsetof(IMAGE_NT_HEADERS32, OptionalHeader), std::ios::beg);
+	file.read(reinterpret_cast<char*>(&magic), sizeof(WORD));
+	selectModel(magic);
+
+	file.seekg(m_dosHeader.e_lfanew, std::ios::beg);
+	std::visit([&file](auto& model) { file.read(reinterpret_cast<char*>(&model.ntHeaders), sizeof(model.ntHeaders)); }, m_model);
+	
+	return file.good();
+}
+
+bool PEFile::readSectionHeaders(std::ifstream& file)
+{
+	ULONGLONG offset = m_dosHeader.e_lfanew + std::visit([](const auto& model) { return sizeof(model.ntHeaders); }, m_model);
+	for (int i = 0; i < fileHeader().NumberOfSections; ++i)
+	{
+		IMAGE_SECTION_HEADER header;
+		file.seekg(offset + sizeof(IMAGE_SECTION_HEADER) * i, std::ios::beg);
+		file.read(reinterpret_cast<char*>(&header), sizeof(IMAGE_SECTION_HEADER));
+		m_sectionHeaders.push_back(header);
+	}
+	return file.good();
+}
+
+bool PEFile::readDirectory(int index)
+{
+	if (index < 0 || index >= IMAGE_NUMBEROF_DIRECTORY_ENTRIES)
+		return false;
+	if (m_directoryRead[index])
+		return true;
+	m_directoryRead[index] = true;
+
+	if (index >= (int)GetDirectoryCount() || GetDataDirectory(index).VirtualAddress == 0)
+		return true;
+
+	// a file restored from the cache has not been opened yet
+	if (m_cached && !m_image.isOpen())
+		m_image.open(m_filePath);
+	if (m_image.isOpen())
+		return readDirectory(m_image, index);
+
+	std::ifstream file(m_filePath, std::ios::binary);
+	if (!file.is_open())
+		return false;
+	return readDirectory(file, index);
+}
+
+template <typename Source>
+bool PEFile::readDirectory(Source& source, int index)
+{
+	DWORD rva = GetDataDirectory(index).VirtualAddress;
+	switch (index)
+	{
+	case IMAGE_DIRECTORY_ENTRY_EXPORT:
+		return readExportDirectory(source, rva);
+	case IMAGE_DIRECTORY_ENTRY_IMPORT:
+		return std::visit([&](auto& model) { return readImportDirectory(source, rva, model); }, m_model);
+	case IMAGE_DIRECTORY_ENTRY_RESOURCE:
+		return readResourceDirectory(rva);
+	case IMAGE_DIRECTORY_ENTRY_BASERELOC:
+		return readRelocationDirectory(rva);
+	case IMAGE_DIRECTORY_ENTRY_EXCEPTION:
+		return readExceptionDirectory(rva);
+	case IMAGE_DIRECTORY_ENTRY_DEBUG:
+		return readDebugDirectory(rva);
+	case IMAGE_DIRECTORY_ENTRY_SECURITY:
+		return readSecurityDirectory();
+	case IMAGE_DIRECTORY_ENTRY_DELAY_IMPORT:
+		return std::visit([&](auto& model) { return readDelayImportDirectory(source, rva, model); }, m_model);
+	}
+
+	return true;
+}
+
+bool PEFile::readExportDirectory(std::ifstream& file, DWORD rva)
+{
+	if (rva == 0)
+		return true;
+
+	ExportLayout layout;
+	if (!readValue(file, rva2raw(rva), m_IED) || !locateExports(layout))
+		return false;
+
+	m_exportName = readName(file, rva2raw(m_IED.Name));
+
+	// each array in one read, the first one that fails rejects the table
+	std::vector<DWORD> names(layout.nameCount);
+	std::vector<WORD> ordinals(layout.nameCount);
+	m_exportFunctions.resize(layout.functionCount);
+	if (!readArray(file, layout.names, names) || !readArray(file, layout.ordinals, ordinals) ||
+		!readArray(file, layout.functions, m_exportFunctions))
+	{
+		m_exportFunctions.clear();
+		return false;
+	}
+
+	m_ExportTable.reserve(names.size());
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		ExportElement en = {};
+		en.rva = names[i];
+		en.ordinal = ordinals[i];
+		en.funcAddr = en.ordinal < m_exportFunctions.size() ? m_exportFunctions[en.ordinal] : 0;
+
+		en.name = readName(file, rva2raw(en.rva));
+
+		m_ExportTable.push_back(en);
+	}
+
+	exportDir = true;
+	return true;
+}
+
+bool PEFile::locateExports(ExportLayout& layout)
+{
+	layout = {};
+	if (m_sectionIndex.translate(m_IED.AddressOfFunctions, layout.functions))
+	{
+		layout.functionCount = (std::min)(m_IED.NumberOfFunctions, maxExportFunctions);
+		layout.functionCount = (std::min)(layout.functionCount, m_sectionIndex.extent(m_IED.AddressOfFunctions) / (DWORD)sizeof(DWORD));
+	}
+
+	layout.nameCount = m_IED.NumberOfNames;
+	if (layout.nameCount == 0)
+		return true;
+	return m_sectionIndex.translate(m_IED.AddressOfNames, layout.names) &&
+		m_sectionIndex.translate(m_IED.AddressOfNameOrdinals, layout.ordinals) &&
+		layout.nameCount <= m_sectionIndex.extent(m_IED.AddressOfNames) / sizeof(DWORD) &&
+		layout.nameCount <= m_sectionIndex.extent(m_IED.AddressOfNameOrdinals) / sizeof(WORD);
+}
+
+std::string_view PEFile::readName(std::ifstream& file, ULONGLONG offset)
+{
+	m_nameBuffer.clear();
+	file.clear();
+	file.seekg(offset, std::ios::beg);
+	std::getline(file, m_nameBuffer, '\0');
+	return m_strings.intern(m_nameBuffer);
+}
+
+bool PEFile::readDosHeader(const MappedFile& image)
+{
+	return image.read(0, m_dosHeader);
+}
+
+bool PEFile::readDosStub(const MappedFile& image)
+{
+	if (m_dosHeader.e_lfanew < (LONG)sizeof(IMAGE_DOS_HEADER))
+		return false;
+
+	int size = m_dosHeader.e_lfanew - sizeof(IMAGE_DOS_HEADER);
+	const BYTE* stub = image.view(sizeof(IMAGE_DOS_HEADER), size);
+	if (!stub)
+		return false;
+
+	m_dosStubByte.assign(reinterpret_cast<const char*>(stub), size);
+	return true;
+}
+
+bool PEFile::readNtHeaders(const MappedFile& image)
+{
+	// the optional header magic decides the layout of the rest
+	WORD magic = 0;
+	if (!image.read(m_dosHeader.e_lfanew + offsetof(IMAGE_NT_HEADERS32, OptionalHeader), magic))
+		return false;
+	selectModel(magic);
+
+	return std::visit([&](auto& model) { return image.read(m_dosHeader.e_lfanew, model.ntHeaders); }, m_model);
+}
+
+bool PEFile::readSectionHeaders(const MappedFile& image)
+{
+	ULONGLONG offset = m_dosHeader.e_lfanew + std::visit([](const auto& model) { return sizeof(model.ntHeaders); }, m_model);
+	auto headers = image.span<IMAGE_SECTION_HEADER>(offset, fileHeader().NumberOfSections);
+	if (headers.size() != fileHeader().NumberOfSections)
+		return false;
+
+	m_sectionHeaders.assign(headers.begin(), headers.end());
+	return true;
+}
+
+bool PEFile::readExportDirectory(const MappedFile& image, DWORD rva)
+{
+	if (rva == 0)
+		return true;
+
+	ExportLayout layout;
+	if (!image.read(rva2raw(rva), m_IED) || !locateExports(layout))
+		return false;
+
+	m_exportName = readName(image, rva2raw(m_IED.Name));
+
+	auto names = image.span<DWORD>(layout.names, layout.nameCount);
+	auto ordinals = image.span<WORD>(layout.ordinals, layout.nameCount);
+	auto functions = image.span<DWORD>(layout.functions, layout.functionCount);
+	if (names.size() != layout.nameCount || ordinals.size() != layout.nameCount)
+		return false;
+	m_exportFunctions.assign(functions.begin(), functions.end());
+
+	m_ExportTable.reserve(names.size());
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		ExportElement en;
+		en.rva = names[i];
+		en.ordinal = ordinals[i];
+		en.funcAddr = en.ordinal < functions.size() ? functions[en.ordinal] : 0;
+
+		en.name = readName(image, rva2raw(en.rva));
+
+		m_ExportTable.push_back(en);
+	}
+
+	exportDir = true;
+	return true;
+}
+
+template <typename Traits, typename Source>
+bool PEFile::readImportDirectory(Source& source, DWORD rva, ImageModel<Traits>& model)
+{
+	if (rva == 0)
+		return true;
+
+	ULONGLONG descOffset = rva2raw(rva);
+	for (int i = 0; ; ++i)
+	{
+		IIDX iidx;
+		if (!readValue(source, descOffset + sizeof(IMAGE_IMPORT_DESCRIPTOR) * i, iidx.iid))
+			return false;
+
+		if (!iidx.iid.FirstThunk)
+			break;
+
+		iidx.Name = readName(source, rva2raw(iidx.iid.Name));
+		m_IIDs.push_back(iidx);
+
+		// without an INT the IAT holds the lookup entries on disk
+		bool hasINT = iidx.iid.OriginalFirstThunk != 0;
+		if (hasINT)
+			hasIAT = true;
+		readThunks<Traits>(source, hasINT ? iidx.iid.OriginalFirstThunk : iidx.iid.FirstThunk, iidx.iid.FirstThunk, 0,
+			iidx.Name, model.INT, hasINT ? &model.IAT : nullptr);
+	}
+
+	return true;
+}
+
+template <typename Traits, typename Source>
+bool PEFile::readDelayImportDirectory(Source& source, DWORD rva, ImageModel<Traits>& model)
+{
+	ULONGLONG descOffset = rva2raw(rva);
+	for (int i = 0; ; ++i)
+	{
+		DelayIIDX didx;
+		if (!readValue(source, descOffset + sizeof(IMAGE_DELAYLOAD_DESCRIPTOR) * i, didx.did))
+			return false;
+
+		if (!didx.did.DllNameRVA)
+			break;
+
+		// VA based descriptors also point at their hint/name entries by VA
+		ULONGLONG base = didx.did.Attributes.RvaBased ? 0 : model.ntHeaders.OptionalHeader.ImageBase;
+		didx.Name = readName(source, rva2raw((DWORD)(didx.did.DllNameRVA - base)));
+		m_delayIIDs.push_back(didx);
+
+		readThunks<Traits>(source, (DWORD)(didx.did.ImportNameTableRVA - base), (DWORD)(didx.did.ImportAddressTableRVA - base), base,
+			didx.Name, model.delayINT, &model.delayIAT);
+	}
+
+	return true;
+}
+
+template <typename Traits, typename Source>
+void PEFile::readThunks(Source& source, DWORD lookupRva, DWORD iatRva, ULONGLONG base, std::string_view module,
+	std::vector<INT_Element<Traits>>& names, std::vector<typename Traits::Thunk>* iat)
+{
+	typedef typename Traits::Thunk Thunk;
+
+	// the lookup table in one read and the IAT beside it in another, one entry each per thunk
+	std::vector<Thunk> lookup;
+	if (lookupRva)
+		readThunkArray(source, rva2raw(lookupRva), lookup);
+	if (iat)
+		readThunkArray(source, rva2raw(iatRva), lookup.size(), *iat);
+
+	names.reserve(names.size() + lookup.size() + 1);
+	for (Thunk thunk : lookup)
+	{
+		if (!thunk)
+			break;
+
+		INT_Element<Traits> element{};
+		element.addr = thunk;
+		if (!(thunk & Traits::ordinalFlag)) // Name
+		{
+			ULONGLONG hintOffset = rva2raw((DWORD)(thunk - base));
+			readValue(source, hintOffset, element.Hint);
+			element.Name = readName(source, hintOffset + sizeof(WORD));
+		}
+		names.push_back(element);
+	}
+
+	INT_Element<Traits> element{};
+	element.Name = module;
+	names.push_back(element);
+}
+
+template <typename Thunk>
+bool PEFile::readThunkArray(std::ifstream& file, ULONGLONG offset, std::vector<Thunk>& thunks)
+{
+	thunks.clear();
+	file.clear();
+	file.seekg(offset, std::ios::beg);
+
+	// a block per read, the stream carries on where the last block ended
+	while (true)
+	{
+		size_t done = thunks.size();
+		thunks.resize(done + thunkBlock);
+		file.read(reinterpret_cast<char*>(thunks.data() + done), sizeof(Thunk) * thunkBlock);
+		size_t count = (size_t)file.gcount() / sizeof(Thunk);
+
+		auto end = thunks.begin() + done + count;
+		auto terminator = std::find(thunks.begin() + done, end, (Thunk)0);
+		if (terminator != end)
+		{
+			thunks.erase(terminator + 1, thunks.end());
+			return true;
+		}
+		thunks.erase(end, thunks.end());
+		if (count < thunkBlock)
+			return false;
+	}
+}
+
+template <typename Thunk>
+bool PEFile::readThunkArray(const MappedFile& image, ULONGLONG offset, std::vector<Thunk>& thunks)
+{
+	thunks.clear();
+	if (offset >= image.size())
+		return false;
+
+	// find the terminator in place, then copy the table once
+	const BYTE* data = image.data() + offset;
+	size_t available = (size_t)((image.size() - offset) / sizeof(Thunk));
+	size_t count = 0;
+	bool terminated = false;
+	while (count < available && !terminated)
+	{
+		Thunk thunk;
+		memcpy(&thunk, data + count * sizeof(Thunk), sizeof(Thunk));
+		terminated = thunk == 0;
+		count++;
+	}
+
+	thunks.resize(count);
+	if (count)
+		memcpy(thunks.data(), data, count * sizeof(Thunk));
+	return terminated;
+}
+
+template <typename Thunk>
+void PEFile::readThunkArray(std::ifstream& file, ULONGLONG offset, size_t count, std::vector<Thunk>& thunks)
+{
+	size_t done = thunks.size();
+	thunks.resize(done + count);
+	if (!count)
+		return;
+
+	file.clear();
+	file.seekg(offset, std::ios::beg);
+	file.read(reinterpret_cast<char*>(thunks.data() + done), sizeof(Thunk) * count);
+}
+
+template <typename Thunk>
+void PEFile::readThunkArray(const MappedFile& image, ULONGLONG offset, size_t count, std::vector<Thunk>& thunks)
+{
+	size_t done = thunks.size();
+	thunks.resize(done + count);
+	if (offset >= image.size())
+		return;
+
+	size_t available = (std::min)(count, (size_t)((image.size() - offset) / sizeof(Thunk)));
+	if (available)
+		memcpy(thunks.data() + done, image.data() + offset, available * sizeof(Thunk));
+}
 
-	}
+template <typename T>
+bool PEFile::readValue(std::ifstream& file, ULONGLONG offset, T& value)
+{
+	file.clear();
+	file.seekg(offset, std::ios::beg);
+	return (bool)file.read(reinterpret_cast<char*>(&value), sizeof(T));
 }
 
-bool PEFile::readDosHeader(std::ifstream& file)
+template <typename T>
+bool PEFile::readArray(std::ifstream& file, ULONGLONG offset, std::vector<T>& values)
 {
-	file.seekg(0, std::ios::beg);
-	file.read(reinterpret_cast<char*>(&m_dosHeader), sizeof(IMAGE_DOS_HEADER));
+	if (values.empty())
+		return true;
+	file.clear();
+	file.seekg(offset, std::ios::beg);
+	return (bool)file.read(reinterpret_cast<char*>(values.data()), sizeof(T) * values.size());
+}
+
+std::string_view PEFile::readName(const MappedFile& image, ULONGLONG offset)
+{
+	// point straight into the mapping, the image stays mapped as long as the PEFile
+	size_t length = 0;
+	const char* str = image.cstr(offset, &length);
+	if (!str)
+		return std::string_view("", 0);
+	return std::string_view(str, length);
+}
+
+void PEFile::printDosHeader()
+{
+	m_out.header(8, 32, 32);
+	m_out.rule(70);
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_magic, "Magic number", "IMAGE_DOS_SIGNATURE");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_cblp, "Bytes on last page of file", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_cp, "Pages in file", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_crlc, "Relocations", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_cparhdr, "Size of header in paragraphs", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_minalloc, "Minimum extra paragraphs needed", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_maxalloc, "Maximum extra paragraphs needed", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_ss, "Initial (relative) SS", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_sp, "Initial SP", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_csum, "Checksum", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_ip, "Initial IP", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_cs, "Initial (relative) CS", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_lfarlc, "File address of relocation table", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_ovno, "Overlay number", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res[0], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res[1], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res[2], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res[3], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_oemid, "OEM identifier", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_oeminfo, "OEM information", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res2[0], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res2[1], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res2[2], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res2[3], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res2[4], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res2[5], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res2[6], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res2[7], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res2[8], "Reserved words", "\0");
+	m_out.row(x86_4byte_desc32, m_dosHeader.e_res2[9], "Reserved words", "\0");
+	m_out.row(x86_8byte_desc32, m_dosHeader.e_lfanew, "File address of new exe header", "\0");
+	m_out.newline();
+}
+
+void PEFile::printNtHeaders()
+{
+	m_out.header(8, 16, 24);
+	m_out.rule(54);
 	
-	return file.good();
+	std::visit([this](const auto& model) {
+		typedef typename std::decay_t<decltype(model)>::traits Traits;
+		m_out.row(x86_8byte_desc16, model.ntHeaders.Signature, "Signature", "IMAGE_NT_SIGNATURE");
+		m_out.row(x86_8str_desc16, "<struct>", "FileHeader", "IMAGE_FILE_HEADER");
+		m_out.row(x86_8str_desc16, "<struct>", "OptionalHeader", Traits::optionalHeaderName);
+	}, m_model);
+	m_out.newline();
 }
 
-bool PEFile::readDosStub(std::ifstream& file)
+void PEFile::printFileHeader()
 {
-	int size = m_dosHeader.e_lfanew - sizeof(IMAGE_DOS_HEADER);
-	m_dosStubByte = std::string(size, '\0');
+	time_t timer = static_cast<time_t>(fileHeader().TimeDateStamp);
+	struct tm* t = gmtime(&timer);
+	char buffer[80];
+	strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", t);
 
-	file.seekg(sizeof(IMAGE_DOS_HEADER), std::ios::beg);
-	file.read(&m_dosStubByte[0], size);
+	m_out.header(8, 24, 24);
+	m_out.rule(62);
+	m_out.row(x86_4byte_desc24, fileHeader().Machine, "Machine", m_machineStr.c_str());
+	m_out.row(x86_4byte_desc24, fileHeader().NumberOfSections, "Number Of Sections", "\0");
+	m_out.row(x86_8byte_desc24, fileHeader().TimeDateStamp, "Time Date Stamp", buffer);
+	m_out.newline();
+}
 
-	return file.good();
+void PEFile::printOptionalHeader()
+{
+	std::visit([this](const auto& model) { printOptionalHeader(model); }, m_model);
 }
 
-bool PEFile::readNtHeaders(std::ifstream& file)
+template <typename Traits>
+void PEFile::printOptionalHeader(const ImageModel<Traits>& model)
 {
-	file.seekg(m_dosHeader.e_lfanew, std::ios::beg);
-	file.read(reinterpret_cast<char*>(&m_ntHeaders), sizeof(IMAGE_NT_HEADERS));
-	
-	return file.good();
+	// fields are right aligned to the width of a pointer sized field
+	const RowFormat byte1 = { Traits::thunkDigits - 2, 2, 32, 32 };
+	const RowFormat byte2 = { Traits::thunkDigits - 4, 4, 32, 32 };
+	const RowFormat byte4 = { Traits::thunkDigits - 8, 8, 32, 32 };
+	const RowFormat pointer = { 0, Traits::thunkDigits, 32, 32 };
+	const int width = Traits::thunkDigits + 70;
+	const auto& header = model.ntHeaders.OptionalHeader;
+
+	m_out.header(Traits::thunkDigits, 32, 32);
+	m_out.rule(width);
+	m_out.row(byte2, header.Magic, "Magic", Traits::magicName);
+	m_out.row(byte1, header.MajorLinkerVersion, "Major Linker Version", "\0");
+	m_out.row(byte1, header.MinorLinkerVersion, "Minor Linker Version", "\0");
+	m_out.row(byte4, header.SizeOfCode, "Size of Code", "\0");
+	m_out.row(byte4, header.SizeOfInitializedData, "Size of Initialized Data", "\0");
+	m_out.row(byte4, header.SizeOfUninitializedData, "Size of Uninitialized Data", "\0");
+	m_out.row(byte4, header.AddressOfEntryPoint, "Address of EntryPoint", "\0");
+	m_out.row(byte4, header.BaseOfCode, "Base of Code", "\0");
+	if constexpr (Traits::hasBaseOfData)
+		m_out.row(byte4, header.BaseOfData, "Base of Data", "\0");
+	m_out.row(pointer, header.ImageBase, "Image Base", "\0");
+	m_out.row(byte4, header.SectionAlignment, "Section Alignment", "\0");
+	m_out.row(byte4, header.FileAlignment, "File Alignment", "\0");
+	m_out.row(byte2, header.MajorOperatingSystemVersion, "Major OS Version", "\0");
+	m_out.row(byte2, header.MinorOperatingSystemVersion, "Minor OS Version", "\0");
+	m_out.row(byte2, header.MajorImageVersion, "Major Image Version", "\0");
+	m_out.row(byte2, header.MinorImageVersion, "Minor Image Version", "\0");
+	m_out.row(byte2, header.MajorSubsystemVersion, "Major Subsystem Version", "\0");
+	m_out.row(byte2, header.MinorSubsystemVersion, "Minor Subsystem Version", "\0");
+	m_out.row(byte4, header.Win32VersionValue, "Win32 Version Value", "\0");
+	m_out.row(byte4, header.SizeOfImage, "Size of Image", "\0");
+	m_out.row(byte4, header.SizeOfHeaders, "Size of Headers", "\0");
+	m_out.row(byte4, header.CheckSum, "Checksum", "\0");
+	m_out.row(byte2, header.Subsystem, "Subsystem", m_subSystem.c_str());
+	m_out.row(byte2, header.DllCharacteristics, "DLL Characteristics", "\0");
+	m_out.row(pointer, header.SizeOfStackReserve, "Size of StackReserve", "\0");
+	m_out.row(pointer, header.SizeOfStackCommit, "Size of Stack Commit", "\0");
+	m_out.row(pointer, header.SizeOfHeapReserve, "Size of Heap Reserve", "\0");
+	m_out.row(pointer, header.SizeOfHeapCommit, "Size of Heap Commit", "\0");
+	m_out.row(byte4, header.LoaderFlags, "Loader Flags", "\0");
+	m_out.row(byte4, header.NumberOfRvaAndSizes, "Number of Data Directory", "\0");
+	for (int i = 0; i < header.NumberOfRvaAndSizes; ++i)
+	{
+		m_out.rule(width);
+		m_out.row(byte4, header.DataDirectory[i].VirtualAddress, "Virtual Address", GetDirectoryName(i).c_str());
+		m_out.row(byte4, header.DataDirectory[i].Size, "Size", "\0");
+	}
+	m_out.newline();
 }
 
-bool PEFile::readNtHeaderx86(std::ifstream& file)
+void PEFile::printSectionHeader(IMAGE_SECTION_HEADER& header, double entropy)
 {
-	file.seekg(m_dosHeader.e_lfanew, std::ios::beg);
-	file.read(reinterpret_cast<char*>(&m_ntHeaderx86), sizeof(IMAGE_NT_HEADERS32));
+	// description and value are right aligned in this table
+	auto field = [this](int indent, int digits, DWORD data, const char* desc) {
+		m_out.spaces(indent);
+		m_out.hex(data, digits);
+		m_out.str(" | ");
+		m_out.right(desc, 32);
+		m_out.str(" | ");
+		m_out.right("", 32);
+		m_out.newline();
+	};
+
+	m_out.header(12, 32, 32);
+	m_out.rule(82);
 	
-	return file.good();
+	m_out.put(' ');
+	for (int i = 0; i < 4; ++i)
+	{
+		m_out.hex(header.Name[i], 2);
+		m_out.put(' ');
+	}
+	m_out.str("| ");
+	m_out.right("Name", 32);
+	m_out.str(" | ");
+	m_out.right((const char*)header.Name, 32);
+	m_out.newline();
+	m_out.put(' ');
+	for (int i = 4; i < 8; ++i)
+	{
+		m_out.hex(header.Name[i], 2);
+		m_out.put(' ');
+	}
+	m_out.str("| ");
+	m_out.spaces(32);
+	m_out.str(" | ");
+	m_out.spaces(32);
+	m_out.newline();
+	
+	m_out.rule(82);
+	field(4, 8, header.Misc.VirtualSize, "Virtual Size");
+	field(4, 8, header.VirtualAddress, "Virtual Address");
+	field(4, 8, header.SizeOfRawData, "Size of Raw Data");
+	field(4, 8, header.PointerToRawData, "Pointer to Raw Data");
+	field(4, 8, header.PointerToRelocations, "Pointer to Relocations");
+	field(4, 8, header.PointerToLinenumbers, "Pointer to Line Numbers");
+	field(8, 4, header.NumberOfRelocations, "Number of Relocations");
+	field(8, 4, header.NumberOfLinenumbers, "Number of Linenumbers");
+	field(4, 8, header.Characteristics, "Characteristics");
+	printCharacteristics(header.Characteristics);
+
+	char text[16];
+	snprintf(text, sizeof(text), "%.4f", entropy);
+	m_out.rule(82);
+	m_out.spaces(4);
+	m_out.right(text, 8);
+	m_out.str(" | ");
+	m_out.right("Entropy", 32);
+	m_out.str(" | ");
+	m_out.right("bits per byte", 32);
+	m_out.newline();
+	m_out.newline();
 }
 
-bool PEFile::readSectionHeaders(std::ifstream& file)
+void PEFile::printEntropyWindows(int index)
+{
+	const IMAGE_SECTION_HEADER& header = m_sectionHeaders[index];
+	std::vector<BYTE> buffer;
+	ULONGLONG size = header.SizeOfRawData;
+	const BYTE* data = readRaw(header.PointerToRawData, size, buffer);
+	if (!data)
+	{
+		m_out.line("Section ͸ дµ Ͽϴ.\n");
+		return;
+	}
+
+	std::vector<float> windows;
+	Entropy::Windows(data, (size_t)size, entropyWindow, entropyStep, windows);
+
+	m_out.header(8, 16, 16);
+	m_out.rule(48);
+	for (size_t i = 0; i < windows.size(); ++i)
+	{
+		char text[16];
+		snprintf(text, sizeof(text), "%.4f", windows[i]);
+		m_out.row(x86_8byte_desc16, header.PointerToRawData + i * entropyStep, "Entropy", text);
+	}
+	m_out.newline();
+}
+
+void PEFile::printCharacteristics(DWORD characteristics)
+{
+	static const struct {
+		DWORD flag;
+		const char* name;
+	} flags[] = {
+		{ IMAGE_SCN_TYPE_NO_PAD, "IMAGE_SCN_TYPE_NO_PAD" },
+		{ IMAGE_SCN_CNT_CODE, "IMAGE_SCN_CNT_CODE" },
+		{ IMAGE_SCN_CNT_INITIALIZED_DATA, "IMAGE_SCN_CNT_INITIALIZED_DATA" },
+		{ IMAGE_SCN_CNT_UNINITIALIZED_DATA, "IMAGE_SCN_CNT_UNINITIALIZED_DATA" },
+		{ IMAGE_SCN_LNK_OTHER, "IMAGE_SCN_LNK_OTHER" },
+		{ IMAGE_SCN_LNK_INFO, "IMAGE_SCN_LNK_INFO" },
+		{ IMAGE_SCN_LNK_REMOVE, "IMAGE_SCN_LNK_REMOVE" },
+		{ IMAGE_SCN_LNK_COMDAT, "IMAGE_SCN_LNK_COMDAT" },
+		{ IMAGE_SCN_NO_DEFER_SPEC_EXC, "IMAGE_SCN_NO_DEFER_SPEC_EXC" },
+		{ IMAGE_SCN_GPREL, "IMAGE_SCN_GPREL" },
+		{ IMAGE_SCN_MEM_PURGEABLE, "IMAGE_SCN_MEM_PURGEABLE" },
+		{ IMAGE_SCN_MEM_LOCKED, "IMAGE_SCN_MEM_LOCKED" },
+		{ IMAGE_SCN_MEM_PRELOAD, "IMAGE_SCN_MEM_PRELOAD" },
+		{ IMAGE_SCN_ALIGN_1BYTES, "IMAGE_SCN_ALIGN_1BYTES" },
+		{ IMAGE_SCN_ALIGN_2BYTES, "IMAGE_SCN_ALIGN_2BYTES" },
+		{ IMAGE_SCN_ALIGN_4BYTES, "IMAGE_SCN_ALIGN_4BYTES" },
+		{ IMAGE_SCN_ALIGN_8BYTES, "IMAGE_SCN_ALIGN_8BYTES" },
+		{ IMAGE_SCN_ALIGN_16BYTES, "IMAGE_SCN_ALIGN_16BYTES" },
+		{ IMAGE_SCN_ALIGN_32BYTES, "IMAGE_SCN_ALIGN_32BYTES" },
+		{ IMAGE_SCN_ALIGN_64BYTES, "IMAGE_SCN_ALIGN_64BYTES" },
+		{ IMAGE_SCN_ALIGN_128BYTES, "IMAGE_SCN_ALIGN_128BYTES" },
+		{ IMAGE_SCN_ALIGN_256BYTES, "IMAGE_SCN_ALIGN_256BYTES" },
+		{ IMAGE_SCN_ALIGN_512BYTES, "IMAGE_SCN_ALIGN_512BYTES" },
+		{ IMAGE_SCN_ALIGN_1024BYTES, "IMAGE_SCN_ALIGN_1024BYTES" },
+		{ IMAGE_SCN_ALIGN_2048BYTES, "IMAGE_SCN_ALIGN_2048BYTES" },
+		{ IMAGE_SCN_ALIGN_4096BYTES, "IMAGE_SCN_ALIGN_4096BYTES" },
+		{ IMAGE_SCN_ALIGN_8192BYTES, "IMAGE_SCN_ALIGN_8192BYTES" },
+		{ IMAGE_SCN_ALIGN_MASK, "IMAGE_SCN_ALIGN_MASK" },
+		{ IMAGE_SCN_LNK_NRELOC_OVFL, "IMAGE_SCN_LNK_NRELOC_OVFL" },
+		{ IMAGE_SCN_MEM_DISCARDABLE, "IMAGE_SCN_MEM_DISCARDABLE" },
+		{ IMAGE_SCN_MEM_NOT_CACHED, "IMAGE_SCN_MEM_NOT_CACHED" },
+		{ IMAGE_SCN_MEM_NOT_PAGED, "IMAGE_SCN_MEM_NOT_PAGED" },
+		{ IMAGE_SCN_MEM_SHARED, "IMAGE_SCN_MEM_SHARED" },
+		{ IMAGE_SCN_MEM_EXECUTE, "IMAGE_SCN_MEM_EXECUTE" },
+		{ IMAGE_SCN_MEM_READ, "IMAGE_SCN_MEM_READ" },
+		{ IMAGE_SCN_MEM_WRITE, "IMAGE_SCN_MEM_WRITE" },
+	};
+
+	for (const auto& f : flags)
+	{
+		if (!(characteristics & f.flag))
+			continue;
+		m_out.spaces(12);
+		m_out.str(" |                         ");
+		m_out.hex(f.flag, 8);
+		m_out.str(" | ");
+		m_out.right(f.name, 32);
+		m_out.newline();
+	}
+}
+
+void PEFile::printImportDirectoyTable()
+{
+	m_out.header(8, 16, 24);
+	for (const auto& iid : m_IIDs)
+	{
+		m_out.rule(54);
+		m_out.row(x86_8byte_desc16, iid.iid.OriginalFirstThunk, "RVA to INT", "\0");
+		m_out.row(x86_8byte_desc16, iid.iid.TimeDateStamp, "Time Date Stamp", iid.iid.TimeDateStamp ? "Bound" : "Not Bound");
+		m_out.row(x86_8byte_desc16, iid.iid.ForwarderChain, "Forwarder Chain", "\0");
+		m_out.row(x86_8byte_desc16, iid.iid.Name, "Name", iid.Name);
+		m_out.row(x86_8byte_desc16, iid.iid.FirstThunk, "RVA to IAT", "\0");
+	}
+	m_out.newline();
+}
+
+void PEFile::printImportNameTable()
+{
+	std::visit([this](const auto& model) { printImportNameTable(model.INT); }, m_model);
+}
+
+template <typename Traits>
+void PEFile::printImportNameTable(const std::vector<INT_Element<Traits>>& table)
 {
-	for (int i = 0; i < m_ntHeaders.FileHeader.NumberOfSections; ++i)
+	const RowFormat format = { 0, Traits::thunkDigits, 16, 32 };
+	const int width = Traits::thunkDigits + 56;
+
+	m_out.header(Traits::thunkDigits, 16, 32);
+	m_out.rule(width);
+	for (const auto& element : table)
 	{
-		if (x86)
+		if (element.addr & Traits::ordinalFlag)
+		{
+			char ordinal[8];
+			OutputSink::formatHex(ordinal, element.addr & 0xFFFF, 4);
+			m_out.row(format, element.addr, "Ordinal", ordinal);
+		}
+		else if (element.addr == 0 && element.Hint == 0)
 		{
-			IMAGE_SECTION_HEADER header;
-			file.seekg(m_dosHeader.e_lfanew + sizeof(IMAGE_NT_HEADERS32) + sizeof(IMAGE_SECTION_HEADER) * i, std::ios::beg);
-			file.read(reinterpret_cast<char*>(&header), sizeof(IMAGE_SECTION_HEADER));
-			m_sectionHeaders.push_back(header);
+			m_out.row(format, element.addr, "End of Imports", element.Name);
+			m_out.rule(width);
 		}
 		else
 		{
-			IMAGE_SECTION_HEADER header;
-			file.seekg(m_dosHeader.e_lfanew + sizeof(IMAGE_NT_HEADERS64) + sizeof(IMAGE_SECTION_HEADER) * i, std::ios::beg);
-			file.read(reinterpret_cast<char*>(&header), sizeof(IMAGE_SECTION_HEADER));
-			m_sectionHeaders.push_back(header);
+			m_out.row(format, element.addr, "Hint/Name RVA", element.Hint, element.Name);
 		}
 	}
-	return file.good();
+	m_out.newline();
+}
+
+void PEFile::printImportAddressTable()
+{
+	std::visit([this](const auto& model) { printImportAddressTable(model); }, m_model);
 }
 
-bool PEFile::readDirectory(std::ifstream& file)
+template <typename Traits>
+void PEFile::printImportAddressTable(const ImageModel<Traits>& model)
 {
-	if (x86)
+	const RowFormat format = { 0, Traits::thunkDigits, 16, 32 };
+	const int width = Traits::thunkDigits + 56;
+
+	m_out.header(Traits::thunkDigits, 16, 32);
+	m_out.rule(width);
+	for (int i = 0; i < model.INT.size(); ++i)
 	{
-		for (int i = 0; i < m_ntHeaderx86.OptionalHeader.NumberOfRvaAndSizes; ++i)
+		const auto& element = model.INT[i];
+		if (element.addr & Traits::ordinalFlag)
 		{
-			switch (i)
-			{
-			case 0x0:
-				readExportDirectory(file, m_ntHeaderx86.OptionalHeader.DataDirectory[i].VirtualAddress);
-				break;
-			case 0x1:
-				readImportDirectory(file, m_ntHeaderx86.OptionalHeader.DataDirectory[i].VirtualAddress);
-				break;
-			case 0x2:
-				return "RESOURCE Directory";
-			case 0x3:
-				return "EXCEPTION Directory";
-			case 0x4:
-				return "SECURITY Directory";
-			case 0x5:
-				return "BASE RELOCATION Directory";
-			case 0x6:
-				return "DEBUG Directory";
-			case 0x7:
-				return "COPYRIGHT Directory";
-			case 0x8:
-				return "GLOBALPTR Directory";
-			case 0x9:
-				return "TLS Directory";
-			case 0xa:
-				return "LOAD CONFIG Directory";
-			case 0xb:
-				return "BOUND IMPORT Directory";
-			case 0xc:
-				return "IAT Directory";
-			case 0xd:
-				return "DELAY IMPORT Directory";
-			case 0xe:
-				return "COM DESCRIPTOR Directory";
-			case 0xf:
-				return "Reserved Directory";
-			}
+			char ordinal[8];
+			OutputSink::formatHex(ordinal, element.addr & 0xFFFF, 4);
+			m_out.row(format, model.IAT[i], "Ordinal", ordinal);
+		}
+		else if (element.addr == 0 && element.Hint == 0)
+		{
+			m_out.row(format, (ULONGLONG)0, "End of Imports", element.Name);
+			m_out.rule(width);
+		}
+		else
+		{
+			m_out.row(format, model.IAT[i], "Hint/Name RVA", element.Hint, element.Name);
 		}
 	}
-	else
+	m_out.newline();
+}
+
+void PEFile::printDelayImportDirectoryTable()
+{
+	m_out.header(8, 24, 24);
+	for (const auto& did : m_delayIIDs)
+	{
+		m_out.rule(62);
+		m_out.row(x86_8byte_desc24, did.did.Attributes.AllAttributes, "Attributes", did.did.Attributes.RvaBased ? "RVA Based" : "VA Based");
+		m_out.row(x86_8byte_desc24, did.did.DllNameRVA, "Name", did.Name);
+		m_out.row(x86_8byte_desc24, did.did.ModuleHandleRVA, "RVA to Module Handle", "\0");
+		m_out.row(x86_8byte_desc24, did.did.ImportAddressTableRVA, "RVA to IAT", "\0");
+		m_out.row(x86_8byte_desc24, did.did.ImportNameTableRVA, "RVA to INT", "\0");
+		m_out.row(x86_8byte_desc24, did.did.BoundImportAddressTableRVA, "RVA to Bound IAT", "\0");
+		m_out.row(x86_8byte_desc24, did.did.UnloadInformationTableRVA, "RVA to Unload IAT", "\0");
+		m_out.row(x86_8byte_desc24, did.did.TimeDateStamp, "Time Date Stamp", did.did.TimeDateStamp ? "Bound" : "Not Bound");
+	}
+	m_out.newline();
+}
+
+void PEFile::printDelayImportNameTable()
+{
+	std::visit([this](const auto& model) { printImportNameTable(model.delayINT); }, m_model);
+}
+
+void PEFile::printExportDirectory()
+{
+	time_t timer = static_cast<time_t>(m_IED.TimeDateStamp);
+	struct tm* t = gmtime(&timer);
+	char buffer[80];
+	strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", t);
+
+	m_out.header(8, 24, 24);
+	m_out.rule(64);
+	m_out.row(x86_8byte_desc24, m_IED.Characteristics, "Characteristics", "\0");
+	m_out.row(x86_8byte_desc24, m_IED.TimeDateStamp, "Time Date Stamp", buffer);
+	
+	char text[16];
+	OutputSink::formatHex(text, m_IED.MajorVersion, 4);
+	m_out.row(x86_8str_desc24, text, "Major Version", "\0");
+	OutputSink::formatHex(text, m_IED.MinorVersion, 4);
+	m_out.row(x86_8str_desc24, text, "Minor Version", "\0");
+
+	m_out.row(x86_8byte_desc24, m_IED.Name, "Name", m_exportName);
+	m_out.row(x86_8byte_desc24, m_IED.Base, "Base", "\0");
+	m_out.row(x86_8byte_desc24, m_IED.NumberOfFunctions, "Number of Functions", "\0");
+	m_out.row(x86_8byte_desc24, m_IED.NumberOfNames, "Number of Names", "\0");
+	m_out.row(x86_8byte_desc24, m_IED.AddressOfFunctions, "Address of Functions", "\0");
+	m_out.row(x86_8byte_desc24, m_IED.AddressOfNames, "Address of Names", "\0");
+	m_out.row(x86_8byte_desc24, m_IED.AddressOfNameOrdinals, "Address of Name Ordinals", "\0");
+	m_out.newline();
+}
+
+void PEFile::printExportAddressTable()
+{
+	m_out.header(8, 16, 32);
+	m_out.rule(64);
+	for (const auto& ee : m_ExportTable)
+		m_out.row(x86_8byte_desc16, ee.funcAddr, "Function RVA", ee.ordinal, ee.name);
+	m_out.newline();
+}
+
+void PEFile::printExportNameTable()
+{
+	m_out.header(8, 24, 32);
+	m_out.rule(64);
+	for (const auto& ee : m_ExportTable)
+		m_out.row(x86_8byte_desc24, ee.rva, "Function Name RVA", ee.ordinal, ee.name);
+	m_out.newline();
+}
+
+void PEFile::printExportOrdinalTable()
+{
+	m_out.header(8, 24, 32);
+	m_out.rule(64);
+	for (const auto& ee : m_ExportTable)
+		m_out.row(x86_8byte_desc24, ee.ordinal, "Function Ordinal", ee.ordinal, ee.name);
+	m_out.newline();
+}
+
+void PEFile::printExportSymbol(const ExportSymbol& symbol, DWORD rva)
+{
+	m_out.header(8, 16, 32);
+	m_out.rule(64);
+	m_out.row(x86_8byte_desc16, symbol.ordinal, "Ordinal", "\0");
+	m_out.row(x86_8byte_desc16, symbol.rva, "Function RVA", symbol.name ? symbol.name : "");
+	if (rva != symbol.rva)
+	{
+		char offset[20];
+		OutputSink::formatHex(offset, rva - symbol.rva, 1);
+		std::string text = symbol.name ? symbol.name : "";
+		text += '+';
+		text += offset;
+		m_out.row(x86_8byte_desc16, rva, "Address", text.c_str());
+	}
+	m_out.newline();
+}
+
+void PEFile::printResourceTypes()
+{
+	// only the type level is read, the count comes from each type's directory header
+	m_out.header(8, 24, 16);
+	m_out.rule(56);
+	DWORD first = m_resources.children(0);
+	for (DWORD i = first; i < first + m_resources.node(0).count; ++i)
+	{
+		const ResourceNode& node = m_resources.node(i);
+		const char* known = node.name & IMAGE_RESOURCE_NAME_IS_STRING ? nullptr : ResourceTree::TypeName(node.name);
+		std::string name = known ? known : m_resources.name(i);
+		m_out.row(x86_8byte_desc24, node.name & IMAGE_RESOURCE_NAME_IS_STRING ? 0 : node.name, name, std::to_string(node.count));
+	}
+	m_out.newline();
+}
+
+void PEFile::printResources(DWORD type)
+{
+	// name / language : RVA of the data, size and code page
+	m_out.header(8, 24, 24);
+	m_out.rule(64);
+	DWORD names = m_resources.children(type);
+	for (DWORD n = names; n < names + m_resources.node(type).count; ++n)
 	{
-		for (int i = 0; i < m_ntHeaders.OptionalHeader.NumberOfRvaAndSizes; ++i)
+		DWORD languages = m_resources.children(n);
+		for (DWORD l = languages; l < languages + m_resources.node(n).count; ++l)
 		{
-			switch (i)
-			{
-			case 0x0:
-				readExportDirectory(file, m_ntHeaders.OptionalHeader.DataDirectory[i].VirtualAddress);
-				break;
-			case 0x1:
-				readImportDirectory(file, m_ntHeaders.OptionalHeader.DataDirectory[i].VirtualAddress);
-				break;
-			case 0x2:
-				return "RESOURCE Directory";
-			case 0x3:
-				return "EXCEPTION Directory";
-			case 0x4:
-				return "SECURITY Directory";
-			case 0x5:
-				return "BASE RELOCATION Directory";
-			case 0x6:
-				return "DEBUG Directory";
-			case 0x7:
-				return "COPYRIGHT Directory";
-			case 0x8:
-				return "GLOBALPTR Directory";
-			case 0x9:
-				return "TLS Directory";
-			case 0xa:
-				return "LOAD CONFIG Directory";
-			case 0xb:
-				return "BOUND IMPORT Directory";
-			case 0xc:
-				return "IAT Directory";
-			case 0xd:
-				return "DELAY IMPORT Directory";
-			case 0xe:
-				return "COM DESCRIPTOR Directory";
-			case 0xf:
-				return "Reserved Directory";
-			}
+			IMAGE_RESOURCE_DATA_ENTRY entry;
+			if (!m_resources.dataEntry(l, entry))
+				continue;
+
+			char value[32];
+			snprintf(value, sizeof(value), "%08X CP %u", entry.Size, entry.CodePage);
+			std::string desc = m_resources.name(n) + " / " + m_resources.name(l);
+			m_out.row(x86_8byte_desc24, entry.OffsetToData, desc, value);
 		}
 	}
+	m_out.newline();
+}
 
-	return file.good();
+void PEFile::printVersionInfo()
+{
+	VersionInfo info;
+	if (!GetVersionInfo(info))
+	{
+		m_out.line("Version   ʽϴ.\n");
+		return;
+	}
+
+	char text[64];
+	if (info.hasFixed)
+	{
+		const VS_FIXEDFILEINFO& fixed = info.fixed;
+		snprintf(text, sizeof(text), "%u.%u.%u.%u", fixed.dwFileVersionMS >> 16, fixed.dwFileVersionMS & 0xFFFF, fixed.dwFileVersionLS >> 16, fixed.dwFileVersionLS & 0xFFFF);
+		m_out.left("FileVersion (fixed)", 24);
+		m_out.str(" : ");
+		m_out.line(text);
+		snprintf(text, sizeof(text), "%u.%u.%u.%u", fixed.dwProductVersionMS >> 16, fixed.dwProductVersionMS & 0xFFFF, fixed.dwProductVersionLS >> 16, fixed.dwProductVersionLS & 0xFFFF);
+		m_out.left("ProductVersion (fixed)", 24);
+		m_out.str(" : ");
+		m_out.line(text);
+		snprintf(text, sizeof(text), "%08X", fixed.dwFileFlags & fixed.dwFileFlagsMask);
+		m_out.left("FileFlags", 24);
+		m_out.str(" : ");
+		m_out.line(text);
+	}
+	for (const auto& string : info.strings)
+	{
+		m_out.left(string.first, 24);
+		m_out.str(" : ");
+		m_out.line(string.second);
+	}
+	for (DWORD translation : info.translations)
+	{
+		snprintf(text, sizeof(text), "%04X %04X", translation & 0xFFFF, translation >> 16);
+		m_out.left("Translation", 24);
+		m_out.str(" : ");
+		m_out.line(text);
+	}
+	m_out.newline();
 }
 
-bool PEFile::readExportDirectory(std::ifstream& file, DWORD rva)
+void PEFile::printManifest()
 {
-	if (rva != NULL)
+	std::string manifest;
+	if (!GetManifest(manifest))
 	{
-		file.seekg(rva2raw(rva), std::ios::beg);
-		file.read(reinterpret_cast<char*>(&m_IED), sizeof(IMAGE_EXPORT_DIRECTORY));
+		m_out.line("Manifest  ʽϴ.\n");
+		return;
+	}
+	m_out.str(manifest);
+	if (!manifest.empty() && manifest.back() != '\n')
+		m_out.newline();
+	m_out.newline();
+}
 
-		file.seekg(rva2raw(m_IED.Name), std::ios::beg);
-		file >> m_exportName;
-		
-		for (int i = 0; i < m_IED.NumberOfNames; ++i)
-		{
-			ExportElement en;
+void PEFile::printRelocationSummary()
+{
+	size_t counts[16] = {};
+	for (const Relocation& entry : m_relocations.entries())
+		counts[entry.type & 15]++;
+
+	m_out.header(8, 24, 16);
+	m_out.rule(56);
+	m_out.row(x86_8byte_desc24, m_relocations.blocks(), "Blocks", "\0");
+	m_out.row(x86_8byte_desc24, m_relocations.entries().size(), "Relocations", "\0");
+	for (WORD type = 0; type < 16; ++type)
+	{
+		if (counts[type])
+			m_out.row(x86_8byte_desc24, counts[type], RelocationTable::TypeName(type), "\0");
+	}
+	m_out.newline();
+}
 
-			file.seekg(rva2raw(m_IED.AddressOfNames) + sizeof(DWORD) * i, std::ios::beg);
-			file.read(reinterpret_cast<char*>(&en.rva), sizeof(DWORD));
+void PEFile::printRelocations(size_t first, size_t last)
+{
+	// the value column is what the fixup would patch, read from the file
+	const auto& entries = m_relocations.entries();
+	ULONGLONG size = fileSize();
+	m_out.header(8, 24, 16);
+	m_out.rule(56);
+	for (size_t i = first; i < last; ++i)
+	{
+		const Relocation& entry = entries[i];
+		int width = RelocationTable::Width(entry.type);
+		DWORD offset;
+		char value[20] = "";
+		if (width && m_image.isOpen() && m_sectionIndex.translate(entry.rva, offset) && offset + width <= size)
+		{
+			ULONGLONG target = 0;
+			memcpy(&target, m_image.data() + offset, width);
+			OutputSink::formatHex(value, target, width * 2);
+		}
+		m_out.row(x86_8byte_desc24, entry.rva, RelocationTable::TypeName(entry.type), value);
+	}
+	m_out.newline();
+}
 
-			file.seekg(rva2raw(en.rva), std::ios::beg);
-			file >> en.name;
+void PEFile::printFunctionSummary()
+{
+	ULONGLONG code = 0;
+	for (size_t i = 0; i < m_functions.size(); ++i)
+		code += m_functions.entry(i).EndAddress - m_functions.entry(i).BeginAddress;
 
-			file.seekg(rva2raw(m_IED.AddressOfNameOrdinals) + sizeof(WORD) * i, std::ios::beg);
-			file.read(reinterpret_cast<char*>(&en.ordinal), sizeof(WORD));
+	m_out.header(8, 24, 16);
+	m_out.rule(56);
+	m_out.row(x86_8byte_desc24, m_functions.size(), "Functions", "\0");
+	m_out.row(x86_8byte_desc24, code, "Covered Bytes", "\0");
+	m_out.row(x86_8byte_desc24, m_functions.entry(0).BeginAddress, "First Function", "\0");
+	m_out.row(x86_8byte_desc24, m_functions.entry(m_functions.size() - 1).EndAddress, "Last Function End", "\0");
+	m_out.newline();
+}
 
-			file.seekg(rva2raw(m_IED.AddressOfFunctions) + en.ordinal * sizeof(DWORD), std::ios::beg);
-			file.read(reinterpret_cast<char*>(&en.funcAddr), sizeof(DWORD));
+void PEFile::printFunctions(const std::vector<DWORD>& rvas)
+{
+	// every address is looked up in one batch call before anything is printed
+	std::vector<size_t> indices(rvas.size());
+	FindFunctions(rvas.data(), indices.data(), rvas.size());
 
-			m_ExportTable.push_back(en);
+	m_out.header(8, 32, 24);
+	m_out.rule(80);
+	for (size_t i = 0; i < rvas.size(); ++i)
+	{
+		if (indices[i] == FunctionTable::npos)
+		{
+			m_out.row(x86_8byte_desc32, rvas[i], "-", "\0");
+			continue;
 		}
 
-		exportDir = true;
+		const IMAGE_RUNTIME_FUNCTION_ENTRY& entry = m_functions.entry(indices[i]);
+		char range[40];
+		snprintf(range, sizeof(range), "%08X-%08X", entry.BeginAddress, entry.EndAddress);
+		m_out.row(x86_8byte_desc32, rvas[i], Symbolize(rvas[i], indices[i]), range);
 	}
-	
-	return file.good();
+
+	// a single address also gets its unwind info
+	UnwindInfo info;
+	if (rvas.size() == 1 && indices[0] != FunctionTable::npos && GetUnwindInfo(indices[0], info))
+	{
+		m_out.rule(80);
+		m_out.row(x86_8byte_desc32, m_functions.entry(indices[0]).UnwindInfoAddress, "Unwind Info", "\0");
+		m_out.row(x86_8byte_desc32, info.version, "Version", "\0");
+		m_out.row(x86_8byte_desc32, info.flags, "Flags", info.flags & 4 ? "CHAININFO" : info.flags & 3 ? "HANDLER" : "");
+		m_out.row(x86_8byte_desc32, info.prologSize, "Size of Prolog", "\0");
+		m_out.row(x86_8byte_desc32, info.codeCount, "Count of Codes", "\0");
+		m_out.row(x86_8byte_desc32, info.frameRegister, "Frame Register", "\0");
+		m_out.row(x86_8byte_desc32, info.frameOffset, "Frame Offset", "\0");
+		if (info.flags & 4)
+			m_out.row(x86_8byte_desc32, info.chainBegin, "Chained Function", "\0");
+		else if (info.flags & 3)
+			m_out.row(x86_8byte_desc32, info.handler, "Exception Handler", "\0");
+	}
+	m_out.newline();
 }
 
-bool PEFile::readImportDirectory(std::ifstream& file, DWORD rva)
+void PEFile::printDebugDirectory()
 {
-	int i = 0;
-	IIDX iidx;
-	while (true)
+	m_out.header(8, 24, 40);
+	std::vector<BYTE> buffer;
+	for (size_t i = 0; i < m_debug.entries().size(); ++i)
 	{
-		file.seekg(rva2raw(rva) + sizeof(IMAGE_IMPORT_DESCRIPTOR) * i++, std::ios::beg);
-		file.read(reinterpret_cast<char*>(&iidx.iid), sizeof(IMAGE_IMPORT_DESCRIPTOR));
-		
-		if (!iidx.iid.FirstThunk)
-			break;
+		const IMAGE_DEBUG_DIRECTORY& entry = m_debug.entries()[i];
+		char text[64];
+		snprintf(text, sizeof(text), "%u.%u", entry.MajorVersion, entry.MinorVersion);
 
-		file.seekg(rva2raw(iidx.iid.Name), std::ios::beg);
-		file >> iidx.Name;
-		m_IIDs.push_back(iidx);
+		m_out.rule(80);
+		m_out.row(x86_8byte_desc24, entry.Type, "Type", DebugDirectory::TypeName(entry.Type));
+		m_out.row(x86_8byte_desc24, entry.TimeDateStamp, "Time Date Stamp", "\0");
+		m_out.row(x86_8byte_desc24, entry.MajorVersion, "Version", text);
+		m_out.row(x86_8byte_desc24, entry.SizeOfData, "Size of Data", "\0");
+		m_out.row(x86_8byte_desc24, entry.AddressOfRawData, "Address of Raw Data", "\0");
+		m_out.row(x86_8byte_desc24, entry.PointerToRawData, "Pointer to Raw Data", "\0");
+
+		ULONGLONG size;
+		const BYTE* data = GetDebugData(i, size, buffer);
+		if (!data)
+			continue;
 
-		// read INT
-		int cnt = 0;
-		while (true)
+		CodeViewInfo codeView;
+		VcFeatures features;
+		DWORD signature;
+		std::vector<PogoEntry> pogo;
+		const BYTE* hash;
+		size_t length;
+		if (entry.Type == IMAGE_DEBUG_TYPE_CODEVIEW && DebugDirectory::ReadCodeView(data, (size_t)size, codeView))
 		{
-			if (x86)
+			bool rsds = codeView.format == DebugDirectory::formatRSDS;
+			m_out.row(x86_8byte_desc24, codeView.format, "Format", rsds ? "RSDS" : "NB10");
+			if (rsds)
 			{
-				if (iidx.iid.OriginalFirstThunk != NULL)
-				{
-					hasIAT = true;
+				DebugDirectory::FormatGuid(text, codeView.guid);
+				m_out.row(x86_8str_desc24, "", "GUID", text);
+			}
+			else
+				m_out.row(x86_8byte_desc24, codeView.guid.Data1, "Signature", "\0");
+			m_out.row(x86_8byte_desc24, codeView.age, "Age", "\0");
+			m_out.row(x86_8str_desc24, "", "PDB", codeView.path);
+			DebugDirectory::FormatKey(text, codeView);
+			m_out.row(x86_8str_desc24, "", "Symbol Key", text);
+		}
+		else if (entry.Type == IMAGE_DEBUG_TYPE_POGO && DebugDirectory::ReadPogo(data, (size_t)size, signature, pogo))
+		{
+			// the signature reads as text from the high byte down : LTCG, PGU, PGI
+			std::string name;
+			for (int shift = 24; shift >= 0; shift -= 8)
+			{
+				if ((signature >> shift) & 0xFF)
+					name += (char)((signature >> shift) & 0xFF);
+			}
+			m_out.row(x86_8byte_desc24, signature, "Signature", name);
+			m_out.row(x86_8byte_desc24, pogo.size(), "Entries", "DEBUG -p");
+		}
+		else if (entry.Type == IMAGE_DEBUG_TYPE_VC_FEATURE && DebugDirectory::ReadVcFeatures(data, (size_t)size, features))
+		{
+			m_out.row(x86_8byte_desc24, features.preVC11, "Pre-VC++ 11.00", "\0");
+			m_out.row(x86_8byte_desc24, features.cpp, "C/C++", "\0");
+			m_out.row(x86_8byte_desc24, features.gs, "/GS", "\0");
+			m_out.row(x86_8byte_desc24, features.sdl, "/sdl", "\0");
+			m_out.row(x86_8byte_desc24, features.guardN, "guardN", "\0");
+		}
+		else if (entry.Type == IMAGE_DEBUG_TYPE_REPRO && DebugDirectory::ReadRepro(data, (size_t)size, hash, length))
+		{
+			std::string hex(length * 2 + 1, '\0');
+			FileHasher::format(&hex[0], hash, length);
+			hex.pop_back();
+			m_out.row(x86_8byte_desc24, length, "Repro Hash", hex);
+		}
+	}
+	m_out.newline();
+}
 
-					INT_Elementx86 element;
-					file.seekg(rva2raw(iidx.iid.OriginalFirstThunk) + sizeof(DWORD) * cnt, std::ios::beg);
-					file.read(reinterpret_cast<char*>(&element.addr), sizeof(DWORD));
+void PEFile::printPogo()
+{
+	std::vector<BYTE> buffer;
+	DWORD signature;
+	std::vector<PogoEntry> pogo;
+	ULONGLONG size;
+	const BYTE* data = GetDebugData(m_debug.find(IMAGE_DEBUG_TYPE_POGO), size, buffer);
+	if (!data || !DebugDirectory::ReadPogo(data, (size_t)size, signature, pogo))
+	{
+		m_out.line("POGO ׸  ʽϴ.\n");
+		return;
+	}
 
-					// IAT
-					DWORD iatRva;
-					file.seekg(rva2raw(iidx.iid.FirstThunk) + sizeof(DWORD) * cnt, std::ios::beg);
-					file.read(reinterpret_cast<char*>(&iatRva), sizeof(DWORD));
-					m_IATx86.push_back(iatRva);
-					cnt++;
+	// which section a contribution landed in, by RVA
+	m_out.header(8, 24, 16);
+	m_out.rule(56);
+	for (const PogoEntry& entry : pogo)
+	{
+		char text[20];
+		OutputSink::formatHex(text, entry.size, 8);
+		m_out.row(x86_8byte_desc24, entry.rva, entry.name, text);
+	}
+	m_out.newline();
+}
 
-					if (!element.addr)
-						break;
+void PEFile::printCertificates()
+{
+	m_out.header(8, 16, 64);
+	for (const Certificate& certificate : GetCertificates().entries())
+	{
+		m_out.rule(96);
+		m_out.row(x86_8byte_desc16, certificate.offset, "Offset", "\0");
+		m_out.row(x86_8byte_desc16, certificate.length, "Length", "\0");
+		m_out.row(x86_8byte_desc16, certificate.revision, "Revision", CertificateTable::RevisionName(certificate.revision));
+		m_out.row(x86_8byte_desc16, certificate.type, "Type", CertificateTable::TypeName(certificate.type));
+	}
+	m_out.rule(96);
+	m_out.row(x86_8str_desc16, "", "Authenticode", m_certificates.entries().empty() ? "Not Signed" : "\0");
+	printDigests(m_authenticode);
+	m_out.newline();
+}
 
-					if (element.addr & 0x80000000) // Ordinal
-					{
-						m_INTx86.push_back(element);
-						continue;
-					}
+void PEFile::printHashes()
+{
+	m_out.header(8, 16, 64);
+	m_out.rule(96);
+	m_out.row(x86_8byte_desc16, 0, "File", "\0");
+	printDigests(GetFileDigest());
 
-					file.seekg(rva2raw(element.addr), std::ios::beg);
-					file.read(reinterpret_cast<char*>(&element.Hint), sizeof(WORD));
+	for (size_t i = 0; i < m_hashRanges.size(); ++i)
+	{
+		std::string_view name = "Overlay";
+		if (i < m_sectionHeaders.size())
+		{
+			const char* text = (const char*)m_sectionHeaders[i].Name;
+			name = std::string_view(text, strnlen(text, IMAGE_SIZEOF_SHORT_NAME));
+		}
 
-					file.seekg(rva2raw(element.addr) + sizeof(WORD), std::ios::beg);
-					file >> element.Name;
+		char size[20];
+		OutputSink::formatHex(size, m_hashRanges[i].size, 8);
+		m_out.row(x86_8byte_desc16, m_hashRanges[i].offset, name, size);
+		printDigests(GetRangeDigests()[i]);
+	}
+	m_out.newline();
+}
 
-					m_INTx86.push_back(element);
-				}
-				else
-				{
-					INT_Elementx86 element;
-					file.seekg(rva2raw(iidx.iid.FirstThunk) + sizeof(DWORD) * cnt, std::ios::beg);
-					file.read(reinterpret_cast<char*>(&element.addr), sizeof(DWORD));
-					cnt++;
+void PEFile::printStrings(bool ascii, bool wide)
+{
+	// description : section, RVA and A (ASCII) or U (UTF-16LE)
+	m_out.header(8, 24, 32);
+	m_out.rule(96);
+	for (const StringHit& hit : m_stringHits)
+	{
+		if (hit.wide ? !wide : !ascii)
+			continue;
+
+		char desc[32];
+		if (hit.section == StringHit::noSection)
+			snprintf(desc, sizeof(desc), "%-8s %-8s %c", "Overlay", "", hit.wide ? 'U' : 'A');
+		else
+		{
+			const char* name = (const char*)m_sectionHeaders[hit.section].Name;
+			snprintf(desc, sizeof(desc), "%-8.*s %08X %c", (int)strnlen(name, IMAGE_SIZEOF_SHORT_NAME), name, hit.rva, hit.wide ? 'U' : 'A');
+		}
+		m_out.row(x86_8byte_desc24, hit.offset, desc, GetStringText(hit));
+	}
+	m_out.newline();
+}
 
-					if (!element.addr)
-						break;
+void PEFile::printSignatures()
+{
+	if (m_signatureMatches.empty())
+	{
+		m_out.line("ġϴ ñ״ó ϴ.\n");
+		return;
+	}
 
-					if (element.addr & 0x80000000) // Ordinal
-					{
-						m_INTx86.push_back(element);
-						continue;
-					}
+	// description : section and RVA, value : the rule
+	m_out.header(8, 24, 32);
+	m_out.rule(96);
+	for (const SignatureMatch& match : m_signatureMatches)
+	{
+		char desc[32];
+		if (match.section == SignatureMatch::noSection)
+			snprintf(desc, sizeof(desc), "%-8s", "Overlay");
+		else
+		{
+			const char* name = (const char*)m_sectionHeaders[match.section].Name;
+			snprintf(desc, sizeof(desc), "%-8.*s %08X", (int)strnlen(name, IMAGE_SIZEOF_SHORT_NAME), name, match.rva);
+		}
+		m_out.row(x86_8byte_desc24, match.offset, desc, m_signatureSet->rule(match.rule).name);
+	}
+	m_out.newline();
+}
+
+void PEFile::printRichHeader()
+{
+	if (!m_rich.present())
+	{
+		m_out.line("Rich Header ϴ.\n");
+		return;
+	}
 
-					file.seekg(rva2raw(element.addr), std::ios::beg);
-					file.read(reinterpret_cast<char*>(&element.Hint), sizeof(WORD));
+	m_out.header(8, 24, 32);
+	m_out.rule(96);
+	m_out.row(x86_8byte_desc24, m_rich.offset(), "Offset", "DanS");
+	m_out.row(x86_8byte_desc24, m_rich.key(), "XOR Key", "\0");
+	m_out.row(x86_8byte_desc24, m_rich.checksum(), "Checksum", m_rich.valid() ? "Valid" : "Mismatch");
+	m_out.row(x86_8byte_desc24, m_rich.entries().size(), "Entries", "\0");
+	m_out.rule(96);
 
-					file.seekg(rva2raw(element.addr) + sizeof(WORD), std::ios::beg);
-					file >> element.Name;
+	// data : @comp.id, description : the tool, value : build, object count and toolset
+	for (const RichEntry& entry : m_rich.entries())
+	{
+		char name[32], value[64];
+		const char* product = RichHeader::ProductName(entry.product);
+		if (product)
+			snprintf(name, sizeof(name), "%s", product);
+		else
+			snprintf(name, sizeof(name), "Product %04X", entry.product);
+		snprintf(value, sizeof(value), "%5u  x%-6u %s", entry.build, entry.count, RichHeader::Toolset(entry.product, entry.build));
+		m_out.row(x86_8byte_desc24, (DWORD)entry.product << 16 | entry.build, name, value);
+	}
+	m_out.newline();
+}
 
-					m_INTx86.push_back(element);
-				}
-			}
-			else
-			{
-				if (iidx.iid.OriginalFirstThunk != NULL)
-				{
-					hasIAT = true;
+void PEFile::printOverlay(size_t dumpSize)
+{
+	if (m_overlay.size == 0 && m_overlay.certificateSize == 0)
+	{
+		m_out.line("Overlay ϴ.\n");
+		return;
+	}
 
-					INT_Element element;
-					file.seekg(rva2raw(iidx.iid.OriginalFirstThunk) + sizeof(ULONGLONG) * cnt, std::ios::beg);
-					file.read(reinterpret_cast<char*>(&element.addr), sizeof(ULONGLONG));
+	char text[32];
+	m_out.header(8, 24, 32);
+	m_out.rule(96);
+	m_out.row(x86_8byte_desc24, m_overlay.offset, "Offset", "\0");
+	m_out.row(x86_8byte_desc24, m_overlay.size, "Size", "\0");
+	if (m_overlay.certificateSize)
+	{
+		snprintf(text, sizeof(text), "Size %llX", (unsigned long long)m_overlay.certificateSize);
+		m_out.row(x86_8byte_desc24, m_overlay.certificateOffset, "Certificate Table", text);
+	}
+	if (m_overlay.size)
+	{
+		snprintf(text, sizeof(text), "%.4f", m_overlayScan.entropy());
+		m_out.row(x86_8str_desc24, "", "Entropy", text);
+	}
+	m_out.rule(96);
 
-					// IAT
-					ULONGLONG iatRva;
-					file.seekg(rva2raw(iidx.iid.FirstThunk) + sizeof(ULONGLONG) * cnt, std::ios::beg);
-					file.read(reinterpret_cast<char*>(&iatRva), sizeof(ULONGLONG));
-					m_IAT.push_back(iatRva);
-					cnt++;
+	// data : overlay offset of each archive signature, the first one is most likely the payload
+	OverlayScanner::Format first = m_overlayScan.first();
+	for (int f = 0; f < OverlayScanner::formatCount; ++f)
+	{
+		OverlayScanner::Format format = (OverlayScanner::Format)f;
+		if (m_overlayScan.find(format) != OverlayScanner::npos)
+			m_out.row(x86_8byte_desc24, m_overlayScan.find(format), OverlayScanner::FormatName(format), format == first ? "First" : "\0");
+	}
+	m_out.newline();
 
-					if (!element.addr)
-						break;
+	// at most one chunk, the dump is for the header of the payload
+	dumpSize = (size_t)(std::min)((ULONGLONG)(std::min)(dumpSize, OverlayScanner::chunkSize), m_overlay.size);
+	if (dumpSize)
+	{
+		std::vector<BYTE> buffer;
+		ULONGLONG size = dumpSize;
+		BYTE* data = (BYTE*)readRaw(m_overlay.offset, size, buffer);
+		if (data)
+			printByteAndRaw(data, (int)size);
+		else
+			m_out.line(" дµ Ͽϴ.\n");
+	}
+}
 
-					if (element.addr & 0x8000000000000000) // Ordinal
-					{
-						m_INT.push_back(element);
-						continue;
-					}
+void PEFile::printFingerprint()
+{
+	auto row = [this](const char* desc, bool present, const BYTE* digest) {
+		char text[Md5::digestSize * 2 + 1] = "-";
+		if (present)
+			FileHasher::format(text, digest, Md5::digestSize);
+		m_out.row(x86_8str_desc16, "", desc, text);
+	};
 
-					file.seekg(rva2raw(element.addr), std::ios::beg);
-					file.read(reinterpret_cast<char*>(&element.Hint), sizeof(WORD));
+	m_out.header(8, 16, 32);
+	m_out.rule(96);
+	row("Imphash", m_fingerprint.hasImports, m_fingerprint.imphash);
+	row("Rich", m_fingerprint.hasRich, m_fingerprint.rich);
+	row("Exports", m_fingerprint.hasExports, m_fingerprint.exports);
+	m_out.newline();
+}
 
-					file.seekg(rva2raw(element.addr) + sizeof(WORD), std::ios::beg);
-					file >> element.Name;
+void PEFile::printDigests(const DigestSet& digests)
+{
+	char text[Sha256::digestSize * 2 + 1];
+	FileHasher::format(text, digests.md5, sizeof(digests.md5));
+	m_out.row(x86_8str_desc16, "", "MD5", text);
+	FileHasher::format(text, digests.sha1, sizeof(digests.sha1));
+	m_out.row(x86_8str_desc16, "", "SHA-1", text);
+	FileHasher::format(text, digests.sha256, sizeof(digests.sha256));
+	m_out.row(x86_8str_desc16, "", "SHA-256", text);
+}
 
-					m_INT.push_back(element);
-				}
-				else
-				{
-					INT_Element element;
-					file.seekg(rva2raw(iidx.iid.FirstThunk) + sizeof(ULONGLONG) * cnt, std::ios::beg);
-					file.read(reinterpret_cast<char*>(&element.addr), sizeof(ULONGLONG));
-					cnt++;
+void PEFile::WriteJson(JsonWriter& json, bool headersOnly)
+{
+	json.beginObject();
+	json.field("path", m_filePath);
+	json.field("format", IsX86() ? "PE32" : "PE32+");
 
-					if (!element.addr)
-						break;
+	json.key("dos");
+	json.beginObject();
+	json.field("e_magic", m_dosHeader.e_magic);
+	json.field("e_cblp", m_dosHeader.e_cblp);
+	json.field("e_cp", m_dosHeader.e_cp);
+	json.field("e_crlc", m_dosHeader.e_crlc);
+	json.field("e_cparhdr", m_dosHeader.e_cparhdr);
+	json.field("e_minalloc", m_dosHeader.e_minalloc);
+	json.field("e_maxalloc", m_dosHeader.e_maxalloc);
+	json.field("e_ss", m_dosHeader.e_ss);
+	json.field("e_sp", m_dosHeader.e_sp);
+	json.field("e_csum", m_dosHeader.e_csum);
+	json.field("e_ip", m_dosHeader.e_ip);
+	json.field("e_cs", m_dosHeader.e_cs);
+	json.field("e_lfarlc", m_dosHeader.e_lfarlc);
+	json.field("e_ovno", m_dosHeader.e_ovno);
+	json.field("e_oemid", m_dosHeader.e_oemid);
+	json.field("e_oeminfo", m_dosHeader.e_oeminfo);
+	json.field("e_lfanew", (DWORD)m_dosHeader.e_lfanew);
+	json.endObject();
 
-					if (element.addr & 0x8000000000000000) // Ordinal
-					{
-						m_INT.push_back(element);
-						continue;
-					}
+	const IMAGE_FILE_HEADER& file = fileHeader();
+	json.key("nt");
+	json.beginObject();
+	json.field("Signature", std::visit([](const auto& model) { return model.ntHeaders.Signature; }, m_model));
+	json.key("FileHeader");
+	json.beginObject();
+	json.field("Machine", file.Machine);
+	json.field("MachineName", m_machineStr);
+	json.field("NumberOfSections", file.NumberOfSections);
+	json.field("TimeDateStamp", file.TimeDateStamp);
+	json.field("PointerToSymbolTable", file.PointerToSymbolTable);
+	json.field("NumberOfSymbols", file.NumberOfSymbols);
+	json.field("SizeOfOptionalHeader", file.SizeOfOptionalHeader);
+	json.field("Characteristics", file.Characteristics);
+	json.endObject();
+	json.key("OptionalHeader");
+	std::visit([this, &json](const auto& model) { writeOptionalHeader(json, model); }, m_model);
+	json.endObject();
 
-					file.seekg(rva2raw(element.addr), std::ios::beg);
-					file.read(reinterpret_cast<char*>(&element.Hint), sizeof(WORD));
+	json.key("sections");
+	json.beginArray();
+	for (const auto& header : m_sectionHeaders)
+	{
+		json.beginObject();
+		json.field("Name", std::string_view((const char*)header.Name, strnlen((const char*)header.Name, IMAGE_SIZEOF_SHORT_NAME)));
+		json.field("VirtualSize", header.Misc.VirtualSize);
+		json.field("VirtualAddress", header.VirtualAddress);
+		json.field("SizeOfRawData", header.SizeOfRawData);
+		json.field("PointerToRawData", header.PointerToRawData);
+		json.field("PointerToRelocations", header.PointerToRelocations);
+		json.field("PointerToLinenumbers", header.PointerToLinenumbers);
+		json.field("NumberOfRelocations", header.NumberOfRelocations);
+		json.field("NumberOfLinenumbers", header.NumberOfLinenumbers);
+		json.field("Characteristics", header.Characteristics);
+		json.endObject();
+	}
+	json.endArray();
 
-					file.seekg(rva2raw(element.addr) + sizeof(WORD), std::ios::beg);
-					file >> element.Name;
+	if (!headersOnly)
+	{
+		readDirectory(IMAGE_DIRECTORY_ENTRY_IMPORT);
+		readDirectory(IMAGE_DIRECTORY_ENTRY_EXPORT);
 
-					m_INT.push_back(element);
-				}
-			}
+		json.key("imports");
+		std::visit([this, &json](const auto& model) { writeImports(json, model); }, m_model);
+		if (!GetDelayImportDescriptors().empty())
+		{
+			json.key("delayImports");
+			std::visit([this, &json](const auto& model) { writeDelayImports(json, model); }, m_model);
 		}
-
-		if (x86)
+		if (exportDir)
 		{
-			INT_Elementx86 element;
-			element.addr = 0;
-			element.Hint = 0;
-			element.Name = iidx.Name;
-			m_INTx86.push_back(element);
+			json.key("exports");
+			writeExports(json);
 		}
-		else
+		if (!GetDebugDirectory().entries().empty())
 		{
-			INT_Element element;
-			element.addr = 0;
-			element.Hint = 0;
-			element.Name = iidx.Name;
-			m_INT.push_back(element);
+			json.key("debug");
+			writeDebug(json);
 		}
-	};
+		if (!GetCertificates().entries().empty())
+		{
+			json.key("certificates");
+			json.beginArray();
+			for (const Certificate& certificate : m_certificates.entries())
+			{
+				json.beginObject();
+				json.field("offset", certificate.offset);
+				json.field("length", certificate.length);
+				json.field("revision", certificate.revision);
+				json.field("type", certificate.type);
+				json.endObject();
+			}
+			json.endArray();
+		}
+	}
 
-	return file.good();
+	// only once something asked for them, hashing reads the whole file
+	if (m_hashed)
+	{
+		json.key("hashes");
+		json.beginObject();
+		json.key("file");
+		writeDigests(json, GetFileDigest());
+		json.key("sections");
+		json.beginArray();
+		for (size_t i = 0; i < m_sectionHeaders.size(); ++i)
+			writeDigests(json, GetRangeDigests()[i]);
+		json.endArray();
+		if (HasOverlay())
+		{
+			json.key("overlay");
+			writeDigests(json, GetRangeDigests().back());
+		}
+		json.endObject();
+	}
+	if (m_authenticodeHashed)
+	{
+		json.key("authenticode");
+		writeDigests(json, m_authenticode);
+	}
+	if (m_stringMinLength)
+	{
+		json.key("strings");
+		writeStrings(json);
+	}
+	if (m_signatureSet)
+	{
+		json.key("signatures");
+		writeSignatures(json);
+	}
+	if (m_richRead && m_rich.present())
+	{
+		json.key("rich");
+		writeRichHeader(json);
+	}
+	if (m_fingerprinted)
+	{
+		json.key("fingerprint");
+		writeFingerprint(json);
+	}
+	if (m_overlayScanned)
+	{
+		json.key("overlay");
+		writeOverlay(json);
+	}
+	json.endObject();
 }
 
-void PEFile::printDosHeader()
+void PEFile::writeRichHeader(JsonWriter& json)
 {
-	printf("%-8s | %-32s | %-32s\n", "Data", "Description", "Value");
-	std::cout << std::string(70, '-') << std::endl;
-	printf(x86_4byte_desc32, m_dosHeader.e_magic, "Magic number", "IMAGE_DOS_SIGNATURE");
-	printf(x86_4byte_desc32, m_dosHeader.e_cblp, "Bytes on last page of file", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_cp, "Pages in file", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_crlc, "Relocations", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_cparhdr, "Size of header in paragraphs", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_minalloc, "Minimum extra paragraphs needed", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_maxalloc, "Maximum extra paragraphs needed", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_ss, "Initial (relative) SS", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_sp, "Initial SP", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_csum, "Checksum", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_ip, "Initial IP", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_cs, "Initial (relative) CS", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_lfarlc, "File address of relocation table", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_ovno, "Overlay number", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res[0], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res[1], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res[2], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res[3], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_oemid, "OEM identifier", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_oeminfo, "OEM information", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res2[0], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res2[1], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res2[2], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res2[3], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res2[4], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res2[5], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res2[6], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res2[7], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res2[8], "Reserved words", "\0");
-	printf(x86_4byte_desc32, m_dosHeader.e_res2[9], "Reserved words", "\0");
-	printf(x86_8byte_desc32, m_dosHeader.e_lfanew, "File address of new exe header", "\0");
-	printf("\n");
+	json.beginObject();
+	json.field("offset", m_rich.offset());
+	json.field("key", m_rich.key());
+	json.field("checksum", m_rich.checksum());
+	json.key("valid");
+	json.boolean(m_rich.valid());
+	json.key("entries");
+	json.beginArray();
+	for (const RichEntry& entry : m_rich.entries())
+	{
+		json.beginObject();
+		json.field("product", entry.product);
+		json.field("build", entry.build);
+		json.field("count", entry.count);
+		if (const char* name = RichHeader::ProductName(entry.product))
+			json.field("name", name);
+		json.field("toolset", RichHeader::Toolset(entry.product, entry.build));
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
 }
 
-void PEFile::printNtHeaders()
+void PEFile::writeOverlay(JsonWriter& json)
 {
-	printf("%-8s | %-16s | %-24s\n", "Data", "Description", "Value");
-	std::cout << std::string(54, '-') << std::endl;
-	
-	if (x86)
+	json.beginObject();
+	json.field("offset", m_overlay.offset);
+	json.field("size", m_overlay.size);
+	if (m_overlay.size)
 	{
-		printf(x86_8byte_desc16, m_ntHeaderx86.Signature, "Signature", "IMAGE_NT_SIGNATURE");
-		printf(x86_8str_desc16, "<struct>", "FileHeader", "IMAGE_FILE_HEADER");
-		printf(x86_8str_desc16, "<struct>" , "OptionalHeader", "IMAGE_OPTIONAL_HEADER32");
+		json.key("entropy");
+		json.real(m_overlayScan.entropy());
 	}
-	else
+	if (m_overlay.certificateSize)
 	{
-		printf(x86_8byte_desc16, m_ntHeaders.Signature, "Signature", "IMAGE_NT_SIGNATURE");
-		printf(x86_8str_desc16, "<struct>", "FileHeader", "IMAGE_FILE_HEADER");
-		printf(x86_8str_desc16, "<struct>", "OptionalHeader", "IMAGE_OPTIONAL_HEADER64");
+		json.key("certificate");
+		json.beginObject();
+		json.field("offset", m_overlay.certificateOffset);
+		json.field("size", m_overlay.certificateSize);
+		json.endObject();
 	}
-	printf("\n");
+	json.key("formats");
+	json.beginArray();
+	for (int f = 0; f < OverlayScanner::formatCount; ++f)
+	{
+		OverlayScanner::Format format = (OverlayScanner::Format)f;
+		if (m_overlayScan.find(format) == OverlayScanner::npos)
+			continue;
+		json.beginObject();
+		json.field("name", OverlayScanner::FormatName(format));
+		json.field("offset", m_overlayScan.find(format));
+		json.endObject();
+	}
+	json.endArray();
+	json.endObject();
 }
 
-void PEFile::printFileHeader()
+void PEFile::writeFingerprint(JsonWriter& json)
 {
-	time_t timer = static_cast<time_t>(m_ntHeaders.FileHeader.TimeDateStamp);
-	struct tm* t = gmtime(&timer);
-	char buffer[80];
-	strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", t);
-
-	printf("%-8s | %-24s | %-24s\n", "Data", "Description", "Value");
-	std::cout << std::string(62, '-') << std::endl;
-	printf(x86_4byte_desc24, m_ntHeaders.FileHeader.Machine, "Machine", m_machineStr.c_str());
-	printf(x86_4byte_desc24, m_ntHeaders.FileHeader.NumberOfSections, "Number Of Sections", "\0");
-	printf(x86_8byte_desc24, m_ntHeaders.FileHeader.TimeDateStamp, "Time Date Stamp", buffer);
-	printf("\n");
-}
-
-void PEFile::printOptionalHeader()
-{	
-	if (x86) 
-	{
-		printf("%-8s | %-32s | %-32s\n", "Data", "Description", "Value");
-		std::cout << std::string(78, '-') << std::endl;
-		printf(x86_4byte_desc32_v32, m_ntHeaderx86.OptionalHeader.Magic, "Magic", "IMAGE_NT_OPTIONAL_HDR32_MAGIC");
-		printf(x86_2byte_desc32_v32, m_ntHeaderx86.OptionalHeader.MajorLinkerVersion, "Major Linker Version", "\0");
-		printf(x86_2byte_desc32_v32, m_ntHeaderx86.OptionalHeader.MinorLinkerVersion, "Minor Linker Version", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.SizeOfCode, "Size of Code", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.SizeOfInitializedData, "Size of Initialized Data", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.SizeOfUninitializedData, "Size of Uninitialized Data", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.AddressOfEntryPoint, "Address of EntryPoint", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.BaseOfCode, "Base of Code", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.BaseOfData, "Base of Data", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.ImageBase, "Image Base", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.SectionAlignment, "Section Alignment", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.FileAlignment, "File Alignment", "\0");
-		printf(x86_4byte_desc32_v32, m_ntHeaderx86.OptionalHeader.MajorOperatingSystemVersion, "Major OS Version", "\0");
-		printf(x86_4byte_desc32_v32, m_ntHeaderx86.OptionalHeader.MinorOperatingSystemVersion, "Minor OS Version", "\0");
-		printf(x86_4byte_desc32_v32, m_ntHeaderx86.OptionalHeader.MajorImageVersion, "Major Image Version", "\0");
-		printf(x86_4byte_desc32_v32, m_ntHeaderx86.OptionalHeader.MinorImageVersion, "Minor Image Version", "\0");
-		printf(x86_4byte_desc32_v32, m_ntHeaderx86.OptionalHeader.MajorSubsystemVersion, "Major Subsystem Version", "\0");
-		printf(x86_4byte_desc32_v32, m_ntHeaderx86.OptionalHeader.MinorSubsystemVersion, "Minor Subsystem Version", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.Win32VersionValue, "Win32 Version Value", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.SizeOfImage, "Size of Image", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.SizeOfHeaders, "Size of Headers", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.CheckSum, "Checksum", "\0");
-		printf(x86_4byte_desc32_v32, m_ntHeaderx86.OptionalHeader.Subsystem, "Subsystem", m_subSystem.c_str());
-		printf(x86_4byte_desc32_v32, m_ntHeaderx86.OptionalHeader.DllCharacteristics, "DLL Characteristics", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.SizeOfStackReserve, "Size of StackReserve", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.SizeOfStackCommit, "Size of Stack Commit", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.SizeOfHeapReserve, "Size of Heap Reserve", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.SizeOfHeapCommit, "Size of Heap Commit", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.LoaderFlags, "Loader Flags", "\0");
-		printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.NumberOfRvaAndSizes, "Number of Data Directory", "\0");
-		for (int i = 0; i < m_ntHeaderx86.OptionalHeader.NumberOfRvaAndSizes; ++i)
-		{
-			std::cout << std::string(78, '-') << std::endl;
-			printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.DataDirectory[i].VirtualAddress, "Virtual Address", GetDirectoryName(i).c_str());
-			printf(x86_8byte_desc32_v32, m_ntHeaderx86.OptionalHeader.DataDirectory[i].Size, "Size", "\0");
-		}
+	char text[Md5::digestSize * 2 + 1];
+	json.beginObject();
+	if (m_fingerprint.hasImports)
+	{
+		FileHasher::format(text, m_fingerprint.imphash, Md5::digestSize);
+		json.field("imphash", text);
 	}
-	else
+	if (m_fingerprint.hasRich)
 	{
-		printf("%-16s | %-32s | %-32s\n", "Data", "Description", "Value");
-		std::cout << std::string(86, '-') << std::endl;
-		printf(x64_4byte_desc32_v32, m_ntHeaders.OptionalHeader.Magic, "Magic", "IMAGE_NT_OPTIONAL_HDR64_MAGIC");
-		printf(x64_2byte_desc32_v32, m_ntHeaders.OptionalHeader.MajorLinkerVersion, "Major Linker Version", "\0");
-		printf(x64_2byte_desc32_v32, m_ntHeaders.OptionalHeader.MinorLinkerVersion, "Minor Linker Version", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.SizeOfCode, "Size of Code", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.SizeOfInitializedData, "Size of Initialized Data", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.SizeOfUninitializedData, "Size of Uninitialized Data", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.AddressOfEntryPoint, "Address of EntryPoint", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.BaseOfCode, "Base of Code", "\0");
-		printf(x64_16byte_desc32_v32, m_ntHeaders.OptionalHeader.ImageBase, "Image Base", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.SectionAlignment, "Section Alignment", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.FileAlignment, "File Alignment", "\0");
-		printf(x64_4byte_desc32_v32, m_ntHeaders.OptionalHeader.MajorOperatingSystemVersion, "Major OS Version", "\0");
-		printf(x64_4byte_desc32_v32, m_ntHeaders.OptionalHeader.MinorOperatingSystemVersion, "Minor OS Version", "\0");
-		printf(x64_4byte_desc32_v32, m_ntHeaders.OptionalHeader.MajorImageVersion, "Major Image Version", "\0");
-		printf(x64_4byte_desc32_v32, m_ntHeaders.OptionalHeader.MinorImageVersion, "Minor Image Version", "\0");
-		printf(x64_4byte_desc32_v32, m_ntHeaders.OptionalHeader.MajorSubsystemVersion, "Major Subsystem Version", "\0");
-		printf(x64_4byte_desc32_v32, m_ntHeaders.OptionalHeader.MinorSubsystemVersion, "Minor Subsystem Version", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.Win32VersionValue, "Win32 Version Value", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.SizeOfImage, "Size of Image", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.SizeOfHeaders, "Size of Headers", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.CheckSum, "Checksum", "\0");
-		printf(x64_4byte_desc32_v32, m_ntHeaders.OptionalHeader.Subsystem, "Subsystem", m_subSystem.c_str());
-		printf(x64_4byte_desc32_v32, m_ntHeaders.OptionalHeader.DllCharacteristics, "DLL Characteristics", "\0");
-		printf(x64_16byte_desc32_v32, m_ntHeaders.OptionalHeader.SizeOfStackReserve, "Size of StackReserve", "\0");
-		printf(x64_16byte_desc32_v32, m_ntHeaders.OptionalHeader.SizeOfStackCommit, "Size of Stack Commit", "\0");
-		printf(x64_16byte_desc32_v32, m_ntHeaders.OptionalHeader.SizeOfHeapReserve, "Size of Heap Reserve", "\0");
-		printf(x64_16byte_desc32_v32, m_ntHeaders.OptionalHeader.SizeOfHeapCommit, "Size of Heap Commit", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.LoaderFlags, "Loader Flags", "\0");
-		printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.NumberOfRvaAndSizes, "Number of Data Directory", "\0");
-		for (int i = 0; i < m_ntHeaders.OptionalHeader.NumberOfRvaAndSizes; ++i)
-		{
-			std::cout << std::string(86, '-') << std::endl;
-			printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.DataDirectory[i].VirtualAddress, "Virtual Address", GetDirectoryName(i).c_str());
-			printf(x64_8byte_desc32_v32, m_ntHeaders.OptionalHeader.DataDirectory[i].Size, "Size", "\0");
-		}
-	}
-	printf("\n");
-}
-
-void PEFile::printSectionHeader(IMAGE_SECTION_HEADER& header)
-{
-	printf("%-12s | %-32s | %-32s\n", "Data", "Description", "Value");
-	std::cout << std::string(82, '-') << std::endl;
-	
-	printf(" ");
-	for (int i = 0; i < 4; ++i)
-		printf("%02X ", header.Name[i]);
-	printf("| %32s | %32s\n", "Name", header.Name);
-	printf(" ");
-	for (int i = 4; i < 8; ++i)
-		printf("%02X ", header.Name[i]);
-	printf("| %32s | %32s\n", "", "");
-	
-	std::cout << std::string(82, '-') << std::endl;
-	printf("    %08X | %32s | %32s\n", header.Misc.VirtualSize, "Virtual Size", "\0");
-	printf("    %08X | %32s | %32s\n", header.VirtualAddress, "Virtual Address", "\0");
-	printf("    %08X | %32s | %32s\n", header.SizeOfRawData, "Size of Raw Data", "\0");
-	printf("    %08X | %32s | %32s\n", header.PointerToRawData, "Pointer to Raw Data", "\0");
-	printf("    %08X | %32s | %32s\n", header.PointerToRelocations, "Pointer to Relocations", "\0");
-	printf("    %08X | %32s | %32s\n", header.PointerToLinenumbers, "Pointer to Line Numbers", "\0");
-	printf("        %04X | %32s | %32s\n", header.NumberOfRelocations, "Number of Relocations", "\0");
-	printf("        %04X | %32s | %32s\n", header.NumberOfLinenumbers, "Number of Linenumbers", "\0");
-	printf("    %08X | %32s | %32s\n", header.Characteristics, "Characteristics", "\0");
-	printCharacteristics(header.Characteristics);
-	printf("\n");
-}
-
-void PEFile::printCharacteristics(DWORD characteristics)
-{
-	if (characteristics & IMAGE_SCN_TYPE_NO_PAD)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_TYPE_NO_PAD, "IMAGE_SCN_TYPE_NO_PAD");
-	if (characteristics & IMAGE_SCN_CNT_CODE)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_CNT_CODE, "IMAGE_SCN_CNT_CODE");
-	if (characteristics & IMAGE_SCN_CNT_INITIALIZED_DATA)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_CNT_INITIALIZED_DATA, "IMAGE_SCN_CNT_INITIALIZED_DATA");
-	if (characteristics & IMAGE_SCN_CNT_UNINITIALIZED_DATA)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_CNT_UNINITIALIZED_DATA, "IMAGE_SCN_CNT_UNINITIALIZED_DATA");
-	if (characteristics & IMAGE_SCN_LNK_OTHER)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_LNK_OTHER, "IMAGE_SCN_LNK_OTHER");
-	if (characteristics & IMAGE_SCN_LNK_INFO)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_LNK_INFO, "IMAGE_SCN_LNK_INFO");
-	if (characteristics & IMAGE_SCN_LNK_REMOVE)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_LNK_REMOVE, "IMAGE_SCN_LNK_REMOVE");
-	if (characteristics & IMAGE_SCN_LNK_COMDAT)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_LNK_COMDAT, "IMAGE_SCN_LNK_COMDAT");
-	if (characteristics & IMAGE_SCN_NO_DEFER_SPEC_EXC)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_NO_DEFER_SPEC_EXC, "IMAGE_SCN_NO_DEFER_SPEC_EXC");
-	if (characteristics & IMAGE_SCN_GPREL)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_GPREL, "IMAGE_SCN_GPREL");
-	if (characteristics & IMAGE_SCN_MEM_PURGEABLE)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_MEM_PURGEABLE, "IMAGE_SCN_MEM_PURGEABLE");
-	if (characteristics & IMAGE_SCN_MEM_LOCKED)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_MEM_LOCKED, "IMAGE_SCN_MEM_LOCKED");
-	if (characteristics & IMAGE_SCN_MEM_PRELOAD)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_MEM_PRELOAD, "IMAGE_SCN_MEM_PRELOAD");
-	if (characteristics & IMAGE_SCN_ALIGN_1BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_1BYTES, "IMAGE_SCN_ALIGN_1BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_2BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_2BYTES, "IMAGE_SCN_ALIGN_2BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_4BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_4BYTES, "IMAGE_SCN_ALIGN_4BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_8BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_8BYTES, "IMAGE_SCN_ALIGN_8BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_16BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_16BYTES, "IMAGE_SCN_ALIGN_16BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_32BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_32BYTES, "IMAGE_SCN_ALIGN_32BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_64BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_64BYTES, "IMAGE_SCN_ALIGN_64BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_128BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_128BYTES, "IMAGE_SCN_ALIGN_128BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_256BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_256BYTES, "IMAGE_SCN_ALIGN_256BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_512BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_512BYTES, "IMAGE_SCN_ALIGN_512BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_1024BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_1024BYTES, "IMAGE_SCN_ALIGN_1024BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_2048BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_2048BYTES, "IMAGE_SCN_ALIGN_2048BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_4096BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_4096BYTES, "IMAGE_SCN_ALIGN_4096BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_8192BYTES)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_8192BYTES, "IMAGE_SCN_ALIGN_8192BYTES");
-	if (characteristics & IMAGE_SCN_ALIGN_MASK)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_ALIGN_MASK, "IMAGE_SCN_ALIGN_MASK");
-	if (characteristics & IMAGE_SCN_LNK_NRELOC_OVFL)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_LNK_NRELOC_OVFL, "IMAGE_SCN_LNK_NRELOC_OVFL");
-	if (characteristics & IMAGE_SCN_MEM_DISCARDABLE)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_MEM_DISCARDABLE, "IMAGE_SCN_MEM_DISCARDABLE");
-	if (characteristics & IMAGE_SCN_MEM_NOT_CACHED)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_MEM_NOT_CACHED, "IMAGE_SCN_MEM_NOT_CACHED");
-	if (characteristics & IMAGE_SCN_MEM_NOT_PAGED)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_MEM_NOT_PAGED, "IMAGE_SCN_MEM_NOT_PAGED");
-	if (characteristics & IMAGE_SCN_MEM_SHARED)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_MEM_SHARED, "IMAGE_SCN_MEM_SHARED");
-	if (characteristics & IMAGE_SCN_MEM_EXECUTE)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_MEM_EXECUTE, "IMAGE_SCN_MEM_EXECUTE");
-	if (characteristics & IMAGE_SCN_MEM_READ)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_MEM_READ, "IMAGE_SCN_MEM_READ");
-	if (characteristics & IMAGE_SCN_MEM_WRITE)
-		printf("    %8s |                         %08X | %32s\n", "", IMAGE_SCN_MEM_WRITE, "IMAGE_SCN_MEM_WRITE");
-}
-
-void PEFile::printImportDirectoyTable()
-{
-	printf("%-8s | %-16s | %-24s\n", "Data", "Description", "Value");
-	for (auto iid : m_IIDs)
+		FileHasher::format(text, m_fingerprint.rich, Md5::digestSize);
+		json.field("rich", text);
+	}
+	if (m_fingerprint.hasExports)
 	{
-		std::cout << std::string(54, '-') << std::endl;
-		printf(x86_8byte_desc16, iid.iid.OriginalFirstThunk, "RVA to INT", "\0");
-		printf(x86_8byte_desc16, iid.iid.TimeDateStamp, "Time Date Stamp", iid.iid.TimeDateStamp ? "Bound" : "Not Bound");
-		printf(x86_8byte_desc16, iid.iid.ForwarderChain, "Forwarder Chain", "\0");
-		printf(x86_8byte_desc16, iid.iid.Name, "Name", iid.Name.c_str());
-		printf(x86_8byte_desc16, iid.iid.FirstThunk, "RVA to IAT", "\0");
+		FileHasher::format(text, m_fingerprint.exports, Md5::digestSize);
+		json.field("exports", text);
 	}
-	printf("\n");
+	json.endObject();
 }
 
-void PEFile::printImportNameTable()
+void PEFile::writeSignatures(JsonWriter& json)
 {
-	if (x86)
+	json.beginArray();
+	for (const SignatureMatch& match : m_signatureMatches)
 	{
-		printf("%-8s | %-16s | %-32s\n", "Data", "Description", "Value");
-		std::cout << std::string(64, '-') << std::endl;
-		for (auto element : m_INTx86)
+		json.beginObject();
+		json.field("rule", m_signatureSet->rule(match.rule).name);
+		json.field("offset", match.offset);
+		if (match.section != SignatureMatch::noSection)
 		{
-			if (element.addr & 0x80000000)
-			{
-				char ordinal[32];
-				sprintf(ordinal, "%04X", element.addr & 0xFFFF);
-				printf(x86_8str_desc16_v32, element.addr, "Ordinal", ordinal);
-			}
-			else if (element.addr == 0 && element.Hint == 0)
-			{
-				printf(x86_8str_desc16_v32, element.addr, "End of Imports", element.Name.c_str());
-				std::cout << std::string(64, '-') << std::endl;
-			}
-			else
-			{
-				char text[64];
-				sprintf(text, "%04X %s", element.Hint, element.Name.c_str());
-				printf(x86_8str_desc16_v32, element.addr, "Hint/Name RVA", text);
-			}
+			json.field("section", match.section);
+			json.field("rva", match.rva);
 		}
+		json.endObject();
 	}
-	else
+	json.endArray();
+}
+
+void PEFile::writeStrings(JsonWriter& json)
+{
+	json.beginArray();
+	for (const StringHit& hit : m_stringHits)
 	{
-		printf("%-16s | %-16s | %-32s\n", "Data", "Description", "Value");
-		std::cout << std::string(72, '-') << std::endl;
-		for (auto element : m_INT)
+		json.beginObject();
+		json.field("offset", hit.offset);
+		if (hit.section != StringHit::noSection)
 		{
-			if (element.addr & 0x8000000000000000)
-			{
-				char ordinal[32];
-				sprintf(ordinal, "%04X", element.addr & 0xFFFF);
-				printf(x64_16byte_desc16_v32, element.addr, "Ordinal", ordinal);
-			}
-			else if (element.addr == 0 && element.Hint == 0)
-			{
-				printf(x64_16byte_desc16_v32, element.addr, "End of Imports", element.Name.c_str());
-				std::cout << std::string(72, '-') << std::endl;
-			}
-			else
-			{
-				char text[64];
-				sprintf(text, "%04X %s", element.Hint, element.Name.c_str());
-				printf(x64_16byte_desc16_v32, element.addr, "Hint/Name RVA", text);
-			}
+			json.field("section", hit.section);
+			json.field("rva", hit.rva);
 		}
+		json.field("encoding", hit.wide ? "UTF-16LE" : "ASCII");
+		json.field("text", GetStringText(hit));
+		json.endObject();
 	}
-	printf("\n");
+	json.endArray();
 }
 
-void PEFile::printImportAddressTable()
+void PEFile::writeDebug(JsonWriter& json)
 {
-	if (x86)
+	json.beginObject();
+	json.key("entries");
+	json.beginArray();
+	for (const auto& entry : m_debug.entries())
 	{
-		printf("%-8s | %-16s | %-32s\n", "Data", "Description", "Value");
-		std::cout << std::string(64, '-') << std::endl;
-		for (int i = 0; i < m_INTx86.size(); ++i)
-		{
-			if (m_INTx86[i].addr & 0x80000000)
-			{
-				char ordinal[32];
-				sprintf(ordinal, "%04X", m_INTx86[i].addr & 0xFFFF);
-				printf(x86_8str_desc16_v32, m_IATx86[i], "Ordinal", ordinal);
-			}
-			else if (m_INTx86[i].addr == 0 && m_INTx86[i].Hint == 0)
-			{
-				printf(x86_8str_desc16_v32, 0, "End of Imports", m_INTx86[i].Name.c_str());
-				std::cout << std::string(64, '-') << std::endl;
-			}
-			else
-			{
-				char text[64];
-				sprintf(text, "%04X %s", m_INTx86[i].Hint, m_INTx86[i].Name.c_str());
-				printf(x86_8str_desc16_v32, m_IATx86[i], "Hint/Name RVA", text);
-			}
-		}
+		json.beginObject();
+		json.field("Type", entry.Type);
+		json.field("TypeName", DebugDirectory::TypeName(entry.Type));
+		json.field("TimeDateStamp", entry.TimeDateStamp);
+		json.field("MajorVersion", entry.MajorVersion);
+		json.field("MinorVersion", entry.MinorVersion);
+		json.field("SizeOfData", entry.SizeOfData);
+		json.field("AddressOfRawData", entry.AddressOfRawData);
+		json.field("PointerToRawData", entry.PointerToRawData);
+		json.endObject();
 	}
-	else
+	json.endArray();
+
+	CodeViewInfo codeView;
+	if (GetCodeView(codeView))
 	{
-		printf("%-16s | %-16s | %-32s\n", "Data", "Description", "Value");
-		std::cout << std::string(72, '-') << std::endl;
-		for (int i = 0; i < m_INT.size(); ++i)
-		{
-			if (m_INT[i].addr & 0x8000000000000000)
-			{
-				char ordinal[32];
-				sprintf(ordinal, "%04X", m_INT[i].addr & 0xFFFF);
-				printf(x64_16byte_desc16_v32, m_IAT[i], "Ordinal", ordinal);
-			}
-			else if (m_INT[i].addr == 0 && m_INT[i].Hint == 0)
-			{
-				printf(x64_16byte_desc16_v32, 0, "End of Imports", m_INT[i].Name.c_str());
-				std::cout << std::string(72, '-') << std::endl;
-			}
-			else
-			{
-				char text[64];
-				sprintf(text, "%04X %s", m_INT[i].Hint, m_INT[i].Name.c_str());
-				printf(x64_16byte_desc16_v32, m_IAT[i], "Hint/Name RVA", text);
-			}
-		}
+		char text[DebugDirectory::keySize];
+		json.key("codeView");
+		json.beginObject();
+		json.field("format", codeView.format == DebugDirectory::formatRSDS ? "RSDS" : "NB10");
+		DebugDirectory::FormatGuid(text, codeView.guid);
+		json.field("guid", text);
+		json.field("age", codeView.age);
+		json.field("path", codeView.path);
+		DebugDirectory::FormatKey(text, codeView);
+		json.field("key", text);
+		json.endObject();
 	}
-	printf("\n");
+	json.endObject();
 }
 
-void PEFile::printExportDirectory()
+void PEFile::writeDigests(JsonWriter& json, const DigestSet& digests)
 {
-	time_t timer = static_cast<time_t>(m_IED.TimeDateStamp);
-	struct tm* t = gmtime(&timer);
-	char buffer[80];
-	strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", t);
-
-	printf("%-8s | %-24s | %-24s\n", "Data", "Description", "Value");
-	std::cout << std::string(64, '-') << std::endl;
-	printf(x86_8byte_desc24, m_IED.Characteristics, "Characteristics", "\0");
-	printf(x86_8byte_desc24, m_IED.TimeDateStamp, "Time Date Stamp", buffer);
-	
-	char text[16];
-	sprintf(text, "%04X", m_IED.MajorVersion);
-	printf(x86_8str_desc24, text, "Major Version", "\0");
-	sprintf(text, "%04X", m_IED.MinorVersion);
-	printf(x86_8str_desc24, text, "Minor Version", "\0");
-
-	printf(x86_8byte_desc24, m_IED.Name, "Name", m_exportName.c_str());
-	printf(x86_8byte_desc24, m_IED.Base, "Base", "\0");
-	printf(x86_8byte_desc24, m_IED.NumberOfFunctions, "Number of Functions", "\0");
-	printf(x86_8byte_desc24, m_IED.NumberOfNames, "Number of Names", "\0");
-	printf(x86_8byte_desc24, m_IED.AddressOfFunctions, "Address of Functions", "\0");
-	printf(x86_8byte_desc24, m_IED.AddressOfNames, "Address of Names", "\0");
-	printf(x86_8byte_desc24, m_IED.AddressOfNameOrdinals, "Address of Name Ordinals", "\0");
-	printf("\n");
+	char text[Sha256::digestSize * 2 + 1];
+	json.beginObject();
+	FileHasher::format(text, digests.md5, sizeof(digests.md5));
+	json.field("md5", text);
+	FileHasher::format(text, digests.sha1, sizeof(digests.sha1));
+	json.field("sha1", text);
+	FileHasher::format(text, digests.sha256, sizeof(digests.sha256));
+	json.field("sha256", text);
+	json.endObject();
 }
 
-void PEFile::printExportAddressTable()
+template <typename Traits>
+void PEFile::writeOptionalHeader(JsonWriter& json, const ImageModel<Traits>& model)
 {
-	char text[64];
-	printf("%-8s | %-16s | %-32s\n", "Data", "Description", "Value");
-	std::cout << std::string(64, '-') << std::endl;
-	for (auto ee : m_ExportTable)
+	const auto& header = model.ntHeaders.OptionalHeader;
+
+	json.beginObject();
+	json.field("Magic", header.Magic);
+	json.field("MajorLinkerVersion", header.MajorLinkerVersion);
+	json.field("MinorLinkerVersion", header.MinorLinkerVersion);
+	json.field("SizeOfCode", header.SizeOfCode);
+	json.field("SizeOfInitializedData", header.SizeOfInitializedData);
+	json.field("SizeOfUninitializedData", header.SizeOfUninitializedData);
+	json.field("AddressOfEntryPoint", header.AddressOfEntryPoint);
+	json.field("BaseOfCode", header.BaseOfCode);
+	if constexpr (Traits::hasBaseOfData)
+		json.field("BaseOfData", header.BaseOfData);
+	json.field("ImageBase", header.ImageBase);
+	json.field("SectionAlignment", header.SectionAlignment);
+	json.field("FileAlignment", header.FileAlignment);
+	json.field("MajorOperatingSystemVersion", header.MajorOperatingSystemVersion);
+	json.field("MinorOperatingSystemVersion", header.MinorOperatingSystemVersion);
+	json.field("MajorImageVersion", header.MajorImageVersion);
+	json.field("MinorImageVersion", header.MinorImageVersion);
+	json.field("MajorSubsystemVersion", header.MajorSubsystemVersion);
+	json.field("MinorSubsystemVersion", header.MinorSubsystemVersion);
+	json.field("Win32VersionValue", header.Win32VersionValue);
+	json.field("SizeOfImage", header.SizeOfImage);
+	json.field("SizeOfHeaders", header.SizeOfHeaders);
+	json.field("CheckSum", header.CheckSum);
+	json.field("Subsystem", header.Subsystem);
+	json.field("SubsystemName", m_subSystem);
+	json.field("DllCharacteristics", header.DllCharacteristics);
+	json.field("SizeOfStackReserve", header.SizeOfStackReserve);
+	json.field("SizeOfStackCommit", header.SizeOfStackCommit);
+	json.field("SizeOfHeapReserve", header.SizeOfHeapReserve);
+	json.field("SizeOfHeapCommit", header.SizeOfHeapCommit);
+	json.field("LoaderFlags", header.LoaderFlags);
+	json.field("NumberOfRvaAndSizes", header.NumberOfRvaAndSizes);
+
+	json.key("DataDirectory");
+	json.beginArray();
+	for (DWORD i = 0; i < GetDirectoryCount(); ++i)
 	{
-		sprintf(text, "%04X %s", ee.ordinal, ee.name.c_str());
-		printf(x86_8byte_desc16, ee.funcAddr, "Function RVA", text);
+		json.beginObject();
+		json.field("name", GetDirectoryName(i));
+		json.field("VirtualAddress", header.DataDirectory[i].VirtualAddress);
+		json.field("Size", header.DataDirectory[i].Size);
+		json.endObject();
 	}
-	printf("\n");
+	json.endArray();
+	json.endObject();
 }
 
-void PEFile::printExportNameTable()
+template <typename Traits>
+void PEFile::writeImports(JsonWriter& json, const ImageModel<Traits>& model)
 {
-	char text[64];
-	printf("%-8s | %-24s | %-32s\n", "Data", "Description", "Value");
-	std::cout << std::string(64, '-') << std::endl;
-	for (auto ee : m_ExportTable)
+	// the INT is flat, every descriptor's thunks end with one end of imports entry
+	json.beginArray();
+	size_t i = 0;
+	for (const auto& iid : m_IIDs)
 	{
-		sprintf(text, "%04X %s", ee.ordinal, ee.name.c_str());
-		printf(x86_8byte_desc24, ee.rva, "Function Name RVA", text);
+		json.beginObject();
+		json.field("name", iid.Name);
+		json.field("OriginalFirstThunk", iid.iid.OriginalFirstThunk);
+		json.field("TimeDateStamp", iid.iid.TimeDateStamp);
+		json.field("ForwarderChain", iid.iid.ForwarderChain);
+		json.field("Name", iid.iid.Name);
+		json.field("FirstThunk", iid.iid.FirstThunk);
+
+		json.key("functions");
+		writeThunks(json, model.INT, model.IAT, i);
+		json.endObject();
 	}
-	printf("\n");
+	json.endArray();
 }
 
-void PEFile::printExportOrdinalTable()
+template <typename Traits>
+void PEFile::writeDelayImports(JsonWriter& json, const ImageModel<Traits>& model)
 {
-	char text[64];
-	printf("%-8s | %-24s | %-32s\n", "Data", "Description", "Value");
-	std::cout << std::string(64, '-') << std::endl;
-	for (auto ee : m_ExportTable)
+	json.beginArray();
+	size_t i = 0;
+	for (const auto& did : m_delayIIDs)
 	{
-		sprintf(text, "%04X %s", ee.ordinal, ee.name.c_str());
-		printf(x86_8byte_desc24, ee.ordinal, "Function Ordinal", text);
+		json.beginObject();
+		json.field("name", did.Name);
+		json.field("Attributes", did.did.Attributes.AllAttributes);
+		json.field("DllNameRVA", did.did.DllNameRVA);
+		json.field("ModuleHandleRVA", did.did.ModuleHandleRVA);
+		json.field("ImportAddressTableRVA", did.did.ImportAddressTableRVA);
+		json.field("ImportNameTableRVA", did.did.ImportNameTableRVA);
+		json.field("BoundImportAddressTableRVA", did.did.BoundImportAddressTableRVA);
+		json.field("UnloadInformationTableRVA", did.did.UnloadInformationTableRVA);
+		json.field("TimeDateStamp", did.did.TimeDateStamp);
+
+		json.key("functions");
+		writeThunks(json, model.delayINT, model.delayIAT, i);
+		json.endObject();
 	}
-	printf("\n");
+	json.endArray();
 }
 
-void PEFile::printByte(void* data, int size, int first_offset, int interval, int size_of_element)
+template <typename Traits>
+void PEFile::writeThunks(JsonWriter& json, const std::vector<INT_Element<Traits>>& names, const std::vector<typename Traits::Thunk>& iat, size_t& index)
 {
-	for (int i = 1; i < size * size_of_element + 1; ++i)
+	// one descriptor's entries, index is left past its end of imports entry
+	json.beginArray();
+	for (; index < names.size(); ++index)
 	{
-		int index = first_offset + interval * ((i - 1) / size_of_element) + ((i - 1) % size_of_element);
-		unsigned char c = ((char*)data)[index];
-
-		std::cout << std::uppercase << std::hex << std::setw(2) << std::setfill('0') << (int)c << ' ';
+		const auto& element = names[index];
+		if (element.addr == 0 && element.Hint == 0)
+			break;
 
-		if (i % 8 == 0)
-			std::cout << ' ';
-		if (i % 16 == 0)
+		json.beginObject();
+		json.field("thunk", element.addr);
+		if (index < iat.size())
+			json.field("iat", iat[index]);
+		if (element.addr & Traits::ordinalFlag)
+			json.field("ordinal", element.addr & 0xFFFF);
+		else
 		{
-			if (i != size * size_of_element)
-				std::cout << std::endl;
+			json.field("hint", element.Hint);
+			json.field("name", element.Name);
 		}
+		json.endObject();
 	}
-
-	printf("\n\n");
+	++index;
+	json.endArray();
 }
 
-void PEFile::printRaw(void* data, int size, int first_offset, int interval, int size_of_element)
+void PEFile::writeExports(JsonWriter& json)
 {
-	for (int i = 1; i < size * size_of_element + 1; ++i)
-	{
-		int index = first_offset + interval * ((i - 1) / size_of_element) + ((i - 1) % size_of_element);
-		char c = ((char*)data)[index];
+	json.beginObject();
+	json.field("name", m_exportName);
+	json.field("Characteristics", m_IED.Characteristics);
+	json.field("TimeDateStamp", m_IED.TimeDateStamp);
+	json.field("MajorVersion", m_IED.MajorVersion);
+	json.field("MinorVersion", m_IED.MinorVersion);
+	json.field("Name", m_IED.Name);
+	json.field("Base", m_IED.Base);
+	json.field("NumberOfFunctions", m_IED.NumberOfFunctions);
+	json.field("NumberOfNames", m_IED.NumberOfNames);
+	json.field("AddressOfFunctions", m_IED.AddressOfFunctions);
+	json.field("AddressOfNames", m_IED.AddressOfNames);
+	json.field("AddressOfNameOrdinals", m_IED.AddressOfNameOrdinals);
 
-		if (0x21 > c || 0x7f < c)
-			std::cout << '.';
-		else
-			std::cout << c;
+	json.key("functions");
+	json.beginArray();
+	for (DWORD rva : m_exportFunctions)
+		json.value(rva);
+	json.endArray();
 
-		if (i % 16 == 0)
-		{
-			if (i != size * size_of_element)
-				std::cout << std::endl;
-		}
+	json.key("names");
+	json.beginArray();
+	for (const auto& ee : m_ExportTable)
+	{
+		json.beginObject();
+		json.field("ordinal", m_IED.Base + ee.ordinal);
+		json.field("nameRva", ee.rva);
+		json.field("functionRva", ee.funcAddr);
+		json.field("name", ee.name);
+		json.endObject();
 	}
-	printf("\n\n");
+	json.endArray();
+	json.endObject();
 }
 
-void PEFile::printByteAndRaw(void* data, int size, int first_offset, int interval, int size_of_element)
+void PEFile::printByte(void* data, int size, int first_offset, int interval, int size_of_element)
 {
-	std::string raw;
-	for (int i = 1; i < size * size_of_element + 1; ++i)
-	{
-		int index = first_offset + interval * ((i - 1) / size_of_element) + ((i - 1) % size_of_element);
-		unsigned char c = ((char*)data)[index];
-
-		if (0x21 > (char)c || 0x7f < (char)c)
-			raw.append(1, '.');
-		else
-			raw.append(1, (char)c);
-
-		std::cout << std::uppercase << std::hex << std::setw(2) << std::setfill('0') << (int)c << ' ';
+	// the stream printers used to leave std::cout in uppercase hex mode
+	if (size > 0)
+		std::cout << std::uppercase << std::hex;
+	m_hexDump.dump(m_out, DumpMode::Byte, data, size, first_offset, interval, size_of_element);
+}
 
-		if (i % 8 == 0)
-			std::cout << ' ';
-		if (i % 16 == 0)
-		{
-			std::cout << raw;
-			raw.clear();
+void PEFile::printRaw(void* data, int size, int first_offset, int interval, int size_of_element)
+{
+	m_hexDump.dump(m_out, DumpMode::Raw, data, size, first_offset, interval, size_of_element);
+}
 
-			if (i != size * size_of_element)
-				std::cout << std::endl;
-		}
-		else if (i == size * size_of_element)
-		{
-			std::cout << std::string(i % 16 < 8 ? (16 - i % 16) * 3 + 2 : (16 - i % 16) * 3 + 1, ' ') << raw;
-		}
-	}
-	printf("\n\n");
+void PEFile::printByteAndRaw(void* data, int size, int first_offset, int interval, int size_of_element)
+{
+	if (size > 0)
+		std::cout << std::uppercase << std::hex;
+	m_hexDump.dump(m_out, DumpMode::ByteAndRaw, data, size, first_offset, interval, size_of_element);
 }
 
 DWORD PEFile::rva2raw(DWORD rva)
 {
-	int idx = -1;
-	for (int i = 0; i < m_sectionHeaders.size(); ++i)
-	{
-		if (m_sectionHeaders[i].VirtualAddress > rva)
-			break;
-		idx = i;
-	}
-	if (idx == -1)
-		return rva;
+	DWORD raw;
+	m_sectionIndex.translate(rva, raw);
+	return raw;
+}
+
+void PEFile::selectModel(WORD magic)
+{
+	if (magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC)
+		m_model.emplace<ImageModel<PE32Traits>>();
 	else
-		return rva - m_sectionHeaders[idx].VirtualAddress + m_sectionHeaders[idx].PointerToRawData;
+		m_model.emplace<ImageModel<PE64Traits>>();
+}
+
+const IMAGE_FILE_HEADER& PEFile::fileHeader() const
+{
+	return std::visit([](const auto& model) -> const IMAGE_FILE_HEADER& { return model.ntHeaders.FileHeader; }, m_model);
 }
 
 void PEFile::printHelp(const std::string& cmd)
@@ -1442,15 +3947,29 @@ void PEFile::printHelp(const std::string& cmd)
 	{
 		std::cout << "DOS : DOS    ǥմϴ." << std::endl;
 		std::cout << "STUB : DOS STUB α׷  ǥմϴ." << std::endl;
+		std::cout << "RICH : Rich Header XOR Ű, üũ,    ǥմϴ." << std::endl;
 		std::cout << "NT : NT    ǥմϴ." << std::endl;
 		std::cout << "SH : Section    ǥմϴ." << std::endl;
 		std::cout << "IDT : Import Directory Table   ǥմϴ." << std::endl;
 		std::cout << "INT : Import Name Table   ǥմϴ." << std::endl;
 		std::cout << "IAT : Import Address Table   ǥմϴ." << std::endl;
+		std::cout << "DIDT : Delay Import Directory Table   ǥմϴ." << std::endl;
+		std::cout << "DINT : Delay Import Name Table   ǥմϴ." << std::endl;
 		std::cout << "IED : Image Export Directory   ǥմϴ." << std::endl;
 		std::cout << "EAT : Export Address Table   ǥմϴ." << std::endl;
 		std::cout << "ENT : Export Name Table   ǥմϴ." << std::endl;
 		std::cout << "EOT : Export Ordinal Table   ǥմϴ." << std::endl;
+		std::cout << "EXP : Export ̸, Ordinal, ּҷ ˻մϴ." << std::endl;
+		std::cout << "RES : Resource Directory   ǥմϴ." << std::endl;
+		std::cout << "RELOC : Base Relocation   ǥմϴ." << std::endl;
+		std::cout << "FUNC : x64 Exception Directory ּҰ  Լ ãϴ." << std::endl;
+		std::cout << "DEBUG : Debug Directory CodeView(PDB)  ǥմϴ." << std::endl;
+		std::cout << "CERT :  ̺ Authenticode ؽø ǥմϴ." << std::endl;
+		std::cout << "STRINGS : Section Overlay ASCII, UTF-16LE ڿ ǥմϴ." << std::endl;
+		std::cout << "SIG : Ģ  Ʈ ñ״ó Section, Entry Point, Overlay ãϴ." << std::endl;
+		std::cout << "HASH : , Section, Overlay MD5, SHA-1, SHA-256 ؽø ǥմϴ." << std::endl;
+		std::cout << "OVERLAY :  Section ڿ   ũ, Ʈ,   ñ״ó ǥմϴ." << std::endl;
+		std::cout << "JSON : Ľ  ü   JSON մϴ." << std::endl;
 		std::cout << "CLS : ȭ ϴ." << std::endl;
 		std::cout << "EXIT : α׷ մϴ." << std::endl;
 		std::cout << std::endl;
@@ -1475,6 +3994,14 @@ void PEFile::printHelp(const std::string& cmd)
 		std::cout << "-rb : DOS STUB α׷  Ʈ  ڿ ÿ ǥմϴ" << std::endl;
 		std::cout << std::endl;
 	}
+	else if (cmd == "RICH")
+	{
+		std::cout << "DOS STUB ڿ MSVC Ŀ  Rich Header ص ǥմϴ." << std::endl;
+		std::cout << "⺻ ɾ : DanS ġ, XOR Ű, üũ   @comp.id ׸ ǥմϴ." << std::endl;
+		std::cout << "üũ DOS (e_lfanew ), DanS  STUB,  ׸ ٽ  XOR Ű մϴ." << std::endl;
+		std::cout << " ׸ @comp.id(Product, Build),  ̸, Build, Ʈ , Visual Studio Դϴ." << std::endl;
+		std::cout << std::endl;
+	}
 	else if (cmd == "NT")
 	{
 		std::cout << "NT    ǥմϴ." << std::endl;
@@ -1492,13 +4019,14 @@ void PEFile::printHelp(const std::string& cmd)
 	else if (cmd == "SH")
 	{
 		std::cout << "Section    ǥմϴ." << std::endl;
-		std::cout << "⺻ ɾ : ϴ Section  մϴ. (index : name)" << std::endl << std::endl;
+		std::cout << "⺻ ɾ : ϴ Section  մϴ. (index : name entropy)" << std::endl << std::endl;
 		std::cout << "ɼ" << std::endl;
 		std::cout << "[index] : ش ε Section   ǥմϴ." << std::endl;
 		std::cout << "[name] : ش ̸ Section   ǥ մϴ." << std::endl;
 		std::cout << "-r : ش ɼ տ  Section   ڿ ǥմϴ." << std::endl;
 		std::cout << "-b : ش ɼ տ  Section   Ʈ  ǥմϴ." << std::endl;
 		std::cout << "-rb : ش ɼ տ  Section   Ʈ  ڿ ÿ ǥմϴ." << std::endl;
+		std::cout << "-e : ش ɼ տ  Section ƮǸ 0x1000 Ʈ â 0x800 Ʈ ̵ϸ ǥմϴ." << std::endl;
 		std::cout << std::endl;
 	}
 	else if (cmd == "IDT")
@@ -1531,6 +4059,26 @@ void PEFile::printHelp(const std::string& cmd)
 		std::cout << "-rb : Import Address Table   RVA  Ʈ  ڿ ÿ ǥմϴ" << std::endl;
 		std::cout << std::endl;
 	}
+	else if (cmd == "DIDT")
+	{
+		std::cout << "Delay Import Directory Table   ǥմϴ." << std::endl;
+		std::cout << "⺻ ɾ :  εǴ DLL IMAGE_DELAYLOAD_DESCRIPTOR  Ҹ մϴ." << std::endl << std::endl;
+		std::cout << "ɼ" << std::endl;
+		std::cout << "-r : Delay Import Directory Table  ڿ ǥմϴ." << std::endl;
+		std::cout << "-b : Delay Import Directory Table  Ʈ  ǥմϴ" << std::endl;
+		std::cout << "-rb : Delay Import Directory Table  Ʈ  ڿ ÿ ǥմϴ" << std::endl;
+		std::cout << std::endl;
+	}
+	else if (cmd == "DINT")
+	{
+		std::cout << "Delay Import Name Table   ǥմϴ." << std::endl;
+		std::cout << "⺻ ɾ : Delay Import Name Table  Ҹ մϴ" << std::endl << std::endl;
+		std::cout << "ɼ" << std::endl;
+		std::cout << "-r : Delay Import Name Table   RVA  ڿ ǥմϴ" << std::endl;
+		std::cout << "-b : Delay Import Name Table   RVA  Ʈ  ǥմϴ" << std::endl;
+		std::cout << "-rb : Delay Import Name Table   RVA  Ʈ  ڿ ÿ ǥմϴ" << std::endl;
+		std::cout << std::endl;
+	}
 	else if (cmd == "IED")
 	{
 		std::cout << "Image Export Directory   ǥմϴ." << std::endl;
@@ -1571,6 +4119,111 @@ void PEFile::printHelp(const std::string& cmd)
 		std::cout << "-rb : Export Ordinal Table  Ʈ  ڿ ÿ ǥմϴ" << std::endl;
 		std::cout << std::endl;
 	}
+	else if (cmd == "EXP")
+	{
+		std::cout << "Export ̸, Ordinal, ּҷ ˻մϴ." << std::endl;
+		std::cout << "⺻ ɾ : EXP [name] ̸ ġϴ Export ǥմϴ. (ҹ )" << std::endl << std::endl;
+		std::cout << "ɼ" << std::endl;
+		std::cout << "-o [ordinal] : ش Ordinal(16) Export ǥմϴ." << std::endl;
+		std::cout << "-a [rva] : ش ּ(16)    Export ǥմϴ." << std::endl;
+		std::cout << std::endl;
+	}
+	else if (cmd == "RES")
+	{
+		std::cout << "Resource Directory   ǥմϴ." << std::endl;
+		std::cout << "⺻ ɾ : Resource Ÿ԰ ŸԺ ׸  մϴ." << std::endl << std::endl;
+		std::cout << "ɼ" << std::endl;
+		std::cout << "[type] : ش Ÿ(ICON, VERSION  ̸ Ǵ 16 ID) Resource ̸ /  ǥմϴ." << std::endl;
+		std::cout << "-v : VS_VERSIONINFO   ǥմϴ." << std::endl;
+		std::cout << "-m : Manifest ǥմϴ." << std::endl;
+		std::cout << std::endl;
+	}
+	else if (cmd == "RELOC")
+	{
+		std::cout << "Base Relocation   ǥմϴ." << std::endl;
+		std::cout << "⺻ ɾ :   ŸԺ Relocation  ǥմϴ." << std::endl << std::endl;
+		std::cout << "ɼ" << std::endl;
+		std::cout << "[begin] [end] : RVA begin ̻ end ̸(16) Relocation ġ  ǥմϴ." << std::endl;
+		std::cout << "-a :  Relocation ǥմϴ." << std::endl;
+		std::cout << std::endl;
+	}
+	else if (cmd == "FUNC")
+	{
+		std::cout << "x64 Exception Directory(.pdata) ּҰ  Լ ãϴ." << std::endl;
+		std::cout << "⺻ ɾ : Լ   ǥմϴ." << std::endl << std::endl;
+		std::cout << "ɼ" << std::endl;
+		std::cout << "[rva] ... :  ּ(16)  Լ ǥմϴ. ּҰ ϳ Unwind  ǥմϴ." << std::endl;
+		std::cout << "-f [path] : Ͽ  ּ(16,  Ǵ  )   ãϴ." << std::endl;
+		std::cout << "-a :  Լ ǥմϴ." << std::endl;
+		std::cout << std::endl;
+	}
+	else if (cmd == "DEBUG")
+	{
+		std::cout << "Debug Directory   ǥմϴ." << std::endl;
+		std::cout << "⺻ ɾ :  ׸ CodeView(PDB GUID, Age, ), Repro, VC Feature  ǥմϴ." << std::endl;
+		std::cout << "Symbol Key ɺ  PDB ã GUID AgeԴϴ." << std::endl << std::endl;
+		std::cout << "ɼ" << std::endl;
+		std::cout << "-p : POGO ׸(Section  RVA, ũ, ̸) ǥմϴ." << std::endl;
+		std::cout << std::endl;
+	}
+	else if (cmd == "CERT")
+	{
+		std::cout << "Security Directory WIN_CERTIFICATE ׸ Authenticode ؽø ǥմϴ." << std::endl;
+		std::cout << "Security Directory ּҴ RVA ƴ  Դϴ." << std::endl;
+		std::cout << "Authenticode ؽô CheckSum, Security Directory ׸,  ̺   ü MD5, SHA-1, SHA-256Դϴ." << std::endl;
+		std::cout << "  ʽϴ." << std::endl;
+		std::cout << std::endl;
+	}
+	else if (cmd == "STRINGS")
+	{
+		std::cout << " Section Overlay ASCII, UTF-16LE ڿ ã ǥմϴ." << std::endl;
+		std::cout << "⺻ ɾ : 4 ̻ ڿ  , Section, RVA Բ ǥմϴ. (A : ASCII, U : UTF-16LE)" << std::endl << std::endl;
+		std::cout << "ɼ" << std::endl;
+		std::cout << "-n [length] : ּ  (10) մϴ." << std::endl;
+		std::cout << "-a : ASCII ڿ ǥմϴ." << std::endl;
+		std::cout << "-u : UTF-16LE ڿ ǥմϴ." << std::endl;
+		std::cout << std::endl;
+	}
+	else if (cmd == "SIG")
+	{
+		std::cout << "Ģ  Ʈ ñ״ó ã  , Section, RVA Բ ǥմϴ." << std::endl;
+		std::cout << "⺻ ɾ : SIG [Ģ ]" << std::endl << std::endl;
+		std::cout << "Ģ   ٿ ϳ \"̸  Ʈ\" ̸ # ڴ ּԴϴ." << std::endl;
+		std::cout << " : * (ü), entry (Entry Point " << SignatureSet::entryRegion << "Ʈ), overlay, Section ̸ (ǥ  )" << std::endl;
+		std::cout << "Ʈ : 16, ??  Ʈ, ?  ϺԴϴ. ) UPX0 entry 60 BE ?? ?? ?? ?? 8D BE" << std::endl;
+		std::cout << std::endl;
+	}
+	else if (cmd == "HASH")
+	{
+		std::cout << ", Section, Overlay MD5, SHA-1, SHA-256 ؽø ǥմϴ." << std::endl;
+		std::cout << "   鼭   ؽø  մϴ." << std::endl;
+		std::cout << "Section PointerToRawData SizeOfRawDataŭ, Overlay  Section ں  Դϴ." << std::endl << std::endl;
+		std::cout << "ɼ" << std::endl;
+		std::cout << "-f : з ؽ(MD5) ǥմϴ.  ٽ  ʰ Ľ ̺ մϴ." << std::endl;
+		std::cout << "     Imphash : Import \"dll.Լ\" ҹڷ ǥ   (pefile  Ģ)" << std::endl;
+		std::cout << "     Rich : XOR Ǭ Rich Header (DanS Rich ձ)" << std::endl;
+		std::cout << "     Exports : Export ̸ ҹڷ  ǥ  " << std::endl;
+		std::cout << std::endl;
+	}
+	else if (cmd == "OVERLAY")
+	{
+		std::cout << " Section PointerToRawData + SizeOfRawData ڿ  Overlay мմϴ." << std::endl;
+		std::cout << "Overlay ̳ տ   ̺ Overlay ϰ  ǥմϴ." << std::endl;
+		std::cout << "⺻ ɾ : Overlay , ũ, Ʈǿ ZIP, 7z, CAB, NSIS ñ״ó ó  Overlay   ǥմϴ." << std::endl;
+		std::cout << "Overlay " << OverlayScanner::chunkSize / 1024 << "KB    Ƿ ū ġ ϵ ޸𸮸  մϴ." << std::endl << std::endl;
+		std::cout << "ɼ" << std::endl;
+		std::cout << "-x [bytes] : Overlay պκ Ʈ  ڿ ǥմϴ. (⺻ 256Ʈ, ִ " << OverlayScanner::chunkSize / 1024 << "KB, 10)" << std::endl;
+		std::cout << std::endl;
+	}
+	else if (cmd == "JSON")
+	{
+		std::cout << "Ľ  ü   JSON մϴ." << std::endl;
+		std::cout << "⺻ ɾ : DOS, NT , Section , Import, Delay Import, Export, Debug Directory մϴ." << std::endl << std::endl;
+		std::cout << "ɼ" << std::endl;
+		std::cout << "-headers : Data Directory ϰ  մϴ." << std::endl;
+		std::cout << "HASH, HASH -f ɾ  ڿ ؽõ Բ մϴ." << std::endl;
+		std::cout << std::endl;
+	}
 }
 
 void PEFile::GetMachineString(WORD machine)
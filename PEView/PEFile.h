@@ -1,26 +1,67 @@
 #pragma once
 #include <fstream>
+#include <string_view>
+#include <variant>
 #include <vector>
 #include <unordered_map>
 #include <Windows.h>
+#include "MappedFile.h"
+#include "SectionIndex.h"
+#include "ExportIndex.h"
+#include "HexDump.h"
+#include "OutputSink.h"
+#include "JsonWriter.h"
+#include "ParseCache.h"
+#include "FileHasher.h"
+#include "Entropy.h"
+#include "ResourceTree.h"
+#include "RelocationTable.h"
+#include "FunctionTable.h"
+#include "DebugDirectory.h"
+#include "CertificateTable.h"
+#include "StringScanner.h"
+#include "SignatureSet.h"
+#include "Fingerprint.h"
+#include "RichHeader.h"
+#include "OverlayScanner.h"
+#include "StringArena.h"
+#include "ImageTraits.h"
 
+// names are views into the mapped image or the PEFile string arena
 struct IIDX {
 	IMAGE_IMPORT_DESCRIPTOR iid;
-	std::string Name;
+	std::string_view Name;
 };
 
-struct INT_Element {
-	ULONGLONG addr;
-	WORD Hint;
-	std::string Name;
+// addresses are VAs instead of RVAs when Attributes.RvaBased is clear (VC6 and older)
+struct DelayIIDX {
+	IMAGE_DELAYLOAD_DESCRIPTOR did;
+	std::string_view Name;
 };
 
-struct INT_Elementx86 {
-	DWORD addr;
+template <typename Traits>
+struct INT_Element {
+	typename Traits::Thunk addr;
 	WORD Hint;
-	std::string Name;
+	std::string_view Name;
 };
 
+/*
+| NT headers and import tables of one bitness.	|
+| a PEFile holds exactly one of these.			|
+*/
+template <typename Traits>
+struct ImageModel {
+	typedef Traits traits;
+
+	typename Traits::NtHeaders ntHeaders;
+	std::vector<INT_Element<Traits>> INT;
+	std::vector<typename Traits::Thunk> IAT;
+
+	// delay load imports, laid out like INT and IAT
+	std::vector<INT_Element<Traits>> delayINT;
+	std::vector<typename Traits::Thunk> delayIAT;
+};
 
 /*
 | ordinal	2byte	|
@@ -28,55 +69,274 @@ struct INT_Elementx86 {
 | rva		4byte	|
 | funcAddr	4byte	|
 | null		4byte	|
-| name		40byte	|
+| name		16byte	|
 */
 struct ExportElement {
 	WORD ordinal;
 	DWORD rva;
 	DWORD funcAddr;
-	std::string name;
+	std::string_view name;
+};
+
+/*
+| file offsets of the export arrays and how many entries |
+| of each fit the file data of their sections.           |
+*/
+struct ExportLayout {
+	DWORD names;
+	DWORD ordinals;
+	DWORD functions;
+	DWORD nameCount;
+	DWORD functionCount;
 };
 
 class PEFile
 {
 public:
-	PEFile(const std::string& filePath);
+	PEFile(const std::string& filePath, bool verbose = true, ParseCache* cache = nullptr);
+	// stores the cache entry with the directories read since it was opened
+	~PEFile();
+	PEFile(const PEFile&) = delete;
+	PEFile& operator=(const PEFile&) = delete;
 
 public:
 	void Run();
+	void RunScript(const std::vector<std::string>& script);
+	bool Execute(const std::string& line);		// false on EXIT
+
+	// "DOS NT -OPT IDT" -> { "DOS", "NT -OPT", "IDT" }
+	static std::vector<std::string> SplitCommands(const std::string& text);
+	// renders the import and export tables, false when a Bench build sees parse or print allocate per symbol
+	bool Benchmark(int iterations);
+
+	// one JSON object with every parsed structure, no trailing newline
+	void WriteJson(JsonWriter& json, bool headersOnly = false);
+
+	// accessors
+	bool IsX86() const { return std::holds_alternative<ImageModel<PE32Traits>>(m_model); }
+	WORD GetMachine() const { return fileHeader().Machine; }
+	const std::string& GetError() const { return m_error; }
+	const std::vector<IMAGE_SECTION_HEADER>& GetSectionHeaders() const { return m_sectionHeaders; }
+	bool TranslateRva(DWORD rva, DWORD& offset) const { return m_sectionIndex.translate(rva, offset); }
+	size_t TranslateRvas(const DWORD* rvas, DWORD* offsets, size_t count) const { return m_sectionIndex.translate(rvas, offsets, count); }
+	DWORD GetDirectoryCount() const;
+	const IMAGE_DATA_DIRECTORY& GetDataDirectory(int index) const;
+
+	// parse the directory on first call
+	const std::vector<IIDX>& GetImportDescriptors();
+	size_t GetImportCount();
+	const std::vector<DelayIIDX>& GetDelayImportDescriptors();
+	size_t GetDelayImportCount();
+	const std::vector<ExportElement>& GetExportTable();
+	const ExportIndex& GetExportIndex();
+	bool FindExport(const std::string& name, ExportSymbol& symbol);
+	bool FindExportByOrdinal(DWORD ordinal, ExportSymbol& symbol);
+	bool FindExportByAddress(DWORD rva, ExportSymbol& symbol);
+
+	// MD5 / SHA-1 / SHA-256 of the file, every section and the overlay, hashed on first call
+	bool Hash(bool threads = true);
+	const DigestSet& GetFileDigest() const { return m_hasher.file(); }
+	const std::vector<HashRange>& GetHashRanges() const { return m_hashRanges; }		// sections, then the overlay if any
+	const std::vector<DigestSet>& GetRangeDigests() const { return m_hasher.ranges(); }
+	bool HasOverlay() const { return m_hashRanges.size() > m_sectionHeaders.size(); }
+
+	// security directory, its VirtualAddress is a file offset
+	const CertificateTable& GetCertificates();
+	// Authenticode image digest : the file without the checksum, the security directory entry
+	// and the certificate table, hashed on first call
+	bool HashAuthenticode(bool threads = true);
+	const DigestSet& GetAuthenticodeDigest() const { return m_authenticode; }
+
+	// resource tree, only the root is read until a lookup walks further
+	ResourceTree& GetResourceTree();
+	bool GetVersionInfo(VersionInfo& info);
+	bool GetManifest(std::string& manifest);
+	const BYTE* GetResourceData(DWORD node, ULONGLONG& size, std::vector<BYTE>& buffer);
+
+	// base relocations, sorted by RVA
+	const RelocationTable& GetRelocations();
+	// headers and sections copied to their RVAs, SizeOfImage bytes, false when SizeOfImage runs past the last section
+	bool MapImage(std::vector<BYTE>& image);
+	// rebases an image laid out like MapImage() from ImageBase to base, returns the fixups written
+	size_t ApplyRelocations(BYTE* image, size_t imageSize, ULONGLONG base);
+
+	// x64 exception directory
+	const FunctionTable& GetFunctionTable();
+	bool GetUnwindInfo(size_t function, UnwindInfo& info);
+	DWORD GetFunctionStart(size_t function);		// BeginAddress of the head of a chained function
+	// indices[i] is the function containing rvas[i] or FunctionTable::npos
+	void FindFunctions(const DWORD* rvas, size_t* indices, size_t count);
+	std::string Symbolize(DWORD rva, size_t function);		// "export+off" or "sub_XXXXXXXX+off"
+
+	// debug directory, the records its entries point to are read on request
+	const DebugDirectory& GetDebugDirectory();
+	const BYTE* GetDebugData(size_t entry, ULONGLONG& size, std::vector<BYTE>& buffer);
+	bool GetCodeView(CodeViewInfo& info);		// first CodeView record
+
+	// bits per byte of every section's raw data, counted on first call
+	const std::vector<double>& GetSectionEntropy();
+
+	// ASCII and UTF-16LE strings of every section, then the overlay, scanned again when minLength changes
+	bool ScanStrings(size_t minLength = StringScanner::defaultMinLength, bool threads = true);
+	const std::vector<StringHit>& GetStrings() const { return m_stringHits; }
+	std::string_view GetStringText(const StringHit& hit) const { return std::string_view(m_stringText).substr(hit.text, hit.length); }
+
+	// byte signatures, each rule limited to its sections, the entry point region or the overlay
+	bool MatchSignatures(const SignatureSet& rules);
+	const std::vector<SignatureMatch>& GetSignatureMatches() const { return m_signatureMatches; }
+
+	// Rich header of the DOS stub, decoded on first call
+	const RichHeader& GetRichHeader();
+
+	// imphash, Rich header hash and export name hash from the parsed tables, on first call
+	const FingerprintSet& GetFingerprint();
+
+	// data past the raw data of the last section and past a certificate table appended to it,
+	// streamed once in OverlayScanner::chunkSize chunks for its entropy and archive signatures
+	bool ScanOverlay();
+	const OverlayInfo& GetOverlay() const { return m_overlay; }
+	const OverlayScanner& GetOverlayScan() const { return m_overlayScan; }
 
 private:
+	template <typename Source>
+	bool load(Source& source);
+	bool fail(const char* message);
+
 	// read data
 	bool readDosHeader(std::ifstream& file);
 	bool readDosStub(std::ifstream& file);
 	bool readNtHeaders(std::ifstream& file);
-	bool readNtHeaderx86(std::ifstream& file);
 	bool readSectionHeaders(std::ifstream& file);
 
-	bool readDirectory(std::ifstream& file);
+	// parse cache entries
+	void serialize(const CacheKey& key, std::vector<BYTE>& blob);
+	DWORD cachedDirectories() const;
+	bool restore(const MappedFile& entry);
+
+	// data directories are parsed on first access and memoized
+	bool readDirectory(int index);
+	template <typename Source>
+	bool readDirectory(Source& source, int index);
 	bool readExportDirectory(std::ifstream& file, DWORD rva);
-	bool readImportDirectory(std::ifstream& file, DWORD rva);
+	std::string_view readName(std::ifstream& file, ULONGLONG offset);
+	// both export readers take the arrays from here, false when the name arrays do not fit
+	bool locateExports(ExportLayout& layout);
+	bool readResourceDirectory(DWORD rva);
+	bool readRelocationDirectory(DWORD rva);
+	bool readExceptionDirectory(DWORD rva);
+	bool readDebugDirectory(DWORD rva);
+	bool readSecurityDirectory();
+
+	// raw data of every section clipped to the file, then the overlay if any
+	void sectionRanges(std::vector<HashRange>& ranges);
+	// the overlay past the sections without the certificate table, and the certificate table apart
+	void locateOverlay(OverlayInfo& overlay);
+
+	// read data from the mapped image
+	bool readDosHeader(const MappedFile& image);
+	bool readDosStub(const MappedFile& image);
+	bool readNtHeaders(const MappedFile& image);
+	bool readSectionHeaders(const MappedFile& image);
+	bool readExportDirectory(const MappedFile& image, DWORD rva);
+	std::string_view readName(const MappedFile& image, ULONGLONG offset);
+
+	// import and delay import tables share the thunk walk, Source is either of the above
+	template <typename Traits, typename Source>
+	bool readImportDirectory(Source& source, DWORD rva, ImageModel<Traits>& model);
+	template <typename Traits, typename Source>
+	bool readDelayImportDirectory(Source& source, DWORD rva, ImageModel<Traits>& model);
+	template <typename Traits, typename Source>
+	void readThunks(Source& source, DWORD lookupRva, DWORD iatRva, ULONGLONG base, std::string_view module,
+		std::vector<INT_Element<Traits>>& names, std::vector<typename Traits::Thunk>* iat);
+	// a lookup table up to and including its terminator, false when the file ends first
+	template <typename Thunk>
+	bool readThunkArray(std::ifstream& file, ULONGLONG offset, std::vector<Thunk>& thunks);
+	template <typename Thunk>
+	bool readThunkArray(const MappedFile& image, ULONGLONG offset, std::vector<Thunk>& thunks);
+	// count thunks appended to thunks, zero past the end of the file
+	template <typename Thunk>
+	void readThunkArray(std::ifstream& file, ULONGLONG offset, size_t count, std::vector<Thunk>& thunks);
+	template <typename Thunk>
+	void readThunkArray(const MappedFile& image, ULONGLONG offset, size_t count, std::vector<Thunk>& thunks);
+	template <typename T>
+	bool readValue(std::ifstream& file, ULONGLONG offset, T& value);
+	template <typename T>
+	bool readValue(const MappedFile& image, ULONGLONG offset, T& value) { return image.read(offset, value); }
+	template <typename T>
+	bool readArray(std::ifstream& file, ULONGLONG offset, std::vector<T>& values);
+
+	// raw file bytes, from the mapping or read into buffer; size is clipped to the file
+	ULONGLONG fileSize();
+	const BYTE* readRaw(ULONGLONG offset, ULONGLONG& size, std::vector<BYTE>& buffer);
 
 	// functional
 	void printDosHeader();
 	void printNtHeaders();
 	void printFileHeader();
 	void printOptionalHeader();
-	void printSectionHeader(IMAGE_SECTION_HEADER& header);
+	template <typename Traits>
+	void printOptionalHeader(const ImageModel<Traits>& model);
+	void printSectionHeader(IMAGE_SECTION_HEADER& header, double entropy);
+	void printEntropyWindows(int index);
 	void printCharacteristics(DWORD characteristics);
 	void printImportDirectoyTable();
 	void printImportNameTable();
 	void printImportAddressTable();
+	template <typename Traits>
+	void printImportNameTable(const std::vector<INT_Element<Traits>>& table);
+	template <typename Traits>
+	void printImportAddressTable(const ImageModel<Traits>& model);
+	void printDelayImportDirectoryTable();
+	void printDelayImportNameTable();
 	void printExportDirectory();
 	void printExportAddressTable();
 	void printExportNameTable();
 	void printExportOrdinalTable();
+	void printExportSymbol(const ExportSymbol& symbol, DWORD rva);
+	void printResourceTypes();
+	void printResources(DWORD type);
+	void printVersionInfo();
+	void printManifest();
+	void printRelocationSummary();
+	void printRelocations(size_t first, size_t last);
+	void printFunctionSummary();
+	void printFunctions(const std::vector<DWORD>& rvas);
+	void printDebugDirectory();
+	void printPogo();
+	void printCertificates();
+	void printHashes();
+	void printStrings(bool ascii, bool wide);
+	void printSignatures();
+	void printFingerprint();
+	void printRichHeader();
+	void printOverlay(size_t dumpSize);
+	void printDigests(const DigestSet& digests);
+
+	// json
+	template <typename Traits>
+	void writeOptionalHeader(JsonWriter& json, const ImageModel<Traits>& model);
+	template <typename Traits>
+	void writeImports(JsonWriter& json, const ImageModel<Traits>& model);
+	template <typename Traits>
+	void writeDelayImports(JsonWriter& json, const ImageModel<Traits>& model);
+	template <typename Traits>
+	void writeThunks(JsonWriter& json, const std::vector<INT_Element<Traits>>& names, const std::vector<typename Traits::Thunk>& iat, size_t& index);
+	void writeExports(JsonWriter& json);
+	void writeDebug(JsonWriter& json);
+	void writeDigests(JsonWriter& json, const DigestSet& digests);
+	void writeStrings(JsonWriter& json);
+	void writeSignatures(JsonWriter& json);
+	void writeFingerprint(JsonWriter& json);
+	void writeRichHeader(JsonWriter& json);
+	void writeOverlay(JsonWriter& json);
 
 	// Utills
 	void printByte(void* data, int size, int first_offset = 0, int interval = 1, int size_of_element = 1);
 	void printRaw(void* data, int size, int first_offset = 0, int interval = 1, int size_of_element = 1);
 	void printByteAndRaw(void* data, int size, int first_offset = 0, int interval = 1, int size_of_element = 1);
 	DWORD rva2raw(DWORD rva);
+	void selectModel(WORD magic);
+	const IMAGE_FILE_HEADER& fileHeader() const;
 
 	void printHelp(const std::string& cmd);
 
@@ -88,60 +348,107 @@ public:
 	bool loaded = false;
 
 private:
+	MappedFile m_image;
+	MappedFile m_cacheEntry;		// names of a restored file point into this mapping
+
 	IMAGE_DOS_HEADER m_dosHeader;
-	IMAGE_NT_HEADERS m_ntHeaders;
-	IMAGE_NT_HEADERS32 m_ntHeaderx86;
+
+	// NT headers and import tables, PE32+ until the optional header magic says otherwise
+	std::variant<ImageModel<PE64Traits>, ImageModel<PE32Traits>> m_model;
 
 	std::vector<IMAGE_SECTION_HEADER> m_sectionHeaders;
+	SectionIndex m_sectionIndex;
 
 	std::unordered_map<std::string, int> commands;
 
 	// import directory data
 	std::vector<IIDX> m_IIDs;
-	std::vector<INT_Element> m_INT;
-	std::vector<INT_Elementx86> m_INTx86;
-	std::vector<ULONGLONG> m_IAT;
-	std::vector<DWORD> m_IATx86;
+	std::vector<DelayIIDX> m_delayIIDs;
 
 	// export directory data
 	IMAGE_EXPORT_DIRECTORY m_IED;
 	std::vector<ExportElement> m_ExportTable;
+	std::string_view m_exportName;
+	std::vector<DWORD> m_exportFunctions;
+	ExportIndex m_exportIndex;
+
+	// resource directory, m_resourceBuffer holds it when the file is not mapped
+	ResourceTree m_resources;
+	std::vector<BYTE> m_resourceBuffer;
+
+	RelocationTable m_relocations;
+	FunctionTable m_functions;
+	DebugDirectory m_debug;
+
+	// file, section and overlay digests
+	FileHasher m_hasher;
+	std::vector<HashRange> m_hashRanges;
+	bool m_hashed = false;
+
+	CertificateTable m_certificates;
+	DigestSet m_authenticode = {};
+	bool m_authenticodeHashed = false;
+
+	// strings of the sections and the overlay, m_stringText holds them back to back
+	std::vector<StringHit> m_stringHits;
+	std::string m_stringText;
+	size_t m_stringMinLength = 0;		// 0 : not scanned
+
+	// matches of the last signature set, which outlives them
+	std::vector<SignatureMatch> m_signatureMatches;
+	const SignatureSet* m_signatureSet = nullptr;
+
+	RichHeader m_rich;
+	bool m_richRead = false;
+
+	FingerprintSet m_fingerprint = {};
+	bool m_fingerprinted = false;
+
+	OverlayInfo m_overlay = {};
+	OverlayScanner m_overlayScan;
+	bool m_overlayScanned = false;
+
+	std::vector<double> m_sectionEntropy;
+	bool m_entropyRead = false;
+	ULONGLONG m_fileSize = 0;
+
+	HexDump m_hexDump;
+	OutputSink m_out;
 	
 	// bytes
 	std::string m_dosStubByte;
 
+	// names read through the ifstream fallback, the token buffer is reused
+	StringArena m_strings;
+	std::string m_nameBuffer;
+
 	// strings
+	std::string m_filePath;
 	std::string m_peName;
 	std::string m_machineStr;
 	std::string m_subSystem;
-	std::string m_exportName;
-
-	// format string x86
-	char x86_2byte_desc32_v32[28] = "      %02X | %-32s | %-32s\n";
-	char x86_4byte_desc32_v32[26] = "    %04X | %-32s | %-32s\n";
-	char x86_8byte_desc32_v32[22] = "%08X | %-32s | %-32s\n";
-
-	char x86_4byte_desc16[26] = "    %04X | %-16s | %-24s\n";
-	char x86_4byte_desc24[26] = "    %04X | %-24s | %-24s\n";
-	char x86_4byte_desc32[26] = "    %04X | %-32s | %-24s\n";	
-
-	char x86_8byte_desc16[22] = "%08X | %-16s | %-24s\n";
-	char x86_8byte_desc24[22] = "%08X | %-24s | %-24s\n";
-	char x86_8byte_desc32[22] = "%08X | %-32s | %-24s\n";	
-
-	char x86_8str_desc16[21] = "%8s | %-16s | %-24s\n";
-	char x86_8str_desc24[21] = "%8s | %-24s | %-24s\n";
-	char x86_8str_desc32[21] = "%8s | %-32s | %-24s\n";
-	char x86_8str_desc16_v32[22] = "%08X | %-16s | %-32s\n";
-
-	// format string x64
-	char x64_2byte_desc32_v32[36] = "              %02X | %-32s | %-32s\n";
-	char x64_4byte_desc32_v32[34] = "            %04X | %-32s | %-32s\n";
-	char x64_8byte_desc32_v32[30] = "        %08X | %-32s | %-32s\n";
-	char x64_16byte_desc32_v32[25] = "%016llX | %-32s | %-32s\n";
-	char x64_16byte_desc16_v32[25] = "%016llX | %-16s | %-32s\n";
-
-	bool x86 = false;
+	std::string m_error;
+
+	// row formats x86
+	RowFormat x86_4byte_desc16 = { 4, 4, 16, 24 };
+	RowFormat x86_4byte_desc24 = { 4, 4, 24, 24 };
+	RowFormat x86_4byte_desc32 = { 4, 4, 32, 24 };	
+
+	RowFormat x86_8byte_desc16 = { 0, 8, 16, 24 };
+	RowFormat x86_8byte_desc24 = { 0, 8, 24, 24 };
+	RowFormat x86_8byte_desc32 = { 0, 8, 32, 24 };	
+
+	RowFormat x86_8str_desc16 = { 0, 8, 16, 24 };
+	RowFormat x86_8str_desc24 = { 0, 8, 24, 24 };
+	RowFormat x86_8str_desc32 = { 0, 8, 32, 24 };
+
+	bool m_directoryRead[IMAGE_NUMBEROF_DIRECTORY_ENTRIES] = {};
+
+	bool m_verbose = true;
+	bool m_cached = false;
+	ParseCache* m_cache = nullptr;		// set once the file is keyed and loaded
+	CacheKey m_cacheKey = {};
+	DWORD m_cacheFlags = 0;				// FlagImportsRead / FlagExportsRead of the entry on disk
 	bool exportDir = false;
 	bool hasIAT = false;
 };
@@ -0,0 +1,187 @@
+#include "ParseCache.h"
+#include <cstdio>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+static ULONGLONG rotate(ULONGLONG value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+static ULONGLONG mix(ULONGLONG h)
+{
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDull;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+ULONGLONG ParseCache::hash(const BYTE* data, size_t size)
+{
+	// four independent multiply-rotate lanes over 32 byte blocks, folded at the end
+	const ULONGLONG prime1 = 0x9E3779B185EBCA87ull;
+	const ULONGLONG prime2 = 0xC2B2AE3D27D4EB4Full;
+	ULONGLONG lane[4] = { prime1 + prime2, prime2, 0, 0 - prime1 };
+
+	size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		for (int l = 0; l < 4; ++l)
+		{
+			ULONGLONG word;
+			memcpy(&word, data + i + l * 8, 8);
+			lane[l] = rotate(lane[l] + word * prime2, 31) * prime1;
+		}
+	}
+
+	ULONGLONG h = rotate(lane[0], 1) + rotate(lane[1], 7) + rotate(lane[2], 12) + rotate(lane[3], 18) + size;
+	for (; i < size; ++i)
+		h = rotate(h ^ (data[i] * prime1), 11) * prime2;
+	return mix(h);
+}
+
+ParseCache::ParseCache(const std::string& directory, ULONGLONG limit, bool contentKey)
+	: m_directory(directory), m_limit(limit), m_contentKey(contentKey)
+{
+	std::error_code ec;
+	fs::create_directories(m_directory, ec);
+	for (const auto& entry : fs::directory_iterator(m_directory, ec))
+	{
+		if (entry.is_regular_file(ec))
+			m_size += entry.file_size(ec);
+	}
+}
+
+bool ParseCache::Key(const std::string& filePath, CacheKey& key) const
+{
+	key = {};
+	if (m_contentKey)
+	{
+		// only images are worth hashing, anything else fails the parse right away
+		MappedFile file;
+		if (!file.open(filePath) || file.size() < sizeof(IMAGE_DOS_HEADER) || *file.as<WORD>(0) != IMAGE_DOS_SIGNATURE)
+			return false;
+		key.size = file.size();
+		key.hash = hash(file.data(), (size_t)file.size());
+		return true;
+	}
+
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	BY_HANDLE_FILE_INFORMATION info;
+	BOOL ok = GetFileInformationByHandle(file, &info);
+	CloseHandle(file);
+	if (!ok)
+		return false;
+
+	key.size = ((ULONGLONG)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+	key.time = ((ULONGLONG)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+	key.index = ((ULONGLONG)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+	key.hash = mix(mix(key.index ^ ((ULONGLONG)info.dwVolumeSerialNumber << 32)) ^ mix(key.size + key.time));
+	return true;
+}
+
+std::string ParseCache::entryPath(const CacheKey& key) const
+{
+	char name[24];
+	snprintf(name, sizeof(name), "%016llx.pvc", (unsigned long long)key.hash);
+	return (fs::path(m_directory) / name).string();
+}
+
+bool ParseCache::Open(const CacheKey& key, MappedFile& entry)
+{
+	std::string path = entryPath(key);
+	if (!entry.open(path))
+	{
+		m_misses++;
+		return false;
+	}
+
+	// a hash collision or an entry from another version is a miss, the next store replaces it
+	const CacheHeader* header = entry.as<CacheHeader>(0);
+	if (!header || header->magic != magic || header->version != version || memcmp(&header->key, &key, sizeof(CacheKey)) != 0)
+	{
+		entry.close();
+		m_misses++;
+		return false;
+	}
+
+	// recently used entries are the last to be evicted
+	std::error_code ec;
+	fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+	m_hits++;
+	return true;
+}
+
+void ParseCache::Store(const CacheKey& key, const std::vector<BYTE>& blob)
+{
+	// write a private file and rename it, readers never see a partial entry
+	std::string path = entryPath(key);
+	std::string temp = path + "." + std::to_string(m_serial++) + ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		if (!out.is_open())
+			return;
+		out.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+		if (!out.good())
+		{
+			out.close();
+			std::error_code ec;
+			fs::remove(temp, ec);
+			return;
+		}
+	}
+
+	std::error_code ec;
+	fs::rename(temp, path, ec);
+	if (ec)
+	{
+		fs::remove(temp, ec);
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(m_lock);
+	m_size += blob.size();
+	if (m_size > m_limit)
+		evict();
+}
+
+void ParseCache::evict()
+{
+	struct Entry {
+		fs::file_time_type time;
+		ULONGLONG size;
+		fs::path path;
+	};
+
+	std::vector<Entry> entries;
+	std::error_code ec;
+	ULONGLONG total = 0;
+	for (const auto& entry : fs::directory_iterator(m_directory, ec))
+	{
+		if (!entry.is_regular_file(ec) || entry.path().extension() != ".pvc")
+			continue;
+		Entry e{ entry.last_write_time(ec), entry.file_size(ec), entry.path() };
+		total += e.size;
+		entries.push_back(std::move(e));
+	}
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+
+	// drop to 3/4 of the limit so every store past the limit does not rescan the directory
+	ULONGLONG target = m_limit / 4 * 3;
+	for (const auto& e : entries)
+	{
+		if (total <= target)
+			break;
+		if (fs::remove(e.path, ec))
+			total -= e.size;
+	}
+	m_size = total;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <Windows.h>
+#include "MappedFile.h"
+
+/*
+| identity of a file in the cache.                          |
+| by default it is (volume, file index, size, write time),  |
+| read from the handle without touching the contents.       |
+| with content keys hash is a 64-bit hash of the whole file |
+| and index / time stay zero, so copies share one entry.    |
+*/
+struct CacheKey {
+	ULONGLONG hash;
+	ULONGLONG size;
+	ULONGLONG time;
+	ULONGLONG index;
+};
+
+/*
+| header of one cache entry.                                |
+| everything after it is a flat array aligned to 8 bytes,   |
+| names are offsets into a NUL terminated string pool, so   |
+| the entry is used in place through a read-only mapping.   |
+*/
+struct CacheHeader {
+	DWORD magic;
+	DWORD version;
+	CacheKey key;
+	DWORD flags;
+	DWORD stubSize;
+	DWORD sectionCount;
+	DWORD importCount;		// descriptors
+	DWORD thunkCount;		// INT entries including the end of imports markers
+	DWORD iatCount;
+	DWORD exportCount;
+	DWORD functionCount;
+	DWORD exportName;
+	DWORD exportNameLength;
+	DWORD stringBytes;
+	DWORD reserved;
+};
+
+struct CacheImport {
+	IMAGE_IMPORT_DESCRIPTOR iid;
+	DWORD name;
+	DWORD nameLength;
+};
+
+struct CacheThunk {
+	ULONGLONG addr;
+	DWORD name;
+	DWORD nameLength;
+	WORD hint;
+	WORD reserved[3];
+};
+
+struct CacheExport {
+	DWORD rva;
+	DWORD funcAddr;
+	DWORD name;
+	DWORD nameLength;
+	WORD ordinal;
+	WORD reserved[3];
+};
+
+/*
+| directory of parsed models, shared by every worker.       |
+| a hit maps the entry and bumps its write time, eviction   |
+| drops the entries with the oldest write time first once   |
+| the directory grows past the limit.                       |
+*/
+class ParseCache
+{
+public:
+	static constexpr DWORD magic = 0x31435650;		// "PVC1"
+	static constexpr DWORD version = 2;
+
+	enum Flags {
+		FlagX86 = 1,
+		FlagIAT = 2,
+		FlagExport = 4,
+		FlagImportsRead = 8,		// the entry holds the import directory
+		FlagExportsRead = 16,		// the entry holds the export directory
+	};
+
+public:
+	ParseCache(const std::string& directory, ULONGLONG limit, bool contentKey);
+
+public:
+	bool Key(const std::string& filePath, CacheKey& key) const;
+	bool Open(const CacheKey& key, MappedFile& entry);
+	void Store(const CacheKey& key, const std::vector<BYTE>& blob);
+
+	ULONGLONG Hits() const { return m_hits; }
+	ULONGLONG Misses() const { return m_misses; }
+
+	static ULONGLONG hash(const BYTE* data, size_t size);
+
+private:
+	std::string entryPath(const CacheKey& key) const;
+	void evict();
+
+private:
+	std::string m_directory;
+	ULONGLONG m_limit;
+	bool m_contentKey;
+
+	std::mutex m_lock;
+	ULONGLONG m_size = 0;		// bytes in the directory, scanned once and kept up to date
+	std::atomic<ULONGLONG> m_hits{ 0 };
+	std::atomic<ULONGLONG> m_misses{ 0 };
+	std::atomic<ULONGLONG> m_serial{ 0 };
+};
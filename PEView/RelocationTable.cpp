@@ -0,0 +1,198 @@
+#include "RelocationTable.h"
+#include <cstring>
+#include <algorithm>
+#include <emmintrin.h>
+
+void RelocationTable::clear()
+{
+	m_entries.clear();
+	m_blocks = 0;
+}
+
+size_t RelocationTable::decodeScalar(const WORD* src, size_t count, DWORD page, Relocation* out)
+{
+	Relocation* begin = out;
+	for (size_t i = 0; i < count; ++i)
+	{
+		WORD type = src[i] >> 12;
+		if (type == IMAGE_REL_BASED_ABSOLUTE)
+			continue;
+
+		Relocation entry = { page + (src[i] & 0x0FFF), type, 0 };
+		if (type == IMAGE_REL_BASED_HIGHADJ && i + 1 < count)
+			entry.param = src[++i];
+		*out++ = entry;
+	}
+	return out - begin;
+}
+
+size_t RelocationTable::decodeSSE2(const WORD* src, size_t count, DWORD page, Relocation* out)
+{
+	const __m128i offsetMask = _mm_set1_epi16(0x0FFF);
+	const __m128i absolute = _mm_setzero_si128();
+	const __m128i highAdj = _mm_set1_epi16(IMAGE_REL_BASED_HIGHADJ);
+	const __m128i base = _mm_set1_epi32((int)page);
+	const __m128i zero = _mm_setzero_si128();
+
+	Relocation* begin = out;
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i types = _mm_srli_epi16(v, 12);
+
+		// a HIGHADJ pairs with the next slot, which may be in the next group
+		__m128i special = _mm_or_si128(_mm_cmpeq_epi16(types, absolute), _mm_cmpeq_epi16(types, highAdj));
+		if (_mm_movemask_epi8(special))
+		{
+			size_t rest = count - i;
+			size_t n = 8;
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(types, highAdj)))
+				n = rest;		// hand everything left to the scalar decoder
+			out += decodeScalar(src + i, n, page, out);
+			if (n == rest)
+				return out - begin;
+			continue;
+		}
+
+		// rva = page + offset as 32-bit lanes, then interleaved with the type (param stays 0)
+		__m128i offsets = _mm_and_si128(v, offsetMask);
+		__m128i rvaLo = _mm_add_epi32(_mm_unpacklo_epi16(offsets, zero), base);
+		__m128i rvaHi = _mm_add_epi32(_mm_unpackhi_epi16(offsets, zero), base);
+		__m128i typeLo = _mm_unpacklo_epi16(types, zero);
+		__m128i typeHi = _mm_unpackhi_epi16(types, zero);
+
+		_mm_storeu_si128((__m128i*)(out + 0), _mm_unpacklo_epi32(rvaLo, typeLo));
+		_mm_storeu_si128((__m128i*)(out + 2), _mm_unpackhi_epi32(rvaLo, typeLo));
+		_mm_storeu_si128((__m128i*)(out + 4), _mm_unpacklo_epi32(rvaHi, typeHi));
+		_mm_storeu_si128((__m128i*)(out + 6), _mm_unpackhi_epi32(rvaHi, typeHi));
+		out += 8;
+	}
+
+	out += decodeScalar(src + i, count - i, page, out);
+	return out - begin;
+}
+
+bool RelocationTable::parse(const BYTE* data, size_t size)
+{
+	clear();
+
+	// every entry is at least 2 bytes, so this is the only allocation
+	m_entries.resize(size / sizeof(WORD));
+	Relocation* out = m_entries.data();
+
+	size_t pos = 0;
+	while (pos + sizeof(IMAGE_BASE_RELOCATION) <= size)
+	{
+		IMAGE_BASE_RELOCATION block;
+		memcpy(&block, data + pos, sizeof(block));
+		if (block.SizeOfBlock < sizeof(IMAGE_BASE_RELOCATION) || block.SizeOfBlock > size - pos)
+			break;
+
+		size_t count = (block.SizeOfBlock - sizeof(IMAGE_BASE_RELOCATION)) / sizeof(WORD);
+		const WORD* src = reinterpret_cast<const WORD*>(data + pos + sizeof(IMAGE_BASE_RELOCATION));
+		out += decodeSSE2(src, count, block.VirtualAddress, out);
+
+		m_blocks++;
+		pos += (block.SizeOfBlock + 3) & ~3u;
+	}
+	m_entries.resize(out - m_entries.data());
+
+	// linkers emit pages in order, a hand made table may not
+	auto before = [](const Relocation& a, const Relocation& b) { return a.rva < b.rva; };
+	if (!std::is_sorted(m_entries.begin(), m_entries.end(), before))
+		std::stable_sort(m_entries.begin(), m_entries.end(), before);
+	return m_blocks != 0;
+}
+
+void RelocationTable::range(DWORD begin, DWORD end, size_t& first, size_t& last) const
+{
+	auto lower = [](const Relocation& entry, DWORD rva) { return entry.rva < rva; };
+	first = std::lower_bound(m_entries.begin(), m_entries.end(), begin, lower) - m_entries.begin();
+	last = std::lower_bound(m_entries.begin() + first, m_entries.end(), end, lower) - m_entries.begin();
+}
+
+size_t RelocationTable::apply(BYTE* image, size_t imageSize, ULONGLONG delta) const
+{
+	size_t applied = 0;
+	for (const Relocation& entry : m_entries)
+	{
+		int width = Width(entry.type);
+		if (width == 0 || entry.rva > imageSize || imageSize - entry.rva < (size_t)width)
+			continue;
+
+		BYTE* target = image + entry.rva;
+		switch (entry.type)
+		{
+		case IMAGE_REL_BASED_HIGH:
+		{
+			WORD value;
+			memcpy(&value, target, 2);
+			value = (WORD)((((DWORD)value << 16) + (DWORD)delta) >> 16);
+			memcpy(target, &value, 2);
+			break;
+		}
+		case IMAGE_REL_BASED_LOW:
+		{
+			WORD value;
+			memcpy(&value, target, 2);
+			value = (WORD)(value + (WORD)delta);
+			memcpy(target, &value, 2);
+			break;
+		}
+		case IMAGE_REL_BASED_HIGHLOW:
+		{
+			DWORD value;
+			memcpy(&value, target, 4);
+			value += (DWORD)delta;
+			memcpy(target, &value, 4);
+			break;
+		}
+		case IMAGE_REL_BASED_HIGHADJ:
+		{
+			// the low half comes from the extra slot, rounded into the high half
+			WORD value;
+			memcpy(&value, target, 2);
+			DWORD full = ((DWORD)value << 16) + (DWORD)(LONG)(SHORT)entry.param + (DWORD)delta + 0x8000;
+			value = (WORD)(full >> 16);
+			memcpy(target, &value, 2);
+			break;
+		}
+		case IMAGE_REL_BASED_DIR64:
+		{
+			ULONGLONG value;
+			memcpy(&value, target, 8);
+			value += delta;
+			memcpy(target, &value, 8);
+			break;
+		}
+		}
+		applied++;
+	}
+	return applied;
+}
+
+const char* RelocationTable::TypeName(WORD type)
+{
+	static const char* const names[] = {
+		"ABSOLUTE", "HIGH", "LOW", "HIGHLOW", "HIGHADJ", "MACHINE_SPECIFIC_5", "RESERVED",
+		"MACHINE_SPECIFIC_7", "MACHINE_SPECIFIC_8", "MACHINE_SPECIFIC_9", "DIR64"
+	};
+	return type < sizeof(names) / sizeof(names[0]) ? names[type] : "UNKNOWN";
+}
+
+int RelocationTable::Width(WORD type)
+{
+	switch (type)
+	{
+	case IMAGE_REL_BASED_HIGH:
+	case IMAGE_REL_BASED_LOW:
+	case IMAGE_REL_BASED_HIGHADJ:
+		return 2;
+	case IMAGE_REL_BASED_HIGHLOW:
+		return 4;
+	case IMAGE_REL_BASED_DIR64:
+		return 8;
+	}
+	return 0;
+}
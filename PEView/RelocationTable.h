@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <Windows.h>
+
+/*
+| rva		4byte	|
+| type		2byte	|
+| param		2byte	|	the extra slot of IMAGE_REL_BASED_HIGHADJ
+*/
+struct Relocation {
+	DWORD rva;
+	WORD type;
+	WORD param;
+};
+
+/*
+| base relocations as one flat array sorted by RVA.         |
+| the 16-bit entries of a block are decoded eight at a time |
+| with SSE2 straight into the array, which is sized once    |
+| from the directory, so millions of fixups cost one        |
+| allocation. padding (ABSOLUTE) and HIGHADJ slots send     |
+| their group of eight through the scalar decoder.          |
+*/
+class RelocationTable
+{
+public:
+	void clear();
+	bool parse(const BYTE* data, size_t size);
+
+	const std::vector<Relocation>& entries() const { return m_entries; }
+	size_t blocks() const { return m_blocks; }
+
+	// entries with begin <= rva < end are [first, last)
+	void range(DWORD begin, DWORD end, size_t& first, size_t& last) const;
+
+	// image is laid out by RVA (SizeOfImage bytes), returns the number of fixups written
+	size_t apply(BYTE* image, size_t imageSize, ULONGLONG delta) const;
+
+	static const char* TypeName(WORD type);
+	static int Width(WORD type);		// bytes patched by a fixup, 0 for types that are not applied
+
+private:
+	static size_t decodeScalar(const WORD* src, size_t count, DWORD page, Relocation* out);
+	static size_t decodeSSE2(const WORD* src, size_t count, DWORD page, Relocation* out);
+
+private:
+	std::vector<Relocation> m_entries;
+	size_t m_blocks = 0;
+};
@@ -0,0 +1,277 @@
+#include "ResourceTree.h"
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+static inline WORD load16(const BYTE* p)
+{
+	return (WORD)(p[0] | (p[1] << 8));
+}
+
+static inline size_t align4(size_t value)
+{
+	return (value + 3) & ~(size_t)3;
+}
+
+void ResourceTree::clear()
+{
+	m_data = nullptr;
+	m_size = 0;
+	m_nodes.clear();
+}
+
+bool ResourceTree::open(const BYTE* data, size_t size)
+{
+	clear();
+	m_data = data;
+	m_size = size;
+
+	ResourceNode root = {};
+	root.directory = true;
+	if (!directoryCount(0, root.count))
+		return false;
+	m_nodes.push_back(root);
+	return true;
+}
+
+bool ResourceTree::directoryCount(DWORD offset, DWORD& count) const
+{
+	if (offset > m_size || m_size - offset < sizeof(IMAGE_RESOURCE_DIRECTORY))
+		return false;
+
+	IMAGE_RESOURCE_DIRECTORY directory;
+	memcpy(&directory, m_data + offset, sizeof(directory));
+	DWORD total = (DWORD)directory.NumberOfNamedEntries + directory.NumberOfIdEntries;
+
+	// entries past the end of the directory are dropped, not the whole level
+	size_t room = (m_size - offset - sizeof(IMAGE_RESOURCE_DIRECTORY)) / sizeof(IMAGE_RESOURCE_DIRECTORY_ENTRY);
+	count = (DWORD)(total < room ? total : room);
+	return true;
+}
+
+DWORD ResourceTree::children(DWORD index)
+{
+	if (m_nodes[index].expanded)
+		return m_nodes[index].first;
+
+	ResourceNode parent = m_nodes[index];
+	DWORD first = (DWORD)m_nodes.size();
+	if (parent.directory && parent.depth < maxDepth)
+	{
+		const BYTE* entries = m_data + parent.offset + sizeof(IMAGE_RESOURCE_DIRECTORY);
+		for (DWORD i = 0; i < parent.count; ++i)
+		{
+			IMAGE_RESOURCE_DIRECTORY_ENTRY entry;
+			memcpy(&entry, entries + i * sizeof(entry), sizeof(entry));
+
+			ResourceNode child = {};
+			child.name = entry.Name;
+			child.offset = entry.OffsetToData & ~IMAGE_RESOURCE_DATA_IS_DIRECTORY;
+			child.depth = parent.depth + 1;
+			child.directory = (entry.OffsetToData & IMAGE_RESOURCE_DATA_IS_DIRECTORY) != 0;
+			if (child.directory && !directoryCount(child.offset, child.count))
+				child.count = 0;
+			m_nodes.push_back(child);
+		}
+	}
+
+	m_nodes[index].first = first;
+	m_nodes[index].count = (DWORD)(m_nodes.size() - first);
+	m_nodes[index].expanded = true;
+	return first;
+}
+
+DWORD ResourceTree::find(DWORD parent, DWORD id)
+{
+	DWORD first = children(parent);
+	for (DWORD i = first; i < first + m_nodes[parent].count; ++i)
+	{
+		if (!(m_nodes[i].name & IMAGE_RESOURCE_NAME_IS_STRING) && m_nodes[i].name == id)
+			return i;
+	}
+	return npos;
+}
+
+DWORD ResourceTree::find(DWORD parent, std::string_view name)
+{
+	DWORD first = children(parent);
+	for (DWORD i = first; i < first + m_nodes[parent].count; ++i)
+	{
+		if (!(m_nodes[i].name & IMAGE_RESOURCE_NAME_IS_STRING))
+			continue;
+		std::string text = this->name(i);
+		if (text.size() == name.size() && std::equal(text.begin(), text.end(), name.begin(),
+			[](char a, char b) { return std::toupper((unsigned char)a) == std::toupper((unsigned char)b); }))
+			return i;
+	}
+	return npos;
+}
+
+DWORD ResourceTree::firstData(DWORD index)
+{
+	while (index != npos && m_nodes[index].directory)
+		index = m_nodes[index].count ? children(index) : npos;
+	return index;
+}
+
+bool ResourceTree::dataEntry(DWORD index, IMAGE_RESOURCE_DATA_ENTRY& entry) const
+{
+	const ResourceNode& node = m_nodes[index];
+	if (node.directory || node.offset > m_size || m_size - node.offset < sizeof(entry))
+		return false;
+	memcpy(&entry, m_data + node.offset, sizeof(entry));
+	return true;
+}
+
+std::string ResourceTree::name(DWORD index) const
+{
+	DWORD name = m_nodes[index].name;
+	if (!(name & IMAGE_RESOURCE_NAME_IS_STRING))
+		return "#" + std::to_string(name & 0xFFFF);
+
+	// IMAGE_RESOURCE_DIR_STRING_U : length in characters, then UTF-16 without a terminator
+	DWORD offset = name & ~IMAGE_RESOURCE_NAME_IS_STRING;
+	if (offset > m_size || m_size - offset < sizeof(WORD))
+		return std::string();
+	size_t chars = load16(m_data + offset);
+	chars = (std::min)(chars, (m_size - offset - sizeof(WORD)) / 2);
+	return Utf16To8(m_data + offset + sizeof(WORD), chars);
+}
+
+const char* ResourceTree::TypeName(DWORD id)
+{
+	static const char* const names[] = {
+		nullptr, "CURSOR", "BITMAP", "ICON", "MENU", "DIALOG", "STRING", "FONTDIR", "FONT",
+		"ACCELERATOR", "RCDATA", "MESSAGETABLE", "GROUP_CURSOR", nullptr, "GROUP_ICON", nullptr,
+		"VERSION", "DLGINCLUDE", nullptr, "PLUGPLAY", "VXD", "ANICURSOR", "ANIICON", "HTML", "MANIFEST"
+	};
+	return id < sizeof(names) / sizeof(names[0]) ? names[id] : nullptr;
+}
+
+std::string ResourceTree::Utf16To8(const BYTE* text, size_t chars)
+{
+	std::string out;
+	out.reserve(chars);
+	for (size_t i = 0; i < chars; ++i)
+	{
+		DWORD c = load16(text + i * 2);
+		if (c >= 0xD800 && c < 0xDC00 && i + 1 < chars)
+		{
+			DWORD low = load16(text + (i + 1) * 2);
+			if (low >= 0xDC00 && low < 0xE000)
+			{
+				c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+				++i;
+			}
+		}
+
+		if (c < 0x80)
+			out += (char)c;
+		else if (c < 0x800)
+		{
+			out += (char)(0xC0 | (c >> 6));
+			out += (char)(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			out += (char)(0xE0 | (c >> 12));
+			out += (char)(0x80 | ((c >> 6) & 0x3F));
+			out += (char)(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			out += (char)(0xF0 | (c >> 18));
+			out += (char)(0x80 | ((c >> 12) & 0x3F));
+			out += (char)(0x80 | ((c >> 6) & 0x3F));
+			out += (char)(0x80 | (c & 0x3F));
+		}
+	}
+	return out;
+}
+
+/*
+| one block of VS_VERSIONINFO : wLength, wValueLength,     |
+| wType, a NUL terminated UTF-16 key, the value and the    |
+| children, each aligned to 4 bytes.                       |
+*/
+struct VersionBlock {
+	size_t end;
+	size_t value;
+	size_t valueBytes;
+	size_t children;
+	WORD type;
+	std::string key;
+};
+
+static bool readVersionBlock(const BYTE* data, size_t limit, size_t pos, VersionBlock& block)
+{
+	if (pos + 6 > limit)
+		return false;
+	WORD length = load16(data + pos);
+	if (length < 6 || pos + length > limit)
+		return false;
+	block.end = pos + length;
+	block.type = load16(data + pos + 4);
+
+	size_t key = pos + 6;
+	size_t chars = 0;
+	while (key + chars * 2 + 2 <= block.end && load16(data + key + chars * 2) != 0)
+		chars++;
+	block.key = ResourceTree::Utf16To8(data + key, chars);
+
+	// text values count characters, binary values count bytes
+	WORD valueLength = load16(data + pos + 2);
+	block.value = (std::min)(align4(key + chars * 2 + 2), block.end);
+	block.valueBytes = (std::min)((size_t)valueLength * (block.type == 1 ? 2 : 1), block.end - block.value);
+	block.children = (std::min)(align4(block.value + block.valueBytes), block.end);
+	return true;
+}
+
+template <typename Visit>
+static void forEachVersionChild(const BYTE* data, const VersionBlock& parent, Visit visit)
+{
+	VersionBlock child;
+	for (size_t pos = parent.children; readVersionBlock(data, parent.end, pos, child); pos = align4(child.end))
+		visit(child);
+}
+
+bool ResourceTree::ParseVersionInfo(const BYTE* data, size_t size, VersionInfo& info)
+{
+	info = VersionInfo();
+
+	VersionBlock root;
+	if (!readVersionBlock(data, size, 0, root) || root.key != "VS_VERSION_INFO")
+		return false;
+
+	if (root.valueBytes >= sizeof(VS_FIXEDFILEINFO))
+	{
+		memcpy(&info.fixed, data + root.value, sizeof(VS_FIXEDFILEINFO));
+		info.hasFixed = info.fixed.dwSignature == 0xFEEF04BD;
+	}
+
+	forEachVersionChild(data, root, [&](const VersionBlock& group) {
+		if (group.key == "StringFileInfo")
+		{
+			forEachVersionChild(data, group, [&](const VersionBlock& table) {
+				forEachVersionChild(data, table, [&](const VersionBlock& string) {
+					// some linkers count bytes instead of characters, the value ends at its NUL either way
+					size_t chars = 0;
+					size_t limit = string.end - string.value;
+					while (chars * 2 + 2 <= limit && load16(data + string.value + chars * 2) != 0)
+						chars++;
+					info.strings.emplace_back(string.key, Utf16To8(data + string.value, chars));
+				});
+			});
+		}
+		else if (group.key == "VarFileInfo")
+		{
+			forEachVersionChild(data, group, [&](const VersionBlock& var) {
+				if (var.key != "Translation")
+					return;
+				for (size_t i = 0; i + 4 <= var.valueBytes; i += 4)
+					info.translations.push_back(load16(data + var.value + i) | ((DWORD)load16(data + var.value + i + 2) << 16));
+			});
+		}
+	});
+	return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <Windows.h>
+
+/*
+| one entry of the resource tree.                          |
+| depth 1 is the type, 2 the name and 3 the language.      |
+| a directory's children are read the first time they are  |
+| asked for and stored next to each other in the tree.     |
+*/
+struct ResourceNode {
+	DWORD name;			// id, or string offset | IMAGE_RESOURCE_NAME_IS_STRING
+	DWORD offset;		// directory or IMAGE_RESOURCE_DATA_ENTRY, from the start of the resource directory
+	DWORD first;		// index of the first child once expanded
+	DWORD count;		// named + id entries of a directory, the sum can pass 0xFFFF
+	BYTE depth;
+	bool directory;
+	bool expanded;
+};
+
+struct VersionInfo {
+	VS_FIXEDFILEINFO fixed;
+	bool hasFixed = false;
+	std::vector<std::pair<std::string, std::string>> strings;		// StringFileInfo key / value, UTF-8
+	std::vector<DWORD> translations;								// language | code page << 16
+};
+
+/*
+| IMAGE_RESOURCE_DIRECTORY tree over the raw bytes of the  |
+| resource directory. open() reads the root only, every   |
+| other level costs nothing until children() walks into   |
+| it, so ten thousand icons are never touched by a lookup  |
+| of the version resource.                                 |
+| children() appends to the node array, indices stay valid |
+| but references into it do not.                           |
+*/
+class ResourceTree
+{
+public:
+	static constexpr DWORD npos = 0xFFFFFFFF;
+	static constexpr BYTE maxDepth = 8;		// loops in a broken tree end here
+
+public:
+	void clear();
+	bool open(const BYTE* data, size_t size);
+	bool isOpen() const { return !m_nodes.empty(); }
+
+	const ResourceNode& node(DWORD index) const { return m_nodes[index]; }
+	DWORD children(DWORD index);		// first child, the children are [first, first + count)
+	DWORD find(DWORD parent, DWORD id);
+	DWORD find(DWORD parent, std::string_view name);		// case insensitive
+	DWORD firstData(DWORD index);		// first data entry below index
+	bool dataEntry(DWORD index, IMAGE_RESOURCE_DATA_ENTRY& entry) const;
+	std::string name(DWORD index) const;		// UTF-8 name or "#id"
+
+	size_t materialized() const { return m_nodes.size(); }
+
+	static const char* TypeName(DWORD id);
+	static std::string Utf16To8(const BYTE* text, size_t chars);
+	static bool ParseVersionInfo(const BYTE* data, size_t size, VersionInfo& info);
+
+private:
+	bool directoryCount(DWORD offset, DWORD& count) const;
+
+private:
+	const BYTE* m_data = nullptr;
+	size_t m_size = 0;
+	std::vector<ResourceNode> m_nodes;
+};
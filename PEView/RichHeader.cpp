@@ -0,0 +1,254 @@
+#include "RichHeader.h"
+#include <cstring>
+#include <iterator>
+#include <intrin.h>
+#include <immintrin.h>
+
+enum ToolsetId : BYTE {
+	toolsetNone, toolsetVC5, toolsetVC6, toolsetVB6, toolsetVS2002, toolsetVS2003, toolsetVS2005,
+	toolsetVS2008, toolsetVS2010, toolsetVS2012, toolsetVS2013, toolsetVS2015
+};
+
+static const char* const toolsetNames[] = {
+	"", "VC5", "VC6", "VB6", "VS2002", "VS2003", "VS2005", "VS2008", "VS2010", "VS2012", "VS2013", "VS2015"
+};
+
+struct Product {
+	const char* name;
+	ToolsetId toolset;
+};
+
+// indexed by the @comp.id product, 0x0000 ~ 0x010E; VS2015 and every release since use the 14.x ids
+static const Product products[] = {
+	{ "Unknown", toolsetNone }, { "Import0", toolsetNone }, { "Linker510", toolsetVC5 }, { "Cvtomf510", toolsetVC5 },
+	{ "Linker600", toolsetVC6 }, { "Cvtomf600", toolsetVC6 }, { "Cvtres500", toolsetVC5 }, { "Utc11_Basic", toolsetVC5 },
+	{ "Utc11_C", toolsetVC5 }, { "Utc12_Basic", toolsetVC6 }, { "Utc12_C", toolsetVC6 }, { "Utc12_CPP", toolsetVC6 },
+	{ "AliasObj60", toolsetVC5 }, { "VisualBasic60", toolsetVB6 }, { "Masm613", toolsetVC6 }, { "Masm710", toolsetVS2003 },
+	{ "Linker511", toolsetVC5 }, { "Cvtomf511", toolsetVC5 }, { "Masm614", toolsetVC6 }, { "Linker512", toolsetVC5 },
+	{ "Cvtomf512", toolsetVC5 }, { "Utc12_C_Std", toolsetVC6 }, { "Utc12_CPP_Std", toolsetVC6 }, { "Utc12_C_Book", toolsetVC6 },
+	{ "Utc12_CPP_Book", toolsetVC6 }, { "Implib700", toolsetVS2002 }, { "Cvtomf700", toolsetVS2002 }, { "Utc13_Basic", toolsetVS2002 },
+	{ "Utc13_C", toolsetVS2002 }, { "Utc13_CPP", toolsetVS2002 }, { "Linker610", toolsetVC6 }, { "Cvtomf610", toolsetVC6 },
+	{ "Linker601", toolsetVC6 }, { "Cvtomf601", toolsetVC6 }, { "Utc12_1_Basic", toolsetVC6 }, { "Utc12_1_C", toolsetVC6 },
+	{ "Utc12_1_CPP", toolsetVC6 }, { "Linker620", toolsetVC6 }, { "Cvtomf620", toolsetVC6 }, { "AliasObj70", toolsetVC5 },
+	{ "Linker621", toolsetVC6 }, { "Cvtomf621", toolsetVC6 }, { "Masm615", toolsetVC6 }, { "Utc13_LTCG_C", toolsetVS2002 },
+	{ "Utc13_LTCG_CPP", toolsetVS2002 }, { "Masm620", toolsetVC6 }, { "ILAsm100", toolsetVS2002 }, { "Utc12_2_Basic", toolsetVC6 },
+	{ "Utc12_2_C", toolsetVC6 }, { "Utc12_2_CPP", toolsetVC6 }, { "Utc12_2_C_Std", toolsetVC6 }, { "Utc12_2_CPP_Std", toolsetVC6 },
+	{ "Utc12_2_C_Book", toolsetVC6 }, { "Utc12_2_CPP_Book", toolsetVC6 }, { "Implib622", toolsetVC6 }, { "Cvtomf622", toolsetVC6 },
+	{ "Cvtres501", toolsetVC5 }, { "Utc13_C_Std", toolsetVS2002 }, { "Utc13_CPP_Std", toolsetVS2002 }, { "Cvtpgd1300", toolsetVS2002 },
+	{ "Linker622", toolsetVC6 }, { "Linker700", toolsetVS2002 }, { "Export622", toolsetVC6 }, { "Export700", toolsetVS2002 },
+	{ "Masm700", toolsetVS2002 }, { "Utc13_POGO_I_C", toolsetVS2002 }, { "Utc13_POGO_I_CPP", toolsetVS2002 }, { "Utc13_POGO_O_C", toolsetVS2002 },
+	{ "Utc13_POGO_O_CPP", toolsetVS2002 }, { "Cvtres700", toolsetVS2002 }, { "Cvtres710p", toolsetVS2003 }, { "Linker710p", toolsetVS2003 },
+	{ "Cvtomf710p", toolsetVS2003 }, { "Export710p", toolsetVS2003 }, { "Implib710p", toolsetVS2003 }, { "Masm710p", toolsetVS2003 },
+	{ "Utc1310p_C", toolsetVS2003 }, { "Utc1310p_CPP", toolsetVS2003 }, { "Utc1310p_C_Std", toolsetVS2003 }, { "Utc1310p_CPP_Std", toolsetVS2003 },
+	{ "Utc1310p_LTCG_C", toolsetVS2003 }, { "Utc1310p_LTCG_CPP", toolsetVS2003 }, { "Utc1310p_POGO_I_C", toolsetVS2003 }, { "Utc1310p_POGO_I_CPP", toolsetVS2003 },
+	{ "Utc1310p_POGO_O_C", toolsetVS2003 }, { "Utc1310p_POGO_O_CPP", toolsetVS2003 }, { "Linker624", toolsetVC6 }, { "Cvtomf624", toolsetVC6 },
+	{ "Export624", toolsetVC6 }, { "Implib624", toolsetVC6 }, { "Linker710", toolsetVS2003 }, { "Cvtomf710", toolsetVS2003 },
+	{ "Export710", toolsetVS2003 }, { "Implib710", toolsetVS2003 }, { "Cvtres710", toolsetVS2003 }, { "Utc1310_C", toolsetVS2003 },
+	{ "Utc1310_CPP", toolsetVS2003 }, { "Utc1310_C_Std", toolsetVS2003 }, { "Utc1310_CPP_Std", toolsetVS2003 }, { "Utc1310_LTCG_C", toolsetVS2003 },
+	{ "Utc1310_LTCG_CPP", toolsetVS2003 }, { "Utc1310_POGO_I_C", toolsetVS2003 }, { "Utc1310_POGO_I_CPP", toolsetVS2003 }, { "Utc1310_POGO_O_C", toolsetVS2003 },
+	{ "Utc1310_POGO_O_CPP", toolsetVS2003 }, { "AliasObj710", toolsetVS2003 }, { "AliasObj710p", toolsetVS2003 }, { "Cvtpgd1310", toolsetVS2003 },
+	{ "Cvtpgd1310p", toolsetVS2003 }, { "Utc1400_C", toolsetVS2005 }, { "Utc1400_CPP", toolsetVS2005 }, { "Utc1400_C_Std", toolsetVS2005 },
+	{ "Utc1400_CPP_Std", toolsetVS2005 }, { "Utc1400_LTCG_C", toolsetVS2005 }, { "Utc1400_LTCG_CPP", toolsetVS2005 }, { "Utc1400_POGO_I_C", toolsetVS2005 },
+	{ "Utc1400_POGO_I_CPP", toolsetVS2005 }, { "Utc1400_POGO_O_C", toolsetVS2005 }, { "Utc1400_POGO_O_CPP", toolsetVS2005 }, { "Cvtpgd1400", toolsetVS2005 },
+	{ "Linker800", toolsetVS2005 }, { "Cvtomf800", toolsetVS2005 }, { "Export800", toolsetVS2005 }, { "Implib800", toolsetVS2005 },
+	{ "Cvtres800", toolsetVS2005 }, { "Masm800", toolsetVS2005 }, { "AliasObj800", toolsetVS2005 }, { "PhoenixPrerelease", toolsetNone },
+	{ "Utc1400_CVTCIL_C", toolsetVS2005 }, { "Utc1400_CVTCIL_CPP", toolsetVS2005 }, { "Utc1400_LTCG_MSIL", toolsetVS2005 }, { "Utc1500_C", toolsetVS2008 },
+	{ "Utc1500_CPP", toolsetVS2008 }, { "Utc1500_C_Std", toolsetVS2008 }, { "Utc1500_CPP_Std", toolsetVS2008 }, { "Utc1500_CVTCIL_C", toolsetVS2008 },
+	{ "Utc1500_CVTCIL_CPP", toolsetVS2008 }, { "Utc1500_LTCG_C", toolsetVS2008 }, { "Utc1500_LTCG_CPP", toolsetVS2008 }, { "Utc1500_LTCG_MSIL", toolsetVS2008 },
+	{ "Utc1500_POGO_I_C", toolsetVS2008 }, { "Utc1500_POGO_I_CPP", toolsetVS2008 }, { "Utc1500_POGO_O_C", toolsetVS2008 }, { "Utc1500_POGO_O_CPP", toolsetVS2008 },
+	{ "Cvtpgd1500", toolsetVS2008 }, { "Linker900", toolsetVS2008 }, { "Export900", toolsetVS2008 }, { "Implib900", toolsetVS2008 },
+	{ "Cvtres900", toolsetVS2008 }, { "Masm900", toolsetVS2008 }, { "AliasObj900", toolsetVS2008 }, { "Resource", toolsetNone },
+	{ "AliasObj1000", toolsetVS2010 }, { "Cvtpgd1600", toolsetVS2010 }, { "Cvtres1000", toolsetVS2010 }, { "Export1000", toolsetVS2010 },
+	{ "Implib1000", toolsetVS2010 }, { "Linker1000", toolsetVS2010 }, { "Masm1000", toolsetVS2010 }, { "Phx1600_C", toolsetVS2010 },
+	{ "Phx1600_CPP", toolsetVS2010 }, { "Phx1600_CVTCIL_C", toolsetVS2010 }, { "Phx1600_CVTCIL_CPP", toolsetVS2010 }, { "Phx1600_LTCG_C", toolsetVS2010 },
+	{ "Phx1600_LTCG_CPP", toolsetVS2010 }, { "Phx1600_LTCG_MSIL", toolsetVS2010 }, { "Phx1600_POGO_I_C", toolsetVS2010 }, { "Phx1600_POGO_I_CPP", toolsetVS2010 },
+	{ "Phx1600_POGO_O_C", toolsetVS2010 }, { "Phx1600_POGO_O_CPP", toolsetVS2010 }, { "Utc1600_C", toolsetVS2010 }, { "Utc1600_CPP", toolsetVS2010 },
+	{ "Utc1600_CVTCIL_C", toolsetVS2010 }, { "Utc1600_CVTCIL_CPP", toolsetVS2010 }, { "Utc1600_LTCG_C", toolsetVS2010 }, { "Utc1600_LTCG_CPP", toolsetVS2010 },
+	{ "Utc1600_LTCG_MSIL", toolsetVS2010 }, { "Utc1600_POGO_I_C", toolsetVS2010 }, { "Utc1600_POGO_I_CPP", toolsetVS2010 }, { "Utc1600_POGO_O_C", toolsetVS2010 },
+	{ "Utc1600_POGO_O_CPP", toolsetVS2010 }, { "AliasObj1010", toolsetVS2010 }, { "Cvtpgd1610", toolsetVS2010 }, { "Cvtres1010", toolsetVS2010 },
+	{ "Export1010", toolsetVS2010 }, { "Implib1010", toolsetVS2010 }, { "Linker1010", toolsetVS2010 }, { "Masm1010", toolsetVS2010 },
+	{ "Utc1610_C", toolsetVS2010 }, { "Utc1610_CPP", toolsetVS2010 }, { "Utc1610_CVTCIL_C", toolsetVS2010 }, { "Utc1610_CVTCIL_CPP", toolsetVS2010 },
+	{ "Utc1610_LTCG_C", toolsetVS2010 }, { "Utc1610_LTCG_CPP", toolsetVS2010 }, { "Utc1610_LTCG_MSIL", toolsetVS2010 }, { "Utc1610_POGO_I_C", toolsetVS2010 },
+	{ "Utc1610_POGO_I_CPP", toolsetVS2010 }, { "Utc1610_POGO_O_C", toolsetVS2010 }, { "Utc1610_POGO_O_CPP", toolsetVS2010 }, { "AliasObj1100", toolsetVS2012 },
+	{ "Cvtpgd1700", toolsetVS2012 }, { "Cvtres1100", toolsetVS2012 }, { "Export1100", toolsetVS2012 }, { "Implib1100", toolsetVS2012 },
+	{ "Linker1100", toolsetVS2012 }, { "Masm1100", toolsetVS2012 }, { "Utc1700_C", toolsetVS2012 }, { "Utc1700_CPP", toolsetVS2012 },
+	{ "Utc1700_CVTCIL_C", toolsetVS2012 }, { "Utc1700_CVTCIL_CPP", toolsetVS2012 }, { "Utc1700_LTCG_C", toolsetVS2012 }, { "Utc1700_LTCG_CPP", toolsetVS2012 },
+	{ "Utc1700_LTCG_MSIL", toolsetVS2012 }, { "Utc1700_POGO_I_C", toolsetVS2012 }, { "Utc1700_POGO_I_CPP", toolsetVS2012 }, { "Utc1700_POGO_O_C", toolsetVS2012 },
+	{ "Utc1700_POGO_O_CPP", toolsetVS2012 }, { "AliasObj1200", toolsetVS2013 }, { "Cvtpgd1800", toolsetVS2013 }, { "Cvtres1200", toolsetVS2013 },
+	{ "Export1200", toolsetVS2013 }, { "Implib1200", toolsetVS2013 }, { "Linker1200", toolsetVS2013 }, { "Masm1200", toolsetVS2013 },
+	{ "Utc1800_C", toolsetVS2013 }, { "Utc1800_CPP", toolsetVS2013 }, { "Utc1800_CVTCIL_C", toolsetVS2013 }, { "Utc1800_CVTCIL_CPP", toolsetVS2013 },
+	{ "Utc1800_LTCG_C", toolsetVS2013 }, { "Utc1800_LTCG_CPP", toolsetVS2013 }, { "Utc1800_LTCG_MSIL", toolsetVS2013 }, { "Utc1800_POGO_I_C", toolsetVS2013 },
+	{ "Utc1800_POGO_I_CPP", toolsetVS2013 }, { "Utc1800_POGO_O_C", toolsetVS2013 }, { "Utc1800_POGO_O_CPP", toolsetVS2013 }, { "AliasObj1210", toolsetVS2013 },
+	{ "Cvtpgd1810", toolsetVS2013 }, { "Cvtres1210", toolsetVS2013 }, { "Export1210", toolsetVS2013 }, { "Implib1210", toolsetVS2013 },
+	{ "Linker1210", toolsetVS2013 }, { "Masm1210", toolsetVS2013 }, { "Utc1810_C", toolsetVS2013 }, { "Utc1810_CPP", toolsetVS2013 },
+	{ "Utc1810_CVTCIL_C", toolsetVS2013 }, { "Utc1810_CVTCIL_CPP", toolsetVS2013 }, { "Utc1810_LTCG_C", toolsetVS2013 }, { "Utc1810_LTCG_CPP", toolsetVS2013 },
+	{ "Utc1810_LTCG_MSIL", toolsetVS2013 }, { "Utc1810_POGO_I_C", toolsetVS2013 }, { "Utc1810_POGO_I_CPP", toolsetVS2013 }, { "Utc1810_POGO_O_C", toolsetVS2013 },
+	{ "Utc1810_POGO_O_CPP", toolsetVS2013 }, { "AliasObj1400", toolsetVS2015 }, { "Cvtpgd1900", toolsetVS2015 }, { "Cvtres1400", toolsetVS2015 },
+	{ "Export1400", toolsetVS2015 }, { "Implib1400", toolsetVS2015 }, { "Linker1400", toolsetVS2015 }, { "Masm1400", toolsetVS2015 },
+	{ "Utc1900_C", toolsetVS2015 }, { "Utc1900_CPP", toolsetVS2015 }, { "Utc1900_CVTCIL_C", toolsetVS2015 }, { "Utc1900_CVTCIL_CPP", toolsetVS2015 },
+	{ "Utc1900_LTCG_C", toolsetVS2015 }, { "Utc1900_LTCG_CPP", toolsetVS2015 }, { "Utc1900_LTCG_MSIL", toolsetVS2015 }, { "Utc1900_POGO_I_C", toolsetVS2015 },
+	{ "Utc1900_POGO_I_CPP", toolsetVS2015 }, { "Utc1900_POGO_O_C", toolsetVS2015 }, { "Utc1900_POGO_O_CPP", toolsetVS2015 },
+};
+
+// first build of the releases sharing the 14.x products
+static const struct {
+	WORD build;
+	const char* name;
+} releases14[] = {
+	{ 25000, "VS2015" },
+	{ 27500, "VS2017" },
+	{ 30400, "VS2019" },
+	{ 0xFFFF, "VS2022" },
+};
+
+static inline DWORD rotl(DWORD value, unsigned int bits)
+{
+	bits &= 31;
+	return (value << bits) | (value >> ((32 - bits) & 31));
+}
+
+void RichHeader::clear()
+{
+	m_entries.clear();
+	m_decoded.clear();
+	m_offset = m_key = m_checksum = 0;
+	m_present = false;
+}
+
+bool RichHeader::parse(const IMAGE_DOS_HEADER& dosHeader, const BYTE* stub, size_t size)
+{
+	static const XorKernel kernel = selectKernel();
+
+	clear();
+
+	// the stub starts at 0x40, so its DWORDs are aligned in the file too
+	size_t rich = npos;
+	for (size_t pos = 0; pos + 2 * sizeof(DWORD) <= size; pos += sizeof(DWORD))
+	{
+		DWORD value;
+		memcpy(&value, stub + pos, sizeof(DWORD));
+		if (value == richMarker)
+		{
+			rich = pos;
+			break;
+		}
+	}
+	if (rich == npos)
+		return false;
+
+	DWORD key;
+	memcpy(&key, stub + rich + sizeof(DWORD), sizeof(DWORD));
+	m_decoded.resize(rich);
+	kernel(stub, m_decoded.data(), rich, key);
+
+	// DanS is the last one before Rich, the DOS code in front of it decodes to noise
+	size_t dans = npos;
+	for (size_t pos = rich; pos >= sizeof(DWORD); )
+	{
+		pos -= sizeof(DWORD);
+		DWORD value;
+		memcpy(&value, m_decoded.data() + pos, sizeof(DWORD));
+		if (value == dansMarker)
+		{
+			dans = pos;
+			break;
+		}
+	}
+	if (dans == npos || rich - dans < 4 * sizeof(DWORD))
+	{
+		m_decoded.clear();
+		return false;
+	}
+	m_decoded.erase(m_decoded.begin(), m_decoded.begin() + dans);
+
+	m_offset = (DWORD)(sizeof(IMAGE_DOS_HEADER) + dans);
+	m_key = key;
+	m_present = true;
+
+	// the three padding DWORDs, then @comp.id / count pairs
+	for (size_t pos = 4 * sizeof(DWORD); pos + 2 * sizeof(DWORD) <= m_decoded.size(); pos += 2 * sizeof(DWORD))
+	{
+		DWORD id;
+		RichEntry entry;
+		memcpy(&id, m_decoded.data() + pos, sizeof(DWORD));
+		memcpy(&entry.count, m_decoded.data() + pos + sizeof(DWORD), sizeof(DWORD));
+		entry.product = (WORD)(id >> 16);
+		entry.build = (WORD)id;
+		m_entries.push_back(entry);
+	}
+
+	// every byte in front of DanS rotated by its offset, e_lfanew left out, then every entry by its count
+	const BYTE* dos = reinterpret_cast<const BYTE*>(&dosHeader);
+	const DWORD lfanew = offsetof(IMAGE_DOS_HEADER, e_lfanew);
+	m_checksum = m_offset;
+	for (DWORD i = 0; i < m_offset; ++i)
+	{
+		if (i >= lfanew && i < lfanew + sizeof(LONG))
+			continue;
+		BYTE b = i < sizeof(IMAGE_DOS_HEADER) ? dos[i] : stub[i - sizeof(IMAGE_DOS_HEADER)];
+		m_checksum += rotl(b, i);
+	}
+	for (const RichEntry& entry : m_entries)
+		m_checksum += rotl((DWORD)entry.product << 16 | entry.build, entry.count);
+
+	return true;
+}
+
+size_t RichHeader::linker() const
+{
+	for (size_t i = 0; i < m_entries.size(); ++i)
+	{
+		const char* name = ProductName(m_entries[i].product);
+		if (name && strncmp(name, "Linker", 6) == 0)
+			return i;
+	}
+	return npos;
+}
+
+const char* RichHeader::ProductName(WORD product)
+{
+	return product < std::size(products) ? products[product].name : nullptr;
+}
+
+const char* RichHeader::Toolset(WORD product, WORD build)
+{
+	if (product >= std::size(products))
+		return "";
+
+	ToolsetId toolset = products[product].toolset;
+	if (toolset != toolsetVS2015)
+		return toolsetNames[toolset];
+
+	size_t i = 0;
+	while (i + 1 < std::size(releases14) && build >= releases14[i].build)
+		++i;
+	return releases14[i].name;
+}
+
+RichHeader::XorKernel RichHeader::selectKernel()
+{
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) ? xorSSE2 : xorScalar;
+}
+
+void RichHeader::xorScalar(const BYTE* src, BYTE* dst, size_t size, DWORD key)
+{
+	for (size_t i = 0; i + sizeof(DWORD) <= size; i += sizeof(DWORD))
+	{
+		DWORD value;
+		memcpy(&value, src + i, sizeof(DWORD));
+		value ^= key;
+		memcpy(dst + i, &value, sizeof(DWORD));
+	}
+}
+
+// size is a multiple of 4, the last few DWORDs go through the scalar loop
+void RichHeader::xorSSE2(const BYTE* src, BYTE* dst, size_t size, DWORD key)
+{
+	const __m128i k = _mm_set1_epi32((int)key);
+	size_t i = 0;
+	for (; i + 16 <= size; i += 16)
+		_mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + i)), k));
+	xorScalar(src + i, dst + i, size - i, key);
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <Windows.h>
+
+/*
+| product	2byte	|	@comp.id high word, the tool		|
+| build		2byte	|	@comp.id low word					|
+| count		4byte	|	objects the tool produced			|
+*/
+struct RichEntry {
+	WORD product;
+	WORD build;
+	DWORD count;
+};
+
+/*
+| the Rich header the MSVC linker leaves between the DOS   |
+| stub code and the NT headers : "DanS", three zero DWORDs  |
+| and a @comp.id / count pair per tool, all XORed with the  |
+| key that follows the plain "Rich" marker. the key is also |
+| a checksum over the DOS header, the stub up to DanS and   |
+| the entries, so an edited header no longer matches it.    |
+| the whole header is decoded in one vector XOR pass        |
+| (SSE2, picked once with cpuid), it is at most a few       |
+| hundred bytes, so wider vectors would not pay off.        |
+*/
+class RichHeader
+{
+public:
+	static constexpr DWORD dansMarker = 0x536E6144;		// "DanS"
+	static constexpr DWORD richMarker = 0x68636952;		// "Rich"
+	static constexpr size_t npos = (size_t)-1;
+
+public:
+	void clear();
+	// stub : the bytes between the DOS header and e_lfanew
+	bool parse(const IMAGE_DOS_HEADER& dosHeader, const BYTE* stub, size_t size);
+
+	bool present() const { return m_present; }
+	DWORD offset() const { return m_offset; }			// file offset of DanS
+	DWORD key() const { return m_key; }
+	DWORD checksum() const { return m_checksum; }		// computed, valid when it equals the key
+	bool valid() const { return m_present && m_checksum == m_key; }
+	const std::vector<RichEntry>& entries() const { return m_entries; }
+	const std::vector<BYTE>& decoded() const { return m_decoded; }		// DanS up to the Rich marker
+	size_t linker() const;		// the entry of the linker, npos if none
+
+	// Utc1900_CPP, Linker1400, ... nullptr for products newer than the table
+	static const char* ProductName(WORD product);
+	// VS2008, VS2019, ... the build tells the releases sharing the 14.x products apart, "" if unknown
+	static const char* Toolset(WORD product, WORD build);
+
+public:
+	typedef void (*XorKernel)(const BYTE* src, BYTE* dst, size_t size, DWORD key);
+
+private:
+	static XorKernel selectKernel();
+	static void xorScalar(const BYTE* src, BYTE* dst, size_t size, DWORD key);
+	static void xorSSE2(const BYTE* src, BYTE* dst, size_t size, DWORD key);
+
+private:
+	std::vector<RichEntry> m_entries;
+	std::vector<BYTE> m_decoded;
+	DWORD m_offset = 0;
+	DWORD m_key = 0;
+	DWORD m_checksum = 0;
+	bool m_present = false;
+};
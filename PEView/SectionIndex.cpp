@@ -0,0 +1,95 @@
+#include "SectionIndex.h"
+#include <algorithm>
+
+void SectionIndex::build(const std::vector<IMAGE_SECTION_HEADER>& headers, DWORD sizeOfHeaders)
+{
+	m_ranges.clear();
+	m_ranges.reserve(headers.size() + 1);
+	m_lastHit = 0;
+
+	// the headers are mapped at RVA 0 with offset == RVA
+	if (sizeOfHeaders)
+		m_ranges.push_back({ 0, sizeOfHeaders, sizeOfHeaders, 0, -1 });
+
+	for (int i = 0; i < (int)headers.size(); ++i)
+	{
+		const IMAGE_SECTION_HEADER& sh = headers[i];
+		DWORD virtualSize = sh.Misc.VirtualSize ? sh.Misc.VirtualSize : sh.SizeOfRawData;
+		if (!virtualSize)
+			continue;
+
+		Range range;
+		range.begin = sh.VirtualAddress;
+		range.end = sh.VirtualAddress + virtualSize;
+		range.rawEnd = sh.VirtualAddress + (std::min)(sh.SizeOfRawData, virtualSize);
+		range.raw = sh.PointerToRawData;
+		range.section = i;
+		if (range.end < range.begin)	// wraps past 4GB
+			range.end = npos;
+		if (range.rawEnd < range.begin)
+			range.rawEnd = range.end;
+		m_ranges.push_back(range);
+	}
+
+	std::stable_sort(m_ranges.begin(), m_ranges.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+	// sections win over the header range when they overlap it
+	if (m_ranges.size() > 1 && m_ranges[0].section == -1 && m_ranges[1].begin < m_ranges[0].end)
+	{
+		m_ranges[0].end = m_ranges[1].begin;
+		m_ranges[0].rawEnd = (std::min)(m_ranges[0].rawEnd, m_ranges[0].end);
+	}
+}
+
+const SectionIndex::Range* SectionIndex::find(DWORD rva) const
+{
+	if (m_ranges.empty())
+		return nullptr;
+
+	const Range& last = m_ranges[m_lastHit];
+	if (rva >= last.begin && rva < last.end)
+		return &last;
+
+	auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), rva, [](DWORD value, const Range& r) { return value < r.begin; });
+	if (it == m_ranges.begin())
+		return nullptr;
+	--it;
+	if (rva >= it->end)
+		return nullptr;
+
+	m_lastHit = it - m_ranges.begin();
+	return &*it;
+}
+
+bool SectionIndex::translate(DWORD rva, DWORD& offset) const
+{
+	const Range* range = find(rva);
+	if (!range || rva >= range->rawEnd)
+	{
+		offset = npos;
+		return false;
+	}
+
+	offset = rva - range->begin + range->raw;
+	return true;
+}
+
+size_t SectionIndex::translate(const DWORD* rvas, DWORD* offsets, size_t count) const
+{
+	size_t hits = 0;
+	for (size_t i = 0; i < count; ++i)
+		hits += translate(rvas[i], offsets[i]);
+	return hits;
+}
+
+DWORD SectionIndex::extent(DWORD rva) const
+{
+	const Range* range = find(rva);
+	return range && rva < range->rawEnd ? range->rawEnd - rva : 0;
+}
+
+int SectionIndex::sectionOf(DWORD rva) const
+{
+	const Range* range = find(rva);
+	return range ? range->section : -1;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <Windows.h>
+
+/*
+| RVA -> file offset translation.                        |
+| sections are kept sorted by VirtualAddress and looked  |
+| up with a binary search; the last hit is cached since  |
+| thunk and name walks stay inside one section.          |
+| an RVA that is not backed by file data is a miss.      |
+*/
+class SectionIndex
+{
+public:
+	static constexpr DWORD npos = 0xFFFFFFFF;
+
+	struct Range {
+		DWORD begin;		// VirtualAddress
+		DWORD end;			// VirtualAddress + VirtualSize
+		DWORD rawEnd;		// VirtualAddress + SizeOfRawData
+		DWORD raw;			// PointerToRawData
+		int section;		// index in the section header table, -1 for the headers
+	};
+
+public:
+	void build(const std::vector<IMAGE_SECTION_HEADER>& headers, DWORD sizeOfHeaders);
+
+	bool translate(DWORD rva, DWORD& offset) const;
+	size_t translate(const DWORD* rvas, DWORD* offsets, size_t count) const;
+	// bytes of file data from rva to the end of its section, 0 for a miss
+	DWORD extent(DWORD rva) const;
+	int sectionOf(DWORD rva) const;
+
+private:
+	const Range* find(DWORD rva) const;
+
+private:
+	std::vector<Range> m_ranges;
+	mutable size_t m_lastHit = 0;
+};
@@ -0,0 +1,398 @@
+#include "SignatureSet.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <intrin.h>
+#include <immintrin.h>
+
+// how common each byte value is in PE files, 0 rarest ~ 255 most common (0x00)
+static const BYTE byteRank[256] = {
+	255, 252, 249, 243, 246, 239, 245, 227, 241, 214, 238, 196, 193, 185, 187, 220,
+	234, 225, 230, 209, 181, 247, 176, 143, 190, 186, 141, 156, 153, 189, 161, 127,
+	237, 168, 165, 147, 200, 144, 150,  98, 226, 148, 204, 157, 167, 137, 194, 104,
+	223, 154, 142, 195, 124, 133, 126,  88, 138, 191,  99, 162, 132, 152, 171, 163,
+	207, 242, 122, 184, 197, 213, 130, 114, 254, 233, 109,  91, 224, 178, 118,  93,
+	210,  67, 151, 211, 174, 199, 170, 139, 111, 112,  86, 173, 106, 182, 146, 201,
+	145, 228, 160, 212, 205, 248, 164, 175, 158, 235,  87, 102, 222, 202, 231, 240,
+	217,  50, 236, 232, 244, 221, 117, 107, 134, 198, 128, 208, 121, 206, 103, 108,
+	219, 183, 119, 216, 129, 179, 131,   4,  85, 218,  27, 251,  58, 229,  17,  10,
+	203, 105, 169, 100,  89, 113, 116,  72,  65,  81,  41,  46,  45,  25,  14,   3,
+	135,  73, 136,  80,  74,  94,  57,  60,  75,  78,  37,  42,  62,  34,  11,  16,
+	140,  38,  84,  30,  33,  71,  82,  40, 120,  68,  35,  43,  36,  69,  56,  63,
+	215,  77,  66, 192, 149,  39, 115, 110, 101,  70,   7,  18, 250,  12,   9,   1,
+	177,  32,  61,  64,  55,  23,  24,  13, 125,  44,   5,  28,  26,  15,  53,  76,
+	172,  52,  19,  54,  47,  21,  31,   6, 123,  92,   8,  90,  96,  20,   0,   2,
+	180,  22,  59,  95,  49,  29, 155,  97, 166,  48,  51, 159,  83,  79, 188, 253,
+};
+
+static inline int hexDigit(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	c = (char)toupper((unsigned char)c);
+	return (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+}
+
+bool SignatureSet::load(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		m_error = path + " : cannot open the rule file";
+		return false;
+	}
+	std::ostringstream text;
+	text << file.rdbuf();
+	return parse(text.str());
+}
+
+bool SignatureSet::parse(std::string_view text)
+{
+	m_rules.clear();
+	m_error.clear();
+	m_longest = 0;
+
+	size_t number = 0;
+	while (!text.empty())
+	{
+		size_t end = text.find('\n');
+		std::string_view line = text.substr(0, end);
+		text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+		if (!parseLine(line, ++number))
+			return false;
+	}
+
+	compile();
+	return true;
+}
+
+bool SignatureSet::parseLine(std::string_view line, size_t number)
+{
+	size_t comment = line.find('#');
+	if (comment != std::string_view::npos)
+		line = line.substr(0, comment);
+
+	std::istringstream fields{ std::string(line) };
+	std::string name, scope, word, bytes;
+	if (!(fields >> name))
+		return true;
+	fields >> scope;
+	while (fields >> word)
+		bytes += word;
+
+	auto error = [&](const char* message) {
+		m_error = "line " + std::to_string(number) + " : " + name + " : " + message;
+		return false;
+	};
+	if (bytes.empty())
+		return error("expected <name> <scope> <bytes>");
+	if (bytes.size() % 2)
+		return error("odd number of hex digits");
+
+	SignatureRule rule;
+	rule.name = name;
+	for (size_t i = 0; i < bytes.size(); i += 2)
+	{
+		BYTE value = 0, mask = 0;
+		for (int k = 0; k < 2; ++k)
+		{
+			char c = bytes[i + k];
+			int digit = hexDigit(c);
+			if (c == '?')
+				digit = 0;
+			else if (digit < 0)
+				return error("bad hex digit");
+			else
+				mask |= k ? 0x0F : 0xF0;
+			value |= (BYTE)(digit << (k ? 0 : 4));
+		}
+		rule.value.push_back(value);
+		rule.mask.push_back(mask);
+	}
+
+	std::istringstream scopes(scope);
+	while (std::getline(scopes, word, ','))
+	{
+		if (word == "*")
+			rule.anywhere = true;
+		else if (word == "entry")
+			rule.entry = true;
+		else if (word == "overlay")
+			rule.overlay = true;
+		else if (!word.empty())
+			rule.sections.push_back(word.substr(0, IMAGE_SIZEOF_SHORT_NAME));
+	}
+
+	if (std::find(rule.mask.begin(), rule.mask.end(), 0xFF) == rule.mask.end())
+		return error("no fixed byte to anchor on");
+	chooseAnchor(rule);
+
+	m_longest = (std::max)(m_longest, rule.value.size());
+	m_rules.push_back(std::move(rule));
+	return true;
+}
+
+void SignatureSet::chooseAnchor(SignatureRule& rule)
+{
+	// fixed bytes from every position, at most maxAnchor
+	size_t count = rule.mask.size();
+	std::vector<DWORD> run(count + 1, 0);
+	for (size_t i = count; i-- > 0; )
+		run[i] = rule.mask[i] == 0xFF ? (std::min)(run[i + 1] + 1, (DWORD)maxAnchor) : 0;
+
+	// long enough to be selective, then the rarest first byte
+	DWORD wanted = (std::min)(*std::max_element(run.begin(), run.end()), (DWORD)4);
+	DWORD best = none;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (run[i] < wanted)
+			continue;
+		if (best == none || byteRank[rule.value[i]] < byteRank[rule.value[best]] ||
+			(byteRank[rule.value[i]] == byteRank[rule.value[best]] && run[i] > run[best]))
+			best = (DWORD)i;
+	}
+	rule.anchor = best;
+	rule.anchorLength = run[best];
+}
+
+void SignatureSet::compile()
+{
+	m_states.clear();
+	m_edges.clear();
+	m_outputs.clear();
+	memset(m_root, 0, sizeof(m_root));
+	memset(m_lo, 0, sizeof(m_lo));
+	memset(m_hi, 0, sizeof(m_hi));
+
+	// trie of the anchors, the rules ending in a state are chained in m_outputs
+	std::vector<std::vector<Edge>> children(1);
+	std::vector<DWORD> own(1, none), last(1, none);
+	auto child = [&](DWORD state, BYTE b) {
+		for (const Edge& edge : children[state])
+		{
+			if (edge.byte == b)
+				return edge.target;
+		}
+		return none;
+	};
+
+	for (DWORD r = 0; r < (DWORD)m_rules.size(); ++r)
+	{
+		const SignatureRule& rule = m_rules[r];
+		DWORD state = 0;
+		for (DWORD i = 0; i < rule.anchorLength; ++i)
+		{
+			BYTE b = rule.value[rule.anchor + i];
+			DWORD target = child(state, b);
+			if (target == none)
+			{
+				target = (DWORD)children.size();
+				children[state].push_back({ b, target });
+				children.emplace_back();
+				own.push_back(none);
+				last.push_back(none);
+			}
+			state = target;
+		}
+
+		m_outputs.push_back({ r, none });
+		DWORD output = (DWORD)m_outputs.size() - 1;
+		if (last[state] == none)
+			own[state] = output;
+		else
+			m_outputs[last[state]].next = output;
+		last[state] = output;
+	}
+
+	// failure links breadth first, so a state's failure target is complete before the state
+	m_states.assign(children.size(), { 0, none, 0, 0 });
+	std::vector<DWORD> queue;
+	for (const Edge& edge : children[0])
+		queue.push_back(edge.target);
+	for (size_t head = 0; head < queue.size(); ++head)
+	{
+		DWORD state = queue[head];
+		State& s = m_states[state];
+		if (last[state] != none)
+			m_outputs[last[state]].next = m_states[s.fail].output;
+		s.output = own[state] != none ? own[state] : m_states[s.fail].output;
+
+		for (const Edge& edge : children[state])
+		{
+			DWORD fail = s.fail;
+			DWORD target = child(fail, edge.byte);
+			while (target == none && fail != 0)
+			{
+				fail = m_states[fail].fail;
+				target = child(fail, edge.byte);
+			}
+			m_states[edge.target].fail = target == none ? 0 : target;
+			queue.push_back(edge.target);
+		}
+	}
+
+	// flattened, sorted transitions; the root gets a full table
+	for (DWORD state = 0; state < (DWORD)children.size(); ++state)
+	{
+		auto& edges = children[state];
+		std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.byte < b.byte; });
+		m_states[state].first = (DWORD)m_edges.size();
+		m_states[state].count = (DWORD)edges.size();
+		m_edges.insert(m_edges.end(), edges.begin(), edges.end());
+	}
+	for (const Edge& edge : children[0])
+	{
+		m_root[edge.byte] = edge.target;
+		m_lo[edge.byte & 0x0F] |= (BYTE)(1 << (edge.byte >> 4 & 7));
+		m_hi[edge.byte >> 4] = (BYTE)(1 << (edge.byte >> 4 & 7));
+	}
+	m_skip = !children[0].empty() && children[0].size() <= 128;
+}
+
+DWORD SignatureSet::next(DWORD state, BYTE b) const
+{
+	while (state != 0)
+	{
+		const State& s = m_states[state];
+		for (DWORD e = s.first; e < s.first + s.count; ++e)
+		{
+			if (m_edges[e].byte == b)
+				return m_edges[e].target;
+		}
+		state = s.fail;
+	}
+	return m_root[b];
+}
+
+bool SignatureSet::verify(const SignatureRule& rule, const BYTE* data, size_t size, size_t start) const
+{
+	size_t length = rule.value.size();
+	if (start > size || length > size - start)
+		return false;
+	for (size_t i = 0; i < length; ++i)
+	{
+		if ((data[start + i] & rule.mask[i]) != rule.value[i])
+			return false;
+	}
+	return true;
+}
+
+void SignatureSet::scan(const BYTE* data, size_t size, std::vector<SignatureHit>& hits) const
+{
+	static const SkipKernel kernel = selectKernel();
+
+	hits.clear();
+	if (m_states.empty())
+		return;
+
+	DWORD state = 0;
+	for (size_t i = 0; i < size; ++i)
+	{
+		if (state == 0)
+		{
+			if (m_skip)
+			{
+				i = kernel(data, i, size, m_lo, m_hi);
+				if (i >= size)
+					break;
+			}
+			state = m_root[data[i]];
+		}
+		else
+			state = next(state, data[i]);
+
+		// an anchor ending at i puts its pattern at i - (anchor + length - 1)
+		for (DWORD o = m_states[state].output; o != none; o = m_outputs[o].next)
+		{
+			const SignatureRule& rule = m_rules[m_outputs[o].rule];
+			size_t back = rule.anchor + rule.anchorLength - 1;
+			if (i >= back && verify(rule, data, size, i - back))
+				hits.push_back({ i - back, m_outputs[o].rule });
+		}
+	}
+
+	std::sort(hits.begin(), hits.end(), [](const SignatureHit& a, const SignatureHit& b) {
+		return a.offset != b.offset ? a.offset < b.offset : a.rule < b.rule;
+	});
+}
+
+SignatureSet::SkipKernel SignatureSet::selectKernel()
+{
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool ssse3 = (info[2] & (1 << 9)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	if (avx2)
+		return skipAVX2;
+	if (ssse3)
+		return skipSSSE3;
+	return skipScalar;
+}
+
+size_t SignatureSet::skipScalar(const BYTE* data, size_t pos, size_t size, const BYTE* lo, const BYTE* hi)
+{
+	while (pos < size && !(lo[data[pos] & 0x0F] & hi[data[pos] >> 4]))
+		++pos;
+	return pos;
+}
+
+// the high nibble picks one of 8 bits, the low nibble table holds that bit for every start byte
+size_t SignatureSet::skipSSSE3(const BYTE* data, size_t pos, size_t size, const BYTE* lo, const BYTE* hi)
+{
+	const __m128i loTable = _mm_loadu_si128((const __m128i*)lo);
+	const __m128i hiTable = _mm_loadu_si128((const __m128i*)hi);
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; pos + 16 <= size; pos += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(data + pos));
+		__m128i l = _mm_shuffle_epi8(loTable, _mm_and_si128(v, nibble));
+		__m128i h = _mm_shuffle_epi8(hiTable, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+		unsigned int found = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(l, h), zero)) & 0xFFFF;
+		if (found)
+		{
+			unsigned long index;
+			_BitScanForward(&index, found);
+			return pos + index;
+		}
+	}
+	return skipScalar(data, pos, size, lo, hi);
+}
+
+size_t SignatureSet::skipAVX2(const BYTE* data, size_t pos, size_t size, const BYTE* lo, const BYTE* hi)
+{
+	const __m256i loTable = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)lo));
+	const __m256i hiTable = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)hi));
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	const __m256i zero = _mm256_setzero_si256();
+
+	for (; pos + 32 <= size; pos += 32)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)(data + pos));
+		__m256i l = _mm256_shuffle_epi8(loTable, _mm256_and_si256(v, nibble));
+		__m256i h = _mm256_shuffle_epi8(hiTable, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+		unsigned int found = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(l, h), zero));
+		if (found)
+		{
+			unsigned long index;
+			_BitScanForward(&index, found);
+			return pos + index;
+		}
+	}
+	return skipSSSE3(data, pos, size, lo, hi);
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <Windows.h>
+
+/*
+| one line of a rule file : "<name> <scope> <bytes>"           |
+| scope is * (everywhere), entry (the first entryRegion bytes  |
+| from the entry point), overlay or section names, joined     |
+| with ','. bytes are hex pairs, ?? skips a byte and ? a       |
+| nibble; whitespace between the bytes is optional.            |
+| the anchor is the run of fixed bytes fed to the automaton,   |
+| the whole pattern is compared once the anchor matched.       |
+*/
+struct SignatureRule {
+	std::string name;
+	std::vector<BYTE> value;
+	std::vector<BYTE> mask;			// 0xFF fixed, 0xF0 / 0x0F a nibble, 0x00 any byte
+	std::vector<std::string> sections;
+	bool anywhere = false;
+	bool entry = false;
+	bool overlay = false;
+	DWORD anchor = 0;				// offset of the anchor in the pattern
+	DWORD anchorLength = 0;
+};
+
+// rule and offset from the start of the scanned data
+struct SignatureHit {
+	size_t offset;
+	DWORD rule;
+};
+
+// a hit placed in the file
+struct SignatureMatch {
+	ULONGLONG offset;
+	DWORD rva;				// 0 in the overlay
+	DWORD rule;
+	WORD section;
+
+	static constexpr WORD noSection = 0xFFFF;
+};
+
+/*
+| a rule file compiled once into an Aho-Corasick automaton.    |
+| every rule adds one anchor of at most maxAnchor fixed bytes, |
+| chosen to start on the byte that is rarest in PE files, so   |
+| the automaton sits in its root state most of the time. the   |
+| root is a full 256 entry table, the other states keep their  |
+| few transitions in one contiguous array next to a failure   |
+| link. from the root, a vector kernel (AVX2 or SSSE3, picked  |
+| once with cpuid) skips ahead to the next byte that starts an |
+| anchor with a nibble lookup. scan() is const, one set is     |
+| shared by every thread of a batch scan.                      |
+*/
+class SignatureSet
+{
+public:
+	static constexpr size_t maxAnchor = 8;
+	static constexpr DWORD entryRegion = 1024;
+	static constexpr DWORD none = 0xFFFFFFFF;
+
+public:
+	bool load(const std::string& path);
+	bool parse(std::string_view text);
+	const std::string& error() const { return m_error; }
+
+	size_t size() const { return m_rules.size(); }
+	const SignatureRule& rule(size_t index) const { return m_rules[index]; }
+	size_t longest() const { return m_longest; }		// bytes of the longest pattern
+
+	// every rule matching inside data, sorted by offset
+	void scan(const BYTE* data, size_t size, std::vector<SignatureHit>& hits) const;
+
+public:
+	typedef size_t (*SkipKernel)(const BYTE* data, size_t pos, size_t size, const BYTE* lo, const BYTE* hi);
+
+private:
+	bool parseLine(std::string_view line, size_t number);
+	void chooseAnchor(SignatureRule& rule);
+	void compile();
+	DWORD next(DWORD state, BYTE b) const;
+	bool verify(const SignatureRule& rule, const BYTE* data, size_t size, size_t start) const;
+
+	static SkipKernel selectKernel();
+	static size_t skipScalar(const BYTE* data, size_t pos, size_t size, const BYTE* lo, const BYTE* hi);
+	static size_t skipSSSE3(const BYTE* data, size_t pos, size_t size, const BYTE* lo, const BYTE* hi);
+	static size_t skipAVX2(const BYTE* data, size_t pos, size_t size, const BYTE* lo, const BYTE* hi);
+
+private:
+	struct State {
+		DWORD fail;
+		DWORD output;		// first entry of m_outputs, none if no anchor ends here
+		DWORD first;		// transitions [first, first + count) of m_edges
+		DWORD count;
+	};
+	struct Edge {
+		BYTE byte;
+		DWORD target;
+	};
+	struct Output {
+		DWORD rule;
+		DWORD next;			// the outputs of the failure state follow
+	};
+
+	std::vector<SignatureRule> m_rules;
+	std::vector<State> m_states;		// 0 is the root
+	std::vector<Edge> m_edges;
+	std::vector<Output> m_outputs;
+	DWORD m_root[256] = {};
+
+	// anchor start bytes as nibble tables : byte b may start one if lo[b & 15] & hi[b >> 4]
+	BYTE m_lo[16] = {};
+	BYTE m_hi[16] = {};
+	bool m_skip = false;				// off when too many bytes start an anchor to gain anything
+
+	size_t m_longest = 0;
+	std::string m_error;
+};
@@ -0,0 +1,77 @@
+#include "StringArena.h"
+#include <cstring>
+
+DWORD StringArena::hash(const char* str, size_t length)
+{
+	DWORD h = 2166136261u;
+	for (size_t i = 0; i < length; ++i)
+	{
+		h ^= (BYTE)str[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+char* StringArena::allocate(size_t size)
+{
+	if (size > blockSize / 4)
+	{
+		// long strings get a block of their own, the current block stays open
+		m_large.emplace_back(new char[size]);
+		return m_large.back().get();
+	}
+
+	if (m_used + size > blockSize)
+	{
+		m_blocks.emplace_back(new char[blockSize]);
+		m_used = 0;
+	}
+
+	char* p = m_blocks.back().get() + m_used;
+	m_used += size;
+	return p;
+}
+
+void StringArena::grow()
+{
+	std::vector<Slot> slots(m_slots.empty() ? 1024 : m_slots.size() * 2, Slot{ 0, 0, nullptr });
+	size_t mask = slots.size() - 1;
+	for (const Slot& s : m_slots)
+	{
+		if (!s.text)
+			continue;
+		size_t i = s.hash & mask;
+		while (slots[i].text)
+			i = (i + 1) & mask;
+		slots[i] = s;
+	}
+	m_slots.swap(slots);
+}
+
+std::string_view StringArena::intern(const char* str, size_t length)
+{
+	if (!length)
+		return std::string_view("", 0);
+
+	// keep the load factor at or below 1/2
+	if ((m_count + 1) * 2 > m_slots.size())
+		grow();
+
+	DWORD h = hash(str, length);
+	size_t mask = m_slots.size() - 1;
+	size_t i = h & mask;
+	for (; m_slots[i].text; i = (i + 1) & mask)
+	{
+		const Slot& s = m_slots[i];
+		if (s.hash == h && s.length == length && memcmp(s.text, str, length) == 0)
+			return std::string_view(s.text, length);
+	}
+
+	char* text = allocate(length + 1);
+	memcpy(text, str, length);
+	text[length] = '\0';
+
+	m_slots[i] = { h, (DWORD)length, text };
+	m_count++;
+	return std::string_view(text, length);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <Windows.h>
+
+/*
+| per-PEFile string storage for names that cannot point    |
+| into a mapped image (the ifstream fallback).             |
+| strings are copied into 64KB blocks that never move, so  |
+| the returned views stay valid as long as the arena, and  |
+| equal strings are stored once (DLL names repeat for      |
+| every import end marker, API names across DLLs).         |
+| every view is NUL terminated.                            |
+*/
+class StringArena
+{
+public:
+	std::string_view intern(const char* str, size_t length);
+	std::string_view intern(std::string_view str) { return intern(str.data(), str.size()); }
+
+	size_t size() const { return m_count; }
+
+	// FNV-1a, also used by the export name index
+	static DWORD hash(const char* str, size_t length);
+
+private:
+	char* allocate(size_t size);
+	void grow();
+
+private:
+	static constexpr size_t blockSize = 64 * 1024;
+
+	struct Slot {
+		DWORD hash;
+		DWORD length;
+		const char* text;		// nullptr is empty
+	};
+
+	std::vector<std::unique_ptr<char[]>> m_blocks;
+	std::vector<std::unique_ptr<char[]>> m_large;
+	size_t m_used = blockSize;		// bytes used in the last block
+	std::vector<Slot> m_slots;		// power of two, linear probing
+	size_t m_count = 0;
+};
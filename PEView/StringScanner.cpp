@@ -0,0 +1,264 @@
+#include "StringScanner.h"
+#include <algorithm>
+#include <thread>
+#include <intrin.h>
+#include <immintrin.h>
+
+// what strings(1) prints : 0x20 ~ 0x7E and tab
+static inline bool printable(BYTE c)
+{
+	return (c >= 0x20 && c < 0x7F) || c == '\t';
+}
+
+static inline bool wideAt(const BYTE* data, size_t size, size_t pos)
+{
+	return pos + 1 < size && printable(data[pos]) && data[pos + 1] == 0;
+}
+
+// mask is never 0, Win32 has no 64-bit bit scan
+static inline unsigned long lowestBit(ULONGLONG mask)
+{
+	unsigned long index;
+#ifdef _WIN64
+	_BitScanForward64(&index, mask);
+#else
+	if (_BitScanForward(&index, (DWORD)mask))
+		return index;
+	_BitScanForward(&index, (DWORD)(mask >> 32));
+	index += 32;
+#endif
+	return index;
+}
+
+void StringScanner::Scan(const BYTE* data, size_t size, size_t minLength, std::vector<StringHit>& hits, bool threads)
+{
+	hits.clear();
+	minLength = (std::max)(minLength, (size_t)1);
+
+	// runs close in the order they end, a wide run may end after the ASCII runs inside it
+	auto byOffset = [](const StringHit& a, const StringHit& b) {
+		return a.offset != b.offset ? a.offset < b.offset : a.wide < b.wide;
+	};
+
+	unsigned int workers = threads && size >= threadThreshold ? std::thread::hardware_concurrency() : 1;
+	if (workers <= 1)
+	{
+		scanSlice(data, size, 0, size, minLength, hits);
+		std::sort(hits.begin(), hits.end(), byOffset);
+		return;
+	}
+
+	// every hit starts inside the slice that found it, so the slices only need sorting on their own
+	std::vector<std::vector<StringHit>> partial(workers);
+	std::vector<std::thread> pool;
+	size_t slice = (size / workers + 63) & ~(size_t)63;
+	for (unsigned int t = 0; t < workers; ++t)
+	{
+		size_t begin = (std::min)(t * slice, size);
+		size_t end = t + 1 == workers ? size : (std::min)(begin + slice, size);
+		pool.emplace_back([&, t, begin, end] {
+			scanSlice(data, size, begin, end, minLength, partial[t]);
+			std::sort(partial[t].begin(), partial[t].end(), byOffset);
+		});
+	}
+	for (auto& thread : pool)
+		thread.join();
+
+	for (const auto& part : partial)
+		hits.insert(hits.end(), part.begin(), part.end());
+}
+
+void StringScanner::AppendText(const BYTE* data, const StringHit& hit, std::string& out)
+{
+	const char* text = (const char*)data + hit.offset;
+	if (!hit.wide)
+	{
+		out.append(text, hit.length);
+		return;
+	}
+	for (DWORD i = 0; i < hit.length; ++i)
+		out += text[i * 2];
+}
+
+void StringScanner::scanSlice(const BYTE* data, size_t size, size_t begin, size_t end, size_t minLength, std::vector<StringHit>& hits)
+{
+	static const ClassifyKernel kernel = selectKernel();
+
+	// start of the open ASCII run and of the open wide run of each byte parity,
+	// foreign marks a run that began in the slice before and is not reported here
+	const ULONGLONG none = ~0ull;
+	const ULONGLONG foreign = ~0ull - 1;
+	ULONGLONG ascii = none;
+	ULONGLONG wide[2] = { none, none };
+
+	// bit 0 : the byte before printable / bits 0, 1 : a wide character at -2, -1
+	ULONGLONG asciiCarry = 0, wideCarry = 0;
+	if (begin > 0)
+	{
+		asciiCarry = printable(data[begin - 1]);
+		wideCarry = (ULONGLONG)wideAt(data, size, begin - 2) | (ULONGLONG)wideAt(data, size, begin - 1) << 1;
+		if (asciiCarry)
+			ascii = foreign;
+		if (wideCarry & 1)
+			wide[0] = foreign;
+		if (wideCarry & 2)
+			wide[1] = foreign;
+	}
+
+	auto closeAscii = [&](ULONGLONG pos) {
+		if (ascii < end && pos - ascii >= minLength)
+			hits.push_back({ ascii, 0, 0, (DWORD)(pos - ascii), StringHit::noSection, false });
+		ascii = none;
+	};
+	auto closeWide = [&](int parity, ULONGLONG pos) {
+		ULONGLONG start = wide[parity];
+		if (start < end && (pos - start) / 2 >= minLength)
+			hits.push_back({ start, 0, 0, (DWORD)((pos - start) / 2), StringHit::noSection, true });
+		wide[parity] = none;
+	};
+
+	// one more mask than the block for the zero byte after its last byte
+	const size_t blockSize = 256;
+	ULONGLONG printableMask[blockSize + 1];
+	ULONGLONG zeroMask[blockSize + 1];
+
+	// begin is a multiple of 64, so bit i of a mask has the parity of i
+	for (size_t base = begin; ; )
+	{
+		// past the end only the runs still open are followed, one mask at a time
+		size_t count = base < end ? (std::min)(blockSize, (end - base + 63) / 64) : 1;
+
+		size_t whole = base < size ? (std::min)(count + 1, (size - base) / 64) : 0;
+		kernel(data + base, whole, printableMask, zeroMask);
+		for (size_t k = whole; k <= count; ++k)
+		{
+			// the tail of the data, nothing is printable past it
+			printableMask[k] = zeroMask[k] = 0;
+			for (size_t i = 0, pos = base + k * 64; i < 64 && pos + i < size; ++i)
+			{
+				printableMask[k] |= (ULONGLONG)printable(data[pos + i]) << i;
+				zeroMask[k] |= (ULONGLONG)(data[pos + i] == 0) << i;
+			}
+		}
+
+		for (size_t k = 0; k < count; ++k, base += 64)
+		{
+			ULONGLONG p = printableMask[k];
+			ULONGLONG w = p & ((zeroMask[k] >> 1) | (zeroMask[k + 1] << 63));
+
+			// edges : a start has no printable byte before it, an end is the first byte after a run
+			ULONGLONG before = (p << 1) | asciiCarry;
+			ULONGLONG starts = p & ~before;
+			ULONGLONG edges = starts | (~p & before);
+			asciiCarry = p >> 63;
+			while (edges)
+			{
+				unsigned long i = lowestBit(edges);
+				edges &= edges - 1;
+				if (starts >> i & 1)
+					ascii = base + i;
+				else
+					closeAscii(base + i);
+			}
+
+			// the same with a step of two bytes, each parity is its own run
+			before = (w << 2) | wideCarry;
+			starts = w & ~before;
+			edges = starts | (~w & before);
+			wideCarry = w >> 62;
+			while (edges)
+			{
+				unsigned long i = lowestBit(edges);
+				edges &= edges - 1;
+				if (starts >> i & 1)
+					wide[i & 1] = base + i;
+				else
+					closeWide(i & 1, base + i);
+			}
+		}
+
+		if (base >= end && ascii >= end && wide[0] >= end && wide[1] >= end)
+			break;
+	}
+}
+
+StringScanner::ClassifyKernel StringScanner::selectKernel()
+{
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	if (avx2)
+		return classifyAVX2;
+	if (sse2)
+		return classifySSE2;
+	return classifyScalar;
+}
+
+void StringScanner::classifyScalar(const BYTE* src, size_t blocks, ULONGLONG* printableMask, ULONGLONG* zeroMask)
+{
+	for (size_t k = 0; k < blocks; ++k, src += 64)
+	{
+		ULONGLONG p = 0, z = 0;
+		for (int i = 0; i < 64; ++i)
+		{
+			p |= (ULONGLONG)printable(src[i]) << i;
+			z |= (ULONGLONG)(src[i] == 0) << i;
+		}
+		printableMask[k] = p;
+		zeroMask[k] = z;
+	}
+}
+
+// signed compares : 0x80 ~ 0xFF are negative and fail the lower bound
+void StringScanner::classifySSE2(const BYTE* src, size_t blocks, ULONGLONG* printableMask, ULONGLONG* zeroMask)
+{
+	const __m128i low = _mm_set1_epi8(0x1F);
+	const __m128i high = _mm_set1_epi8(0x7F);
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i zero = _mm_setzero_si128();
+
+	for (size_t k = 0; k < blocks; ++k, src += 64)
+	{
+		ULONGLONG p = 0, z = 0;
+		for (int j = 0; j < 4; ++j)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(src + j * 16));
+			__m128i text = _mm_or_si128(_mm_and_si128(_mm_cmpgt_epi8(v, low), _mm_cmplt_epi8(v, high)), _mm_cmpeq_epi8(v, tab));
+			p |= (ULONGLONG)(unsigned int)_mm_movemask_epi8(text) << (j * 16);
+			z |= (ULONGLONG)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) << (j * 16);
+		}
+		printableMask[k] = p;
+		zeroMask[k] = z;
+	}
+}
+
+void StringScanner::classifyAVX2(const BYTE* src, size_t blocks, ULONGLONG* printableMask, ULONGLONG* zeroMask)
+{
+	const __m256i low = _mm256_set1_epi8(0x1F);
+	const __m256i high = _mm256_set1_epi8(0x7F);
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i zero = _mm256_setzero_si256();
+
+	for (size_t k = 0; k < blocks; ++k, src += 64)
+	{
+		__m256i a = _mm256_loadu_si256((const __m256i*)src);
+		__m256i b = _mm256_loadu_si256((const __m256i*)(src + 32));
+		__m256i textA = _mm256_or_si256(_mm256_and_si256(_mm256_cmpgt_epi8(a, low), _mm256_cmpgt_epi8(high, a)), _mm256_cmpeq_epi8(a, tab));
+		__m256i textB = _mm256_or_si256(_mm256_and_si256(_mm256_cmpgt_epi8(b, low), _mm256_cmpgt_epi8(high, b)), _mm256_cmpeq_epi8(b, tab));
+		printableMask[k] = (ULONGLONG)(unsigned int)_mm256_movemask_epi8(textA) | (ULONGLONG)(unsigned int)_mm256_movemask_epi8(textB) << 32;
+		zeroMask[k] = (ULONGLONG)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, zero)) | (ULONGLONG)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(b, zero)) << 32;
+	}
+}
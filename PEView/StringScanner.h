@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <Windows.h>
+
+/*
+| offset	8byte	|	of the first character
+| text		8byte	|	start in the owner's text buffer
+| rva		4byte	|	0 outside the sections
+| length	4byte	|	characters, not bytes
+| section	2byte	|	index into the section headers
+| wide		1byte	|	UTF-16LE
+*/
+struct StringHit {
+	ULONGLONG offset;
+	size_t text;
+	DWORD rva;
+	DWORD length;
+	WORD section;
+	bool wide;
+
+	static constexpr WORD noSection = 0xFFFF;		// the overlay
+};
+
+/*
+| ASCII and UTF-16LE string extraction like strings(1).      |
+| every 64 bytes are classified by a vector kernel (AVX2 or  |
+| SSE2, picked once with cpuid) into a printable mask and a  |
+| zero mask; a UTF-16 character is a printable byte followed |
+| by a zero byte. runs are then found from the edges of the  |
+| masks with bit scans, so the bytes are never looked at one |
+| by one. large ranges are split across threads on 64-byte  |
+| boundaries, a thread finishes the runs that cross the end  |
+| of its slice and skips the ones that enter its start.      |
+| only Scan() fills offset (relative to data), length and    |
+| wide, the rest is left to the caller.                      |
+*/
+class StringScanner
+{
+public:
+	static constexpr size_t defaultMinLength = 4;
+	static constexpr size_t threadThreshold = 4 << 20;		// smaller ranges stay on the caller's thread
+
+	static void Scan(const BYTE* data, size_t size, size_t minLength, std::vector<StringHit>& hits, bool threads = true);
+	// the characters of a hit as ASCII, data is what was passed to Scan()
+	static void AppendText(const BYTE* data, const StringHit& hit, std::string& out);
+
+public:
+	typedef void (*ClassifyKernel)(const BYTE* src, size_t blocks, ULONGLONG* printable, ULONGLONG* zero);
+
+private:
+	static ClassifyKernel selectKernel();
+	static void classifyScalar(const BYTE* src, size_t blocks, ULONGLONG* printable, ULONGLONG* zero);
+	static void classifySSE2(const BYTE* src, size_t blocks, ULONGLONG* printable, ULONGLONG* zero);
+	static void classifyAVX2(const BYTE* src, size_t blocks, ULONGLONG* printable, ULONGLONG* zero);
+
+	static void scanSlice(const BYTE* data, size_t size, size_t begin, size_t end, size_t minLength, std::vector<StringHit>& hits);
+};
@@ -0,0 +1,112 @@
+#include "SymbolIndex.h"
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+// the index is line and tab separated, a path from a broken record must not add either
+static std::string sanitize(std::string_view text)
+{
+	std::string out(text);
+	for (char& c : out)
+	{
+		if ((unsigned char)c < 0x20)
+			c = '?';
+	}
+	return out;
+}
+
+void SymbolIndex::add(const CodeViewInfo& info, std::string_view file)
+{
+	char key[DebugDirectory::keySize];
+	DebugDirectory::FormatKey(key, info);
+
+	Entry entry = { key, sanitize(info.path), sanitize(file) };
+	std::lock_guard<std::mutex> guard(m_lock);
+	m_entries.push_back(std::move(entry));
+}
+
+bool SymbolIndex::write(const std::string& path)
+{
+	std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {
+		return a.key != b.key ? a.key < b.key : a.file < b.file;
+	});
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+		return false;
+
+	std::string line;
+	for (const Entry& entry : m_entries)
+	{
+		line.clear();
+		line += entry.key;
+		line += '\t';
+		line += entry.pdb;
+		line += '\t';
+		line += entry.file;
+		line += '\n';
+		out.write(line.data(), line.size());
+	}
+	return out.good();
+}
+
+bool SymbolIndex::open(const std::string& path)
+{
+	m_lines.clear();
+	if (!m_index.open(path))
+		return false;
+
+	const char* data = (const char*)m_index.data();
+	size_t size = (size_t)m_index.size();
+	for (size_t pos = 0; pos < size; )
+	{
+		m_lines.push_back(pos);
+		const char* end = (const char*)memchr(data + pos, '\n', size - pos);
+		pos = end ? end - data + 1 : size;
+	}
+	return true;
+}
+
+std::string_view SymbolIndex::keyOf(size_t line) const
+{
+	const char* data = (const char*)m_index.data();
+	size_t begin = m_lines[line];
+	size_t end = line + 1 < m_lines.size() ? m_lines[line + 1] : (size_t)m_index.size();
+	std::string_view text(data + begin, end - begin);
+	return text.substr(0, text.find_first_of("\t\n"));
+}
+
+size_t SymbolIndex::find(std::string_view key, std::vector<SymbolMatch>& matches) const
+{
+	matches.clear();
+
+	// lines are sorted by key, equal keys are adjacent
+	size_t first = 0, count = m_lines.size();
+	while (count > 0)
+	{
+		size_t half = count / 2;
+		if (keyOf(first + half) < key)
+		{
+			first += half + 1;
+			count -= half + 1;
+		}
+		else
+			count = half;
+	}
+
+	const char* data = (const char*)m_index.data();
+	for (size_t line = first; line < m_lines.size() && keyOf(line) == key; ++line)
+	{
+		size_t end = line + 1 < m_lines.size() ? m_lines[line + 1] : (size_t)m_index.size();
+		std::string_view text(data + m_lines[line], end - m_lines[line]);
+		if (!text.empty() && text.back() == '\n')
+			text.remove_suffix(1);
+
+		size_t pdb = text.find('\t');
+		size_t file = text.find('\t', pdb + 1);
+		if (file == std::string_view::npos)
+			continue;
+		matches.push_back({ text.substr(pdb + 1, file - pdb - 1), text.substr(file + 1) });
+	}
+	return matches.size();
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <Windows.h>
+#include "MappedFile.h"
+#include "DebugDirectory.h"
+
+// one line of an index, views into the mapping
+struct SymbolMatch {
+	std::string_view pdb;
+	std::string_view file;
+};
+
+/*
+| PDB identity -> file table built by a batch scan.        |
+| workers add() the CodeView record of every file, write() |
+| sorts by symbol server key and saves one line per file : |
+| "key\tpdb path\tfile path". a saved index is mapped and  |
+| binary searched in place, so matching a PDB to its       |
+| binaries never opens the binaries again.                 |
+*/
+class SymbolIndex
+{
+public:
+	// collecting, add() may be called from any thread
+	void add(const CodeViewInfo& info, std::string_view file);
+	size_t size() const { return m_entries.size(); }
+	bool write(const std::string& path);
+
+	// searching a written index, key is upper case
+	bool open(const std::string& path);
+	size_t find(std::string_view key, std::vector<SymbolMatch>& matches) const;
+
+private:
+	std::string_view keyOf(size_t line) const;
+
+private:
+	struct Entry {
+		std::string key;
+		std::string pdb;
+		std::string file;
+	};
+
+	std::mutex m_lock;
+	std::vector<Entry> m_entries;
+
+	MappedFile m_index;
+	std::vector<size_t> m_lines;		// offset of every line of the mapped index
+};
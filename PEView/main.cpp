@@ -1,7 +1,207 @@
 #include "PEFile.h"
+#include "BatchScanner.h"
+#include "SymbolIndex.h"
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+// a decimal count in [1, limit] for an option, anything else is reported and rejected
+static bool parseCount(const std::string& option, const char* text, unsigned long long limit, unsigned long long& value)
+{
+	char* end = nullptr;
+	errno = 0;
+	value = 0;
+	if (*text >= '0' && *text <= '9')
+		value = std::strtoull(text, &end, 10);
+	if (end && *end == '\0' && errno == 0 && value >= 1 && value <= limit)
+		return true;
+
+	std::cerr << option << " " << text << " : 1 ̻ " << limit << "  10 Էϼ." << std::endl;
+	return false;
+}
 
 int main(int argc, char* argv[])
 {
+	// PEView -batch [-j threads] [-headers] [-json] [-hash] [-authenticode] [-strings length] [-rules file] [-fingerprint] [-rich] [-overlay] [-symindex file] [-cache dir [-cache-size MB] [-cache-content]] [-list file|-] <dir|file> ...
+	if (argc >= 3 && std::string(argv[1]) == "-batch")
+	{
+		BatchOptions options;
+		unsigned long long value;
+		for (int i = 2; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			if (arg == "-j" && i + 1 < argc)
+			{
+				// one work queue per thread
+				if (!parseCount(arg, argv[++i], 1024, value))
+					return 1;
+				options.threads = (unsigned int)value;
+			}
+			else if (arg == "-headers")
+				options.headersOnly = true;
+			else if (arg == "-json")
+				options.json = true;
+			else if (arg == "-hash")
+				options.hash = true;
+			else if (arg == "-authenticode")
+				options.authenticode = true;
+			else if (arg == "-strings" && i + 1 < argc)
+			{
+				if (!parseCount(arg, argv[++i], 4096, value))
+					return 1;
+				options.strings = (size_t)value;
+			}
+			else if (arg == "-rules" && i + 1 < argc)
+				options.rules = argv[++i];
+			else if (arg == "-fingerprint")
+				options.fingerprint = true;
+			else if (arg == "-rich")
+				options.rich = true;
+			else if (arg == "-overlay")
+				options.overlay = true;
+			else if (arg == "-list" && i + 1 < argc)
+				options.list = argv[++i];
+			else if (arg == "-symindex" && i + 1 < argc)
+				options.symbolIndex = argv[++i];
+			else if (arg == "-cache" && i + 1 < argc)
+				options.cacheDir = argv[++i];
+			else if (arg == "-cache-size" && i + 1 < argc)
+			{
+				if (!parseCount(arg, argv[++i], 1ull << 20, value))
+					return 1;
+				options.cacheLimit = value << 20;
+			}
+			else if (arg == "-cache-content")
+				options.cacheContent = true;
+			else
+				options.roots.push_back(arg);
+		}
+
+		BatchScanner scanner(options);
+		return scanner.Run();
+	}
+
+	// PEView -bench [-n iterations] <file>
+	if (argc >= 3 && std::string(argv[1]) == "-bench")
+	{
+		int iterations = 10;
+		unsigned long long value;
+		std::string filePath;
+		for (int i = 2; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			if (arg == "-n" && i + 1 < argc)
+			{
+				if (!parseCount(arg, argv[++i], 1000000, value))
+					return 1;
+				iterations = (int)value;
+			}
+			else
+				filePath = arg;
+		}
+
+		PEFile pe(filePath);
+		if (!pe.loaded)
+			return 1;
+
+		return pe.Benchmark(iterations) ? 0 : 1;
+	}
+
+	// PEView -symbols <index> <key|file> ...
+	if (argc >= 4 && std::string(argv[1]) == "-symbols")
+	{
+		SymbolIndex index;
+		if (!index.open(argv[2]))
+		{
+			std::cerr << argv[2] << " : ɺ ε   ϴ." << std::endl;
+			return 1;
+		}
+
+		std::vector<SymbolMatch> matches;
+		for (int i = 3; i < argc; ++i)
+		{
+			// a PE file is looked up by its own CodeView record, anything else is a key
+			std::string key = argv[i];
+			if (std::ifstream(key).is_open())
+			{
+				PEFile pe(key, false);
+				CodeViewInfo info;
+				if (!pe.loaded || !pe.GetCodeView(info))
+				{
+					std::cerr << key << " : CodeView  ϴ." << std::endl;
+					continue;
+				}
+				char text[DebugDirectory::keySize];
+				DebugDirectory::FormatKey(text, info);
+				key = text;
+			}
+			std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return std::toupper(c); });
+
+			if (!index.find(key, matches))
+				std::cout << key << "\t-" << std::endl;
+			for (const auto& match : matches)
+				std::cout << key << '\t' << match.pdb << '\t' << match.file << std::endl;
+		}
+		return 0;
+	}
+
+	// PEView -run [-c "commands"] [-s script] [-cache dir] <file> ...
+	if (argc >= 3 && std::string(argv[1]) == "-run")
+	{
+		std::vector<std::string> script;
+		std::vector<std::string> files;
+		std::unique_ptr<ParseCache> cache;
+		for (int i = 2; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			if (arg == "-cache" && i + 1 < argc)
+				cache.reset(new ParseCache(argv[++i], 256ull << 20, false));
+			else if (arg == "-c" && i + 1 < argc)
+			{
+				for (auto& command : PEFile::SplitCommands(argv[++i]))
+					script.push_back(command);
+			}
+			else if (arg == "-s" && i + 1 < argc)
+			{
+				// one command per line, '#' starts a comment line
+				std::ifstream in(argv[++i]);
+				if (!in.is_open())
+				{
+					std::cerr << argv[i] << " : ũƮ    ϴ." << std::endl;
+					return 1;
+				}
+				std::string line;
+				while (std::getline(in, line))
+				{
+					size_t begin = line.find_first_not_of(" \t\r");
+					if (begin != std::string::npos && line[begin] != '#')
+						script.push_back(line);
+				}
+			}
+			else
+				files.push_back(arg);
+		}
+
+		// each file is parsed once, every command of the script runs on the same PEFile
+		int status = 0;
+		for (const auto& path : files)
+		{
+			if (files.size() > 1)
+				std::cout << "== " << path << " ==" << std::endl;
+
+			PEFile pe(path, true, cache.get());
+			if (!pe.loaded)
+			{
+				status = 1;
+				continue;
+			}
+			pe.RunScript(script);
+		}
+		return status;
+	}
+
 	if (argc != 2)
 		return 0;
 
@@ -13,4 +213,4 @@ int main(int argc, char* argv[])
 	pe.Run();
 
 	return 0;
-}
\ No newline at end of file
+}